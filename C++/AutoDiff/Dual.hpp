@@ -0,0 +1,276 @@
+/**
+* @file Dual.hpp
+* @brief Números duais para diferenciação automática no modo direto
+*/
+
+/*
+	* Um número dual carrega um valor e Lanes derivadas direcionais:
+		x = value + sum(derivative[k] * e_k)
+	e cada operação aplica a regra da cadeia a todas as derivadas de uma vez.
+	Avaliando uma função escrita em template no tipo do escalar (como os
+	sistemas de BenchmarkPrecision.cpp) com Dual<Lanes>, obtém-se Lanes
+	colunas da matriz Jacobiana por avaliação, exatas a menos de
+	arredondamento (ver Jacobian.hpp).
+
+	* As derivadas ficam em um vetor de tamanho fixo, alinhado a 32 bytes: os
+	laços sobre as derivadas têm quantidade constante de iterações e são
+	convertidos pelo compilador em instruções AVX2 (4 doubles por
+	instrução), de modo que Lanes = 4, 8 ou 16 utilizam 1, 2 ou 4
+	registradores.
+
+	* Funções matemáticas: sqrt, exp, log, sin, cos, tan, tanh, atan, abs e
+	pow. Para que o mesmo código funcione com double e com Dual, as chamadas
+	devem ser feitas sem qualificação, precedidas de "using std::sqrt;" (e
+	semelhantes), de modo que a versão de AutoDiff seja encontrada pelo
+	argumento. Comparações utilizam apenas o valor.
+
+	* Por se tratar de templates, toda a implementação está neste arquivo.
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+namespace AutoDiff {
+	/**
+	* @brief Número dual com Lanes derivadas.
+	*/
+	template <std::size_t Lanes>
+	struct Dual {
+		static_assert(Lanes > 0, "Dual precisa de ao menos uma derivada.");
+
+		double value;
+		alignas(32) double derivative[Lanes];
+
+		/**
+		* @brief Constante: derivadas nulas.
+		* @param[in] constant Valor (entrada)
+		*/
+		Dual(double constant = 0.0) : value(constant)
+		{
+			for (std::size_t k = 0; k < Lanes; k++)
+				derivative[k] = 0.0;
+		}
+
+		/**
+		* @brief Variável independente: derivada unitária na direção lane.
+		* @param[in] variable Valor (entrada)
+		* @param[in] lane Direção (entrada)
+		*/
+		static Dual Variable(double variable, std::size_t lane)
+		{
+			Dual result(variable);
+			result.derivative[lane] = 1.0;
+			return result;
+		}
+
+		Dual& operator+=(const Dual& other)
+		{
+			value += other.value;
+			for (std::size_t k = 0; k < Lanes; k++)
+				derivative[k] += other.derivative[k];
+			return *this;
+		}
+
+		Dual& operator-=(const Dual& other)
+		{
+			value -= other.value;
+			for (std::size_t k = 0; k < Lanes; k++)
+				derivative[k] -= other.derivative[k];
+			return *this;
+		}
+
+		Dual& operator*=(const Dual& other)
+		{
+			for (std::size_t k = 0; k < Lanes; k++)
+				derivative[k] = derivative[k] * other.value + value * other.derivative[k];
+			value *= other.value;
+			return *this;
+		}
+
+		Dual& operator/=(const Dual& other)
+		{
+			double inverse = 1.0 / other.value;
+			value *= inverse;
+			for (std::size_t k = 0; k < Lanes; k++)
+				derivative[k] = (derivative[k] - value * other.derivative[k]) * inverse;
+			return *this;
+		}
+
+		Dual& operator+=(double other)
+		{
+			value += other;
+			return *this;
+		}
+
+		Dual& operator-=(double other)
+		{
+			value -= other;
+			return *this;
+		}
+
+		Dual& operator*=(double other)
+		{
+			value *= other;
+			for (std::size_t k = 0; k < Lanes; k++)
+				derivative[k] *= other;
+			return *this;
+		}
+
+		Dual& operator/=(double other)
+		{
+			return *this *= 1.0 / other;
+		}
+
+		/*
+			Operadores como funções amigas definidas na classe: são
+			encontrados pelo argumento e aceitam conversões (por exemplo,
+			1 - x com x dual).
+		*/
+		friend Dual operator+(const Dual& a) { return a; }
+
+		friend Dual operator-(const Dual& a)
+		{
+			Dual result;
+			result.value = -a.value;
+			for (std::size_t k = 0; k < Lanes; k++)
+				result.derivative[k] = -a.derivative[k];
+			return result;
+		}
+
+		friend Dual operator+(Dual a, const Dual& b) { return a += b; }
+		friend Dual operator-(Dual a, const Dual& b) { return a -= b; }
+		friend Dual operator*(Dual a, const Dual& b) { return a *= b; }
+		friend Dual operator/(Dual a, const Dual& b) { return a /= b; }
+
+		friend Dual operator+(Dual a, double b) { return a += b; }
+		friend Dual operator-(Dual a, double b) { return a -= b; }
+		friend Dual operator*(Dual a, double b) { return a *= b; }
+		friend Dual operator/(Dual a, double b) { return a /= b; }
+
+		friend Dual operator+(double a, Dual b) { return b += a; }
+		friend Dual operator*(double a, Dual b) { return b *= a; }
+
+		friend Dual operator-(double a, const Dual& b)
+		{
+			Dual result = -b;
+			result.value += a;
+			return result;
+		}
+
+		friend Dual operator/(double a, const Dual& b)
+		{
+			Dual result;
+			result.value = a / b.value;
+			double factor = -result.value / b.value;
+			for (std::size_t k = 0; k < Lanes; k++)
+				result.derivative[k] = factor * b.derivative[k];
+			return result;
+		}
+
+		friend bool operator<(const Dual& a, const Dual& b) { return a.value < b.value; }
+		friend bool operator>(const Dual& a, const Dual& b) { return a.value > b.value; }
+		friend bool operator<=(const Dual& a, const Dual& b) { return a.value <= b.value; }
+		friend bool operator>=(const Dual& a, const Dual& b) { return a.value >= b.value; }
+		friend bool operator==(const Dual& a, const Dual& b) { return a.value == b.value; }
+		friend bool operator!=(const Dual& a, const Dual& b) { return a.value != b.value; }
+	};
+
+	/*
+		Regra da cadeia para f(a): valor f(a.value) e derivadas multiplicadas
+		por f'(a.value).
+	*/
+	template <std::size_t Lanes>
+	Dual<Lanes> Chain(const Dual<Lanes>& a, double value, double slope)
+	{
+		Dual<Lanes> result;
+		result.value = value;
+		for (std::size_t k = 0; k < Lanes; k++)
+			result.derivative[k] = slope * a.derivative[k];
+		return result;
+	}
+
+	template <std::size_t Lanes>
+	Dual<Lanes> sqrt(const Dual<Lanes>& a)
+	{
+		double root = std::sqrt(a.value);
+		return Chain(a, root, 0.5 / root);
+	}
+
+	template <std::size_t Lanes>
+	Dual<Lanes> exp(const Dual<Lanes>& a)
+	{
+		double exponential = std::exp(a.value);
+		return Chain(a, exponential, exponential);
+	}
+
+	template <std::size_t Lanes>
+	Dual<Lanes> log(const Dual<Lanes>& a)
+	{
+		return Chain(a, std::log(a.value), 1.0 / a.value);
+	}
+
+	template <std::size_t Lanes>
+	Dual<Lanes> sin(const Dual<Lanes>& a)
+	{
+		return Chain(a, std::sin(a.value), std::cos(a.value));
+	}
+
+	template <std::size_t Lanes>
+	Dual<Lanes> cos(const Dual<Lanes>& a)
+	{
+		return Chain(a, std::cos(a.value), -std::sin(a.value));
+	}
+
+	template <std::size_t Lanes>
+	Dual<Lanes> tan(const Dual<Lanes>& a)
+	{
+		double tangent = std::tan(a.value);
+		return Chain(a, tangent, 1.0 + tangent * tangent);
+	}
+
+	template <std::size_t Lanes>
+	Dual<Lanes> tanh(const Dual<Lanes>& a)
+	{
+		double hyperbolic = std::tanh(a.value);
+		return Chain(a, hyperbolic, 1.0 - hyperbolic * hyperbolic);
+	}
+
+	template <std::size_t Lanes>
+	Dual<Lanes> atan(const Dual<Lanes>& a)
+	{
+		return Chain(a, std::atan(a.value), 1.0 / (1.0 + a.value * a.value));
+	}
+
+	template <std::size_t Lanes>
+	Dual<Lanes> abs(const Dual<Lanes>& a)
+	{
+		return (a.value < 0.0) ? -a : a;
+	}
+
+	template <std::size_t Lanes>
+	Dual<Lanes> pow(const Dual<Lanes>& a, double exponent)
+	{
+		// a^0 = 1 em qualquer ponto, inclusive a = 0, com derivada nula
+		if (exponent == 0.0)
+			return Chain(a, 1.0, 0.0);
+		return Chain(a, std::pow(a.value, exponent), exponent * std::pow(a.value, exponent - 1.0));
+	}
+
+	template <std::size_t Lanes>
+	Dual<Lanes> pow(const Dual<Lanes>& a, const Dual<Lanes>& exponent)
+	{
+		/*
+			Expoente sem derivadas (constante ou parâmetro não semeado): a
+			versão com expoente double vale também para a <= 0, onde log(a)
+			não existe.
+		*/
+		bool constantExponent = true;
+		for (std::size_t k = 0; k < Lanes; k++)
+			constantExponent = constantExponent && (exponent.derivative[k] == 0.0);
+		if (constantExponent)
+			return pow(a, exponent.value);
+		return exp(exponent * log(a));
+	}
+}
@@ -0,0 +1,129 @@
+/**
+* @file Jacobian.hpp
+* @brief Matriz Jacobiana por diferenciação automática no modo direto
+*/
+
+/*
+	* A matriz Jacobiana J[i][j] = d(dudt_i)/du_j de um sistema com N equações
+	é obtida em ceil(N / Lanes) avaliações de dynFun com Dual<Lanes>: em cada
+	passagem, Lanes variáveis de u recebem derivada unitária e as derivadas de
+	dudt formam Lanes colunas de J. Não há erro de truncamento, ao contrário
+	de diferenças finitas (N avaliações adicionais com double).
+
+	* dynFun deve ser um objeto (ou lambda genérica) com operator() em
+	template no tipo do escalar, como os sistemas de BenchmarkPrecision.cpp:
+		template <typename Scalar, typename Precision>
+		void operator()(Precision t, std::vector<Scalar>& u, std::vector<Scalar>& dudt) const;
+
+	* Por se tratar de templates, toda a implementação está neste arquivo.
+*/
+
+#pragma once
+
+#include "Dual.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace AutoDiff {
+	/**
+	* @brief Avaliador da matriz Jacobiana, com os vetores duais alocados uma
+	* única vez.
+	*/
+	template <std::size_t Lanes>
+	class JacobianEvaluator {
+	public:
+		/**
+		* @brief Construtor
+		* @param[in] systemSize Quantidade de equações do sistema (entrada)
+		*/
+		explicit JacobianEvaluator(std::size_t systemSize) :
+			uDual(systemSize), dudtDual(systemSize)
+		{
+		}
+
+		/**
+		* @brief Quantidade de avaliações de dynFun por Jacobiana.
+		*/
+		std::size_t Passes() const
+		{
+			return (uDual.size() + Lanes - 1) / Lanes;
+		}
+
+		/**
+		* @brief Calcula a matriz Jacobiana de dynFun em (t, u).
+		* @param[in] dynFun Sistema, em template no tipo do escalar (entrada)
+		* @param[in] t Valor de t (entrada)
+		* @param[in] u Valores de u (entrada)
+		* @param[out] jacobian Matriz N x N, por linhas:
+		* jacobian[i * N + j] = d(dudt_i)/du_j (saída)
+		* @param[out] dudt Se não for nulo, recebe dynFun(t, u) (saída)
+		*/
+		template <typename DynamicFunction>
+		void Evaluate(
+			DynamicFunction& dynFun,
+			double t,
+			const std::vector<double>& u,
+			std::vector<double>& jacobian,
+			std::vector<double>* dudt = nullptr)
+		{
+			/*
+				Os vetores duais só são realocados se u tiver tamanho diferente
+				do informado no construtor.
+			*/
+			std::size_t uSize = u.size();
+			if (uDual.size() != uSize) {
+				uDual.resize(uSize);
+				dudtDual.resize(uSize);
+			}
+			jacobian.resize(uSize * uSize);
+			for (std::size_t j = 0; j < uSize; j++)
+				uDual[j] = Dual<Lanes>(u[j]);
+
+			for (std::size_t first = 0; first < uSize; first += Lanes) {
+				std::size_t lanes = (uSize - first < Lanes) ? uSize - first : Lanes;
+				for (std::size_t lane = 0; lane < lanes; lane++)
+					uDual[first + lane].derivative[lane] = 1.0;
+
+				dynFun(t, uDual, dudtDual);
+
+				for (std::size_t i = 0; i < uSize; i++) {
+					double* row = jacobian.data() + i * uSize + first;
+					for (std::size_t lane = 0; lane < lanes; lane++)
+						row[lane] = dudtDual[i].derivative[lane];
+				}
+
+				for (std::size_t lane = 0; lane < lanes; lane++)
+					uDual[first + lane].derivative[lane] = 0.0;
+			}
+
+			if (dudt != nullptr) {
+				dudt->resize(uSize);
+				for (std::size_t i = 0; i < uSize; i++)
+					(*dudt)[i] = dudtDual[i].value;
+			}
+		}
+
+	private:
+		std::vector<Dual<Lanes>> uDual;
+		std::vector<Dual<Lanes>> dudtDual;
+	};
+
+	/**
+	* @brief Calcula a matriz Jacobiana de dynFun em (t, u) (ver
+	* JacobianEvaluator::Evaluate).
+	* @param[in] dynFun Sistema, em template no tipo do escalar (entrada)
+	* @param[in] t Valor de t (entrada)
+	* @param[in] u Valores de u (entrada)
+	* @param[out] jacobian Matriz N x N, por linhas (saída)
+	*/
+	template <std::size_t Lanes = 4, typename DynamicFunction>
+	void Jacobian(
+		DynamicFunction& dynFun,
+		double t,
+		const std::vector<double>& u,
+		std::vector<double>& jacobian)
+	{
+		JacobianEvaluator<Lanes> evaluator(u.size());
+		evaluator.Evaluate(dynFun, t, u, jacobian);
+	}
+}
@@ -0,0 +1,99 @@
+/**
+* @file BoundedQueue.hpp
+* @brief Fila de capacidade limitada entre threads
+*/
+
+/*
+	* Push bloqueia enquanto a fila estiver cheia: quem produz os itens
+	(a leitura do arquivo de tarefas) não avança mais que capacity itens à
+	frente de quem os consome, e a memória utilizada não depende do tamanho
+	da entrada.
+
+	* Por se tratar de um template, toda a implementação está neste arquivo.
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace Batch {
+	/**
+	* @brief Fila com capacidade limitada, para vários produtores e
+	* consumidores.
+	*/
+	template <typename T>
+	class BoundedQueue {
+	public:
+		/**
+		* @brief Construtor
+		* @param[in] capacity Quantidade máxima de itens na fila (entrada)
+		*/
+		explicit BoundedQueue(std::size_t capacity) :
+			capacity((capacity > 0) ? capacity : 1)
+		{
+		}
+
+		/**
+		* @brief Insere item, aguardando enquanto a fila estiver cheia e
+		* aberta.
+		* @param[in] item Item inserido (entrada)
+		* @return false se a fila foi fechada, caso em que item é descartado
+		*/
+		bool Push(T&& item)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			notFull.wait(lock, [&]() { return closed || items.size() < capacity; });
+			if (closed)
+				return false;
+			items.push_back(std::move(item));
+			lock.unlock();
+			notEmpty.notify_one();
+			return true;
+		}
+
+		/**
+		* @brief Remove o item mais antigo, aguardando enquanto a fila estiver
+		* vazia e aberta.
+		* @param[out] item Item removido (saída)
+		* @return false se a fila estiver fechada e vazia
+		*/
+		bool Pop(T& item)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			notEmpty.wait(lock, [&]() { return closed || !items.empty(); });
+			if (items.empty())
+				return false;
+			item = std::move(items.front());
+			items.pop_front();
+			lock.unlock();
+			notFull.notify_one();
+			return true;
+		}
+
+		/**
+		* @brief Indica que não haverá novos itens; Pop retorna false depois
+		* que os restantes forem removidos, e Push retorna false (também
+		* quando aguardava espaço).
+		*/
+		void Close()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				closed = true;
+			}
+			notEmpty.notify_all();
+			notFull.notify_all();
+		}
+
+	private:
+		std::size_t capacity;
+		std::deque<T> items;
+		std::mutex mutex;
+		std::condition_variable notEmpty, notFull;
+		bool closed = false;
+	};
+}
@@ -0,0 +1,325 @@
+/**
+* @file Jobs.cpp
+* @brief Tarefas de integração do executável batch: leitura, execução e saída
+*/
+
+#include "Jobs.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+namespace {
+	/*
+		Converte text inteiro em número, retornando false se sobrar texto
+		ou se o número não for finito (nan, inf).
+	*/
+	bool ParseNumber(const std::string& text, double& value) {
+		if (text.empty())
+			return false;
+		char* end;
+		value = std::strtod(text.c_str(), &end);
+		return *end == '\0' && std::isfinite(value);
+	}
+
+	bool ParseList(const std::string& text, std::vector<double>& values) {
+		values.clear();
+		std::size_t begin = 0;
+		while (true) {
+			std::size_t comma = text.find(',', begin);
+			double value;
+			if (!ParseNumber(text.substr(begin, comma - begin), value))
+				return false;
+			values.push_back(value);
+			if (comma == std::string::npos)
+				return true;
+			begin = comma + 1;
+		}
+	}
+
+	void AppendNumber(std::string& buffer, double value) {
+		char text[32];
+		std::snprintf(text, sizeof(text), "%.17g", value);
+		buffer += text;
+	}
+
+	template <typename T>
+	void AppendBytes(std::string& buffer, const T& value) {
+		buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+}
+
+const std::map<std::string, Batch::BuiltInSystem>& Batch::BuiltInSystems()
+{
+	static const std::map<std::string, BuiltInSystem> systems = {
+		{ "blasius", { 3, { -1.0 / 2.0 },
+			[](double t, std::vector<double>& u, const std::vector<double>& p, std::vector<double>& dudt) {
+				dudt[0] = u[1];
+				dudt[1] = u[2];
+				dudt[2] = p[0] * u[0] * u[2];
+			} } },
+		{ "lorenz", { 3, { 10.0, 28.0, 8.0 / 3.0 },
+			[](double t, std::vector<double>& u, const std::vector<double>& p, std::vector<double>& dudt) {
+				dudt[0] = p[0] * (u[1] - u[0]);
+				dudt[1] = u[0] * (p[1] - u[2]) - u[1];
+				dudt[2] = u[0] * u[1] - p[2] * u[2];
+			} } },
+		{ "vanderpol", { 2, { 10.0 },
+			[](double t, std::vector<double>& u, const std::vector<double>& p, std::vector<double>& dudt) {
+				dudt[0] = u[1];
+				dudt[1] = p[0] * (1.0 - u[0] * u[0]) * u[1] - u[0];
+			} } },
+		{ "arenstorf", { 4, { 0.012277471 },
+			[](double t, std::vector<double>& u, const std::vector<double>& p, std::vector<double>& dudt) {
+				const double mu = p[0], mu2 = 1.0 - mu;
+				double d1 = std::pow((u[0] + mu) * (u[0] + mu) + u[1] * u[1], 1.5);
+				double d2 = std::pow((u[0] - mu2) * (u[0] - mu2) + u[1] * u[1], 1.5);
+				dudt[0] = u[2];
+				dudt[1] = u[3];
+				dudt[2] = u[0] + 2.0 * u[3] - mu2 * (u[0] + mu) / d1 - mu * (u[0] - mu2) / d2;
+				dudt[3] = u[1] - 2.0 * u[2] - mu2 * u[1] / d1 - mu * u[1] / d2;
+			} } }
+	};
+	return systems;
+}
+
+bool Batch::ParseJob(const std::string& text, std::size_t line, std::size_t sequence, Job& job)
+{
+	std::string content = text.substr(0, text.find('#'));
+	std::istringstream fields(content);
+	std::string field;
+	if (!(fields >> field))
+		return false;
+
+	job = Job();
+	job.id = std::to_string(sequence);
+	job.line = line;
+	job.system = field;
+
+	auto fail = [&](const std::string& message) {
+		job.error = "linha " + std::to_string(line) + ": " + message;
+		return true;
+	};
+
+	while (fields >> field) {
+		std::size_t equal = field.find('=');
+		if (equal == std::string::npos)
+			return fail("esperado chave=valor em " + field + ".");
+		std::string key = field.substr(0, equal);
+		std::string value = field.substr(equal + 1);
+		std::vector<double> values;
+		double number;
+
+		if (key == "id") {
+			job.id = value;
+		}
+		else if (key == "t") {
+			if (!ParseList(value, values) || values.size() != 2)
+				return fail("t deve ter início e fim.");
+			job.tSpan = { values[0], values[1] };
+		}
+		else if (key == "u") {
+			if (!ParseList(value, job.uInitial))
+				return fail("valores de u inválidos.");
+		}
+		else if (key == "p") {
+			if (!ParseList(value, job.parameters))
+				return fail("valores de p inválidos.");
+		}
+		else if (key == "tol") {
+			if (!ParseNumber(value, number) || !(number > 0.0))
+				return fail("tolerância inválida.");
+			job.tolerance = number;
+		}
+		else if (key == "h") {
+			if (!ParseNumber(value, number))
+				return fail("passo inicial inválido.");
+			job.initialStep = number;
+		}
+		else if (key == "steps") {
+			if (!ParseNumber(value, number) || !(number >= 1.0) ||
+				number >= static_cast<double>(std::numeric_limits<std::size_t>::max()))
+				return fail("quantidade de passos inválida.");
+			job.maximumNumberOfSteps = static_cast<std::size_t>(number);
+		}
+		else {
+			return fail("campo desconhecido: " + key + ".");
+		}
+	}
+
+	if (job.uInitial.empty())
+		return fail("faltam os valores iniciais (u=...).");
+	if (job.tSpan.second == job.tSpan.first)
+		return fail("intervalo de integração vazio.");
+	return true;
+}
+
+void Batch::Catalog::Define(const std::string& name, const std::string& source)
+{
+	if (BuiltInSystems().count(name) > 0)
+		throw "Batch: o nome do sistema coincide com o de um sistema interno.";
+	systems[name].reset(new Expression::System(source));
+}
+
+const Expression::System* Batch::Catalog::Find(const std::string& name) const
+{
+	auto found = systems.find(name);
+	return (found == systems.end()) ? nullptr : found->second.get();
+}
+
+Batch::Workspace::Workspace(const Catalog& catalog) : catalog(catalog)
+{
+}
+
+void Batch::Workspace::Run(const Job& job, Result& result)
+{
+	result.id = job.id;
+	result.status = Status::Completed;
+	result.message.clear();
+	result.t = job.tSpan.first;
+	result.u.clear();
+	result.acceptedSteps = 0;
+	result.rejectedSteps = 0;
+	result.rhsEvaluations = 0;
+
+	if (!job.error.empty()) {
+		result.status = Status::Failed;
+		result.message = job.error;
+		return;
+	}
+
+	auto fail = [&](const std::string& message) {
+		result.status = Status::Failed;
+		result.message = "linha " + std::to_string(job.line) + ": " + message;
+	};
+
+	std::function<
+		void(double,
+			std::vector<double>&,
+			std::vector<double>&)
+	> dynFun;
+
+	auto builtIn = BuiltInSystems().find(job.system);
+	if (builtIn != BuiltInSystems().end()) {
+		const BuiltInSystem& system = builtIn->second;
+		if (job.uInitial.size() != system.stateSize)
+			return fail("quantidade de valores iniciais difere do sistema " + job.system + ".");
+		if (!job.parameters.empty() && job.parameters.size() != system.parameters.size())
+			return fail("quantidade de parâmetros difere do sistema " + job.system + ".");
+		parameters = job.parameters.empty() ? system.parameters : job.parameters;
+		const ParametricFunction& function = system.function;
+		std::vector<double>& p = parameters;
+		dynFun = [&function, &p](double t, std::vector<double>& u, std::vector<double>& dudt) {
+			function(t, u, p, dudt);
+		};
+	}
+	else {
+		const Expression::System* prototype = catalog.Find(job.system);
+		if (prototype == nullptr)
+			return fail("sistema desconhecido: " + job.system + ".");
+
+		/*
+			Cópia própria da thread, criada no primeiro uso.
+		*/
+		std::unique_ptr<Expression::System>& copy = systems[job.system];
+		if (!copy)
+			copy.reset(new Expression::System(*prototype));
+		Expression::System& system = *copy;
+
+		if (job.uInitial.size() != system.StateSize())
+			return fail("quantidade de valores iniciais difere do sistema " + job.system + ".");
+		if (!job.parameters.empty() && job.parameters.size() != system.Parameters().size())
+			return fail("quantidade de parâmetros difere do sistema " + job.system + ".");
+		system.Parameters() = job.parameters.empty() ? prototype->Parameters() : job.parameters;
+		dynFun = [&system](double t, std::vector<double>& u, std::vector<double>& dudt) {
+			system.Evaluate(t, u, dudt);
+		};
+	}
+
+	std::function<
+		void(double,
+			std::vector<double>&)
+	> observer = [&result](double t, std::vector<double>& u) {
+		result.t = t;
+		result.u = u;
+		result.acceptedSteps++;
+	};
+
+	uInitial = job.uInitial;
+	std::pair<double, double> tSpan = job.tSpan;
+	double initialStep = (job.initialStep != 0.0) ?
+		job.initialStep : (tSpan.second - tSpan.first) * 1e-3;
+
+	try {
+		CashKarp::IntegrationStatistics statistics = CashKarp::Generic::CashKarpRange(
+			uInitial, tSpan, job.tolerance, initialStep, 0.0,
+			job.maximumNumberOfSteps, dynFun, observer, integrator);
+		result.rejectedSteps = statistics.rejectedSteps;
+		result.rhsEvaluations = statistics.rhsEvaluations;
+	}
+	catch (const char* message) {
+		return fail(message);
+	}
+
+	// O ponto inicial também é entregue a observer
+	result.acceptedSteps--;
+	bool finite = std::isfinite(result.t);
+	for (double value : result.u)
+		finite = finite && std::isfinite(value);
+	if (!finite)
+		return fail("a integração resultou em valores não finitos.");
+	if ((result.t - tSpan.second) * (tSpan.second - tSpan.first) < 0.0)
+		result.status = Status::StepLimit;
+}
+
+const char* Batch::CsvHeader()
+{
+	return "id,status,t,accepted_steps,rejected_steps,rhs_evaluations,u\n";
+}
+
+void Batch::WriteCsv(const Result& result, std::string& buffer)
+{
+	static const char* statusNames[] = { "completed", "step_limit", "failed" };
+	buffer += result.id;
+	buffer += ',';
+	buffer += statusNames[static_cast<int>(result.status)];
+
+	if (result.status == Status::Failed) {
+		buffer += ",\"";
+		for (char character : result.message)
+			buffer += (character == '"') ? '\'' : character;
+		buffer += "\"\n";
+		return;
+	}
+
+	buffer += ',';
+	AppendNumber(buffer, result.t);
+	buffer += ',' + std::to_string(result.acceptedSteps);
+	buffer += ',' + std::to_string(result.rejectedSteps);
+	buffer += ',' + std::to_string(result.rhsEvaluations);
+	for (double value : result.u) {
+		buffer += ',';
+		AppendNumber(buffer, value);
+	}
+	buffer += '\n';
+}
+
+void Batch::WriteBinary(const Result& result, std::string& buffer)
+{
+	bool failed = (result.status == Status::Failed);
+	AppendBytes(buffer, static_cast<std::uint32_t>(result.id.size()));
+	buffer += result.id;
+	AppendBytes(buffer, static_cast<std::int32_t>(result.status));
+	AppendBytes(buffer, static_cast<std::uint32_t>(
+		failed ? result.message.size() : result.u.size()));
+	AppendBytes(buffer, result.t);
+	AppendBytes(buffer, result.acceptedSteps);
+	AppendBytes(buffer, result.rejectedSteps);
+	AppendBytes(buffer, result.rhsEvaluations);
+	if (failed)
+		buffer += result.message;
+	else
+		buffer.append(reinterpret_cast<const char*>(result.u.data()), result.u.size() * sizeof(double));
+}
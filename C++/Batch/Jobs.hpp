@@ -0,0 +1,208 @@
+/**
+* @file Jobs.hpp
+* @brief Tarefas de integração do executável batch: leitura, execução e saída
+*/
+
+/*
+	* Cada linha da entrada descreve uma integração: o nome do sistema
+	seguido de campos chave=valor, em qualquer ordem. Linhas vazias e
+	comentários ('#') são ignorados. Todos os números devem ser finitos.
+
+		lorenz t=0,10 u=1,1,1 tol=1e-8 p=10,28,2.6666666666666665 id=7
+
+	-> t: início e fim do intervalo (padrão 0,1)
+	-> u: valores iniciais (obrigatório)
+	-> tol: tolerância (padrão 1e-6)
+	-> h: passo inicial (padrão: 1/1000 do intervalo)
+	-> steps: quantidade máxima de passos (padrão 1000000)
+	-> p: parâmetros do sistema, na ordem declarada (padrão: valores do
+	sistema)
+	-> id: identificador copiado para o resultado (padrão: número da tarefa,
+	a partir de 0)
+
+	* Sistemas: os internos (BuiltInSystems, funções compiladas) e os
+	definidos em texto (Expression::System) adicionados ao Catalog.
+
+	* Resultados em CSV (uma linha por tarefa) ou em binário, com um
+	registro por tarefa (ver WriteBinary).
+*/
+
+#pragma once
+
+#include "CashKarpGeneric.hpp"
+#include "Expression.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Batch {
+	/**
+	* @brief Protótipo dos sistemas internos: dudt = f(t, u, p).
+	*/
+	using ParametricFunction = std::function<
+		void(double,
+			std::vector<double>&,
+			const std::vector<double>&,
+			std::vector<double>&)>;
+
+	/**
+	* @brief Sistema interno, compilado com o executável.
+	*/
+	struct BuiltInSystem {
+		std::size_t stateSize;
+		// Valores padrão dos parâmetros
+		std::vector<double> parameters;
+		ParametricFunction function;
+	};
+
+	/**
+	* @brief Sistemas internos, por nome: blasius, lorenz, vanderpol e
+	* arenstorf (os mesmos dos benchmarks).
+	*/
+	const std::map<std::string, BuiltInSystem>& BuiltInSystems();
+
+	/**
+	* @brief Tarefa de integração.
+	*/
+	struct Job {
+		std::string id;
+		// Linha da entrada, para mensagens de erro
+		std::size_t line = 0;
+		std::string system;
+		std::vector<double> uInitial;
+		std::pair<double, double> tSpan = { 0.0, 1.0 };
+		double tolerance = 1e-6;
+		// Zero: 1/1000 do intervalo
+		double initialStep = 0.0;
+		std::size_t maximumNumberOfSteps = 1000000;
+		std::vector<double> parameters;
+		// Erro de leitura, entregue como resultado da tarefa
+		std::string error;
+	};
+
+	/**
+	* @brief Lê uma tarefa de uma linha da entrada. Erros não interrompem a
+	* leitura: são guardados em job.error.
+	* @param[in] text Linha da entrada (entrada)
+	* @param[in] line Número da linha (entrada)
+	* @param[in] sequence Número da tarefa, identificador padrão (entrada)
+	* @param[out] job Tarefa lida (saída)
+	* @return false se a linha estiver vazia ou for um comentário
+	*/
+	bool ParseJob(const std::string& text, std::size_t line, std::size_t sequence, Job& job);
+
+	/**
+	* @brief Situação de uma tarefa concluída.
+	*/
+	enum class Status : std::int32_t {
+		// Integração até o fim do intervalo
+		Completed = 0,
+		// Interrompida pela quantidade máxima de passos
+		StepLimit = 1,
+		// Erro de leitura ou de integração, inclusive valores finais não
+		// finitos (ver Result::message)
+		Failed = 2
+	};
+
+	/**
+	* @brief Resultado de uma tarefa.
+	*/
+	struct Result {
+		std::string id;
+		Status status = Status::Completed;
+		std::string message;
+		// Último ponto aceito
+		double t = 0.0;
+		std::vector<double> u;
+		std::uint64_t acceptedSteps = 0;
+		// Zerados se CASHKARP_STATISTICS for 0
+		std::uint64_t rejectedSteps = 0;
+		std::uint64_t rhsEvaluations = 0;
+	};
+
+	/**
+	* @brief Sistemas disponíveis para as tarefas: os internos e os
+	* definidos em texto.
+	*/
+	class Catalog {
+	public:
+		/**
+		* @brief Adiciona um sistema definido em texto (ver Expression.hpp).
+		* @param[in] name Nome utilizado nas tarefas (entrada)
+		* @param[in] source Texto do sistema (entrada)
+		*/
+		void Define(const std::string& name, const std::string& source);
+
+		/**
+		* @brief Sistema definido em texto com o nome dado, nulo se não
+		* existir.
+		*/
+		const Expression::System* Find(const std::string& name) const;
+
+	private:
+		std::map<std::string, std::unique_ptr<Expression::System>> systems;
+	};
+
+	/**
+	* @brief Memória de trabalho de uma thread, reutilizada entre as tarefas:
+	* vetores do integrador (estágios, derivadas, escala do erro e estado),
+	* cópias dos sistemas em texto (cuja avaliação utiliza registradores
+	* próprios), parâmetros e estado inicial. Após as primeiras tarefas, só
+	* há alocações quando o sistema é maior que os anteriores.
+	*/
+	class Workspace {
+	public:
+		/**
+		* @brief Construtor
+		* @param[in] catalog Sistemas disponíveis (entrada)
+		*/
+		explicit Workspace(const Catalog& catalog);
+
+		/**
+		* @brief Executa a tarefa com CashKarp::Generic::CashKarpRange em
+		* double, sobre os vetores deste Workspace, guardando apenas o último
+		* ponto.
+		* @param[in] job Tarefa (entrada)
+		* @param[out] result Resultado (saída)
+		*/
+		void Run(const Job& job, Result& result);
+
+	private:
+		const Catalog& catalog;
+		std::map<std::string, std::unique_ptr<Expression::System>> systems;
+		std::vector<double> parameters;
+		std::vector<double> uInitial;
+		CashKarp::Generic::Workspace<double> integrator;
+	};
+
+	/**
+	* @brief Cabeçalho do formato CSV.
+	*/
+	const char* CsvHeader();
+
+	/**
+	* @brief Acrescenta o resultado ao final de buffer, em uma linha CSV:
+	* id,status,t,accepted_steps,rejected_steps,rhs_evaluations,u0,u1,...
+	* Em tarefas com erro, a mensagem (entre aspas) substitui t e u.
+	* @param[in] result Resultado (entrada)
+	* @param[in, out] buffer Texto de saída (entrada e saída)
+	*/
+	void WriteCsv(const Result& result, std::string& buffer);
+
+	/**
+	* @brief Acrescenta o resultado ao final de buffer, em binário (ordem de
+	* bytes da máquina):
+	* uint32 tamanho do id, id, int32 status, uint32 n, double t,
+	* uint64 passos aceitos, uint64 rejeitados, uint64 chamadas a dynFun
+	* e n doubles de u. Em tarefas com erro, n é o tamanho da mensagem e os
+	* n bytes da mensagem substituem u.
+	* @param[in] result Resultado (entrada)
+	* @param[in, out] buffer Dados de saída (entrada e saída)
+	*/
+	void WriteBinary(const Result& result, std::string& buffer);
+}
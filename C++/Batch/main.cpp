@@ -0,0 +1,225 @@
+/**
+* @file main.cpp
+* @brief Executável batch: integra um fluxo de tarefas lido de um arquivo
+*/
+
+/*
+	* Uso:
+		batch [--input tarefas.txt] [--output resultados.csv]
+			[--format csv|binary] [--threads N] [--queue N]
+			[--define nome=sistema.ode]...
+	Sem --input/--output, utiliza a entrada e a saída padrão. O formato das
+	tarefas e dos resultados está descrito em Jobs.hpp.
+
+	* Uma thread lê e interpreta a entrada, entregando as tarefas a uma fila
+	de capacidade limitada (--queue, padrão 4 por thread); as threads do
+	ThreadPool retiram as tarefas, integram-nas com sua própria memória de
+	trabalho e escrevem cada resultado assim que termina (na ordem de
+	conclusão, identificado pelo id). A leitura aguarda quando a fila está
+	cheia, e a escrita é feita diretamente por quem integrou, de modo que a
+	memória utilizada não depende do tamanho da entrada.
+
+	* Ao final, a quantidade de tarefas por segundo é informada na saída de
+	erros.
+*/
+
+#include "BoundedQueue.hpp"
+#include "Jobs.hpp"
+#include "ThreadPool.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace {
+	struct Options {
+		std::string input;
+		std::string output;
+		bool binary = false;
+		std::size_t threads = 0;
+		std::size_t queueCapacity = 0;
+		std::vector<std::pair<std::string, std::string>> definitions;
+	};
+
+	void Usage() {
+		std::cerr <<
+			"Uso: batch [--input arquivo] [--output arquivo] [--format csv|binary]\n"
+			"             [--threads N] [--queue N] [--define nome=arquivo.ode]...\n";
+		std::exit(EXIT_FAILURE);
+	}
+
+	Options ParseOptions(int argc, char** argv) {
+		Options options;
+		for (int i = 1; i < argc; i++) {
+			std::string argument = argv[i];
+			if (i + 1 >= argc)
+				Usage();
+			std::string value = argv[++i];
+
+			if (argument == "--input")
+				options.input = value;
+			else if (argument == "--output")
+				options.output = value;
+			else if (argument == "--format" && (value == "csv" || value == "binary"))
+				options.binary = (value == "binary");
+			else if (argument == "--threads")
+				options.threads = std::strtoul(value.c_str(), nullptr, 10);
+			else if (argument == "--queue")
+				options.queueCapacity = std::strtoul(value.c_str(), nullptr, 10);
+			else if (argument == "--define" && value.find('=') != std::string::npos)
+				options.definitions.push_back({ value.substr(0, value.find('=')), value.substr(value.find('=') + 1) });
+			else
+				Usage();
+		}
+		return options;
+	}
+
+	std::string ReadFile(const std::string& path) {
+		std::ifstream file(path);
+		if (!file)
+			throw "Batch: não foi possível abrir o arquivo de definição do sistema.";
+		std::ostringstream text;
+		text << file.rdbuf();
+		return text.str();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options = ParseOptions(argc, argv);
+
+	Batch::Catalog catalog;
+	try {
+		for (const std::pair<std::string, std::string>& definition : options.definitions)
+			catalog.Define(definition.first, ReadFile(definition.second));
+	}
+	catch (const char* message) {
+		std::cerr << message << "\n";
+		return EXIT_FAILURE;
+	}
+
+	std::ifstream inputFile;
+	std::ofstream outputFile;
+	if (!options.input.empty()) {
+		inputFile.open(options.input);
+		if (!inputFile) {
+			std::cerr << "Batch: não foi possível abrir " << options.input << "\n";
+			return EXIT_FAILURE;
+		}
+	}
+	if (!options.output.empty()) {
+		outputFile.open(options.output, std::ios::binary);
+		if (!outputFile) {
+			std::cerr << "Batch: não foi possível criar " << options.output << "\n";
+			return EXIT_FAILURE;
+		}
+	}
+	std::istream& input = options.input.empty() ? std::cin : inputFile;
+	std::ostream& output = options.output.empty() ? std::cout : outputFile;
+	std::ios::sync_with_stdio(false);
+
+	ThreadPool::ThreadPool pool(options.threads);
+	std::size_t capacity = (options.queueCapacity > 0) ? options.queueCapacity : 4 * pool.Size();
+	Batch::BoundedQueue<Batch::Job> queue(capacity);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	/*
+		Leitura em uma thread separada, pois a thread principal participa
+		das integrações (parte 0 do ThreadPool).
+	*/
+	std::thread reader([&]() {
+		std::string line;
+		std::size_t lineNumber = 0, sequence = 0;
+		Batch::Job job;
+		while (std::getline(input, line)) {
+			lineNumber++;
+			if (Batch::ParseJob(line, lineNumber, sequence, job)) {
+				sequence++;
+				// Fila fechada por um erro nas integrações
+				if (!queue.Push(std::move(job)))
+					break;
+			}
+		}
+		queue.Close();
+	});
+
+	if (!options.binary)
+		output << Batch::CsvHeader();
+
+	std::mutex outputMutex;
+	std::size_t completed = 0, stepLimited = 0, failed = 0;
+
+	/*
+		Cada thread do ThreadPool é um consumidor da fila, com seu próprio
+		Workspace (vetores do integrador e cópias dos sistemas em texto).
+	*/
+	auto worker = [&](std::size_t) {
+		Batch::Workspace workspace(catalog);
+		Batch::Job job;
+		Batch::Result result;
+		std::string buffer;
+		while (queue.Pop(job)) {
+			workspace.Run(job, result);
+			buffer.clear();
+			if (options.binary)
+				Batch::WriteBinary(result, buffer);
+			else
+				Batch::WriteCsv(result, buffer);
+
+			std::lock_guard<std::mutex> lock(outputMutex);
+			output.write(buffer.data(), buffer.size());
+			if (result.status == Batch::Status::Completed)
+				completed++;
+			else if (result.status == Batch::Status::StepLimit)
+				stepLimited++;
+			else
+				failed++;
+		}
+	};
+
+	/*
+		Se uma integração lançar uma exceção, a leitura pode estar
+		aguardando espaço na fila: a fila é fechada e a leitura termina
+		antes que a mensagem seja exibida.
+	*/
+	bool aborted = true;
+	std::string failure = "erro desconhecido";
+	try {
+		pool.RunOnEachThread(worker);
+		aborted = false;
+	}
+	catch (const char* message) {
+		failure = message;
+	}
+	catch (const std::exception& exception) {
+		failure = exception.what();
+	}
+	catch (...) {
+	}
+	if (aborted) {
+		queue.Close();
+		reader.join();
+		std::cerr << "Batch: " << failure << "\n";
+		return EXIT_FAILURE;
+	}
+
+	reader.join();
+	output.flush();
+
+	double seconds = std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - start).count();
+	std::size_t jobs = completed + stepLimited + failed;
+	std::cerr << "batch: " << jobs << " tarefas (" << completed << " concluídas, "
+		<< stepLimited << " no limite de passos, " << failed << " com erro) em "
+		<< seconds << " s, " << jobs / seconds << " tarefas/s, "
+		<< pool.Size() << " threads\n";
+
+	return (failed > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,325 @@
+/**
+* @file Benchmark.cpp
+* @brief Infraestrutura mínima de benchmarks, no estilo do Google Benchmark
+*/
+
+#include "Benchmark.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <regex>
+#include <sstream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifndef __AVX2__
+#define __AVX2__ 0
+#endif
+
+namespace {
+	struct Entry {
+		std::string name;
+		Benchmark::Function function;
+	};
+
+	struct Result {
+		std::string name;
+		std::size_t iterations;
+		double realTime, cpuTime;
+		std::map<std::string, double> counters;
+		std::string errorMessage;
+	};
+
+	/*
+		Lista de benchmarks registrados, na ordem de registro.
+		É utilizada uma função com variável estática para evitar problemas
+		de ordem de inicialização entre unidades de tradução.
+	*/
+	std::vector<Entry>& Registry() {
+		static std::vector<Entry> registry;
+		return registry;
+	}
+
+	/*
+		Escreve um número em JSON. Valores não finitos não são aceitos pelo
+		formato, sendo substituídos por null.
+	*/
+	void WriteNumber(std::ostream& out, double value) {
+		if (std::isfinite(value))
+			out << value;
+		else
+			out << "null";
+	}
+
+	void WriteString(std::ostream& out, const std::string& value) {
+		out << '"';
+		for (char c : value) {
+			if (c == '"' || c == '\\')
+				out << '\\' << c;
+			else if (c == '\n')
+				out << "\\n";
+			else
+				out << c;
+		}
+		out << '"';
+	}
+
+	void WriteJSON(
+		std::ostream& out,
+		const std::string& executable,
+		std::vector<Result>& results)
+	{
+		std::time_t now = std::time(nullptr);
+		char date[64];
+		std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+		out << std::setprecision(10);
+		out << "{\n  \"context\": {\n";
+		out << "    \"date\": ";
+		WriteString(out, date);
+		out << ",\n    \"executable\": ";
+		WriteString(out, executable);
+		out << ",\n    \"num_cpus\": " << std::thread::hardware_concurrency();
+#ifdef NDEBUG
+		out << ",\n    \"library_build_type\": \"release\"";
+#else
+		out << ",\n    \"library_build_type\": \"debug\"";
+#endif
+		out << ",\n    \"avx2\": " << ((__AVX2__ == 1) ? "true" : "false");
+		out << "\n  },\n  \"benchmarks\": [";
+
+		for (std::size_t i = 0; i < results.size(); i++) {
+			Result& result = results[i];
+			out << ((i == 0) ? "\n" : ",\n") << "    {\n      \"name\": ";
+			WriteString(out, result.name);
+			out << ",\n      \"run_name\": ";
+			WriteString(out, result.name);
+			out << ",\n      \"run_type\": \"iteration\"";
+			out << ",\n      \"repetitions\": 1";
+			out << ",\n      \"repetition_index\": 0";
+			out << ",\n      \"threads\": 1";
+			if (!result.errorMessage.empty()) {
+				out << ",\n      \"error_occurred\": true";
+				out << ",\n      \"error_message\": ";
+				WriteString(out, result.errorMessage);
+			}
+			out << ",\n      \"iterations\": " << result.iterations;
+			out << ",\n      \"real_time\": ";
+			WriteNumber(out, result.realTime);
+			out << ",\n      \"cpu_time\": ";
+			WriteNumber(out, result.cpuTime);
+			out << ",\n      \"time_unit\": \"ns\"";
+			for (auto& counter : result.counters) {
+				out << ",\n      ";
+				WriteString(out, counter.first);
+				out << ": ";
+				WriteNumber(out, counter.second);
+			}
+			out << "\n    }";
+		}
+		out << "\n  ]\n}\n";
+	}
+
+	void WriteConsoleHeader(std::ostream& out, std::size_t nameWidth) {
+		out << std::left << std::setw(nameWidth) << "Benchmark"
+			<< std::right << std::setw(15) << "Time"
+			<< std::setw(15) << "CPU"
+			<< std::setw(12) << "Iterations"
+			<< "\n" << std::string(nameWidth + 42, '-') << "\n";
+	}
+
+	void WriteConsoleLine(std::ostream& out, std::size_t nameWidth, Result& result) {
+		out << std::left << std::setw(nameWidth) << result.name << std::right;
+		if (!result.errorMessage.empty()) {
+			out << " ERROR: " << result.errorMessage << "\n";
+			return;
+		}
+		out << std::setw(12) << std::fixed << std::setprecision(0)
+			<< result.realTime << " ns"
+			<< std::setw(12) << result.cpuTime << " ns"
+			<< std::setw(12) << result.iterations;
+		out.unsetf(std::ios::floatfield);
+		out << std::setprecision(4);
+		for (auto& counter : result.counters)
+			out << " " << counter.first << "=" << counter.second;
+		out << std::endl;
+	}
+}
+
+Benchmark::State::State(std::size_t maximumIterations) :
+	maximumIterations(maximumIterations),
+	iterations(0),
+	started(false),
+	running(false),
+	realTime(0.0),
+	cpuTime(0.0),
+	cpuStart(0)
+{
+}
+
+void Benchmark::State::StartTimer()
+{
+	running = true;
+	cpuStart = std::clock();
+	realStart = std::chrono::steady_clock::now();
+}
+
+void Benchmark::State::StopTimer()
+{
+	auto realEnd = std::chrono::steady_clock::now();
+	std::clock_t cpuEnd = std::clock();
+	realTime += std::chrono::duration<double, std::nano>(realEnd - realStart).count();
+	cpuTime += 1.0e9 * static_cast<double>(cpuEnd - cpuStart) / CLOCKS_PER_SEC;
+	running = false;
+}
+
+bool Benchmark::State::KeepRunning()
+{
+	if (!started) {
+		started = true;
+		StartTimer();
+	}
+	else {
+		iterations++;
+	}
+
+	if (iterations < maximumIterations && errorMessage.empty())
+		return true;
+
+	if (running)
+		StopTimer();
+	return false;
+}
+
+void Benchmark::State::PauseTiming()
+{
+	if (running)
+		StopTimer();
+}
+
+void Benchmark::State::ResumeTiming()
+{
+	if (!running)
+		StartTimer();
+}
+
+void Benchmark::State::SkipWithError(const std::string& message)
+{
+	errorMessage = message;
+}
+
+void Benchmark::Register(const std::string& name, Function function)
+{
+	Registry().push_back({ name, function });
+}
+
+int Benchmark::RunBenchmarks(int argc, char** argv)
+{
+	std::string filter = ".*", format = "console", outputFile;
+	double minimumTime = 0.5;
+	bool listOnly = false;
+
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		auto value = [&argument](const std::string& prefix, std::string& output) {
+			if (argument.compare(0, prefix.size(), prefix) != 0)
+				return false;
+			output = argument.substr(prefix.size());
+			return true;
+		};
+		std::string text;
+		if (value("--benchmark_filter=", text))
+			filter = text;
+		else if (value("--benchmark_min_time=", text))
+			minimumTime = std::stod(text);
+		else if (value("--benchmark_format=", text))
+			format = text;
+		else if (value("--benchmark_out=", text))
+			outputFile = text;
+		else if (argument == "--benchmark_list_tests")
+			listOnly = true;
+		else {
+			std::cerr << "Argumento desconhecido: " << argument << "\n";
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::regex expression(filter);
+	std::vector<Entry*> selected;
+	std::size_t nameWidth = 10;
+	for (Entry& entry : Registry()) {
+		if (std::regex_search(entry.name, expression)) {
+			selected.push_back(&entry);
+			nameWidth = std::max(nameWidth, entry.name.size() + 2);
+		}
+	}
+
+	if (listOnly) {
+		for (Entry* entry : selected)
+			std::cout << entry->name << "\n";
+		return EXIT_SUCCESS;
+	}
+
+	bool console = (format != "json");
+	if (console)
+		WriteConsoleHeader(std::cout, nameWidth);
+
+	std::vector<Result> results;
+	for (Entry* entry : selected) {
+		/*
+			Assim como no Google Benchmark, o número de iterações é aumentado
+			progressivamente até que o tempo total alcance o mínimo desejado.
+		*/
+		std::size_t iterations = 1;
+		Result result;
+		while (true) {
+			State state(iterations);
+			entry->function(state);
+
+			double elapsed = state.RealTime() * 1.0e-9;
+			bool finished =
+				!state.errorMessage.empty() ||
+				elapsed >= minimumTime ||
+				iterations >= 1000000000;
+			if (finished) {
+				std::size_t done = std::max<std::size_t>(state.Iterations(), 1);
+				result.name = entry->name;
+				result.iterations = state.Iterations();
+				result.realTime = state.RealTime() / done;
+				result.cpuTime = state.CpuTime() / done;
+				result.counters = state.counters;
+				result.errorMessage = state.errorMessage;
+				break;
+			}
+
+			double multiplier =
+				(elapsed / minimumTime > 0.1)
+				? 1.4 * minimumTime / elapsed
+				: 10.0;
+			iterations = std::max(
+				iterations + 1,
+				static_cast<std::size_t>(iterations * std::min(multiplier, 10.0)));
+		}
+
+		if (console)
+			WriteConsoleLine(std::cout, nameWidth, result);
+		results.push_back(result);
+	}
+
+	if (!console)
+		WriteJSON(std::cout, argv[0], results);
+
+	if (!outputFile.empty()) {
+		std::ofstream out(outputFile);
+		if (!out) {
+			std::cerr << "Não foi possível abrir " << outputFile << "\n";
+			return EXIT_FAILURE;
+		}
+		WriteJSON(out, argv[0], results);
+	}
+
+	return EXIT_SUCCESS;
+}
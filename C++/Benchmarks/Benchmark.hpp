@@ -0,0 +1,125 @@
+/**
+* @file Benchmark.hpp
+* @brief Infraestrutura mínima de benchmarks, no estilo do Google Benchmark
+*/
+
+/*
+	* A interface (e o formato JSON produzido) imita a biblioteca Google
+	Benchmark, de forma que ferramentas como o script compare.py da mesma
+	possam ser utilizadas para comparar duas compilações. Não há dependências
+	externas: tudo o que é necessário está neste diretório.
+
+	* Arquivo de cabeçalho, não contém implementações.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <ctime>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+
+namespace Benchmark {
+	/**
+	* @brief Estado de uma execução de benchmark.
+	* O corpo do benchmark deve repetir o trecho medido enquanto KeepRunning()
+	* retornar verdadeiro. Contadores adicionais (passos, chamadas à função,
+	* erro...) são registrados em counters e exportados junto ao tempo.
+	*/
+	class State {
+	public:
+		/**
+		* @brief Construtor
+		* @param[in] maximumIterations Quantidade de iterações a executar (entrada)
+		*/
+		explicit State(std::size_t maximumIterations);
+
+		/**
+		* @brief Indica se mais uma iteração deve ser executada.
+		* A primeira chamada inicia o cronômetro e a última o encerra.
+		*/
+		bool KeepRunning();
+
+		/**
+		* @brief Pausa o cronômetro, para excluir preparações da medição.
+		*/
+		void PauseTiming();
+
+		/**
+		* @brief Retoma o cronômetro após PauseTiming().
+		*/
+		void ResumeTiming();
+
+		/**
+		* @brief Quantidade de iterações executadas até o momento.
+		*/
+		std::size_t Iterations() const { return iterations; }
+
+		/**
+		* @brief Tempo real acumulado, em nanossegundos.
+		*/
+		double RealTime() const { return realTime; }
+
+		/**
+		* @brief Tempo de CPU acumulado (do processo), em nanossegundos.
+		*/
+		double CpuTime() const { return cpuTime; }
+
+		/**
+		* @brief Marca a execução como falha, com uma mensagem explicativa.
+		* @param[in] message Mensagem de erro (entrada)
+		*/
+		void SkipWithError(const std::string& message);
+
+		/**
+		* @brief Contadores definidos pelo usuário, exportados como estão.
+		*/
+		std::map<std::string, double> counters;
+
+		/**
+		* @brief Mensagem de erro, vazia caso a execução tenha sido válida.
+		*/
+		std::string errorMessage;
+
+	private:
+		void StartTimer();
+		void StopTimer();
+
+		std::size_t maximumIterations;
+		std::size_t iterations;
+		bool started, running;
+		double realTime, cpuTime;
+		std::chrono::steady_clock::time_point realStart;
+		std::clock_t cpuStart;
+	};
+
+	/**
+	* @brief Protótipo de uma função de benchmark.
+	*/
+	using Function = std::function<void(State&)>;
+
+	/**
+	* @brief Registra um benchmark.
+	* Nomes seguem a convenção "Rotina/Problema/parâmetro:valor", permitindo
+	* filtrá-los com expressões regulares.
+	* @param[in] name Nome do benchmark (entrada)
+	* @param[in] function Corpo do benchmark (entrada)
+	*/
+	void Register(const std::string& name, Function function);
+
+	/**
+	* @brief Executa todos os benchmarks registrados.
+	* Opções aceitas (mesmos nomes do Google Benchmark):
+	* --benchmark_filter=<regex>
+	* --benchmark_min_time=<segundos>
+	* --benchmark_format=<console|json>
+	* --benchmark_out=<arquivo> (sempre em JSON)
+	* --benchmark_list_tests
+	* @param[in] argc Quantidade de argumentos (entrada)
+	* @param[in] argv Argumentos de linha de comando (entrada)
+	* @return Código de saída do programa
+	*/
+	int RunBenchmarks(int argc, char** argv);
+}
@@ -0,0 +1,205 @@
+/**
+* @file BenchmarkAutoDiff.cpp
+* @brief Benchmarks da matriz Jacobiana: números duais contra diferenças finitas
+*/
+
+#include "Benchmark.hpp"
+#include "Jacobian.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <string>
+
+namespace {
+	/*
+		Sistemas em template no tipo do escalar. As funções matemáticas são
+		chamadas sem qualificação, para que a versão de AutoDiff seja
+		utilizada com Dual.
+	*/
+	struct LorenzSystem {
+		template <typename Scalar, typename Precision>
+		void operator()(Precision t, std::vector<Scalar>& u, std::vector<Scalar>& dudt) const {
+			const double sigma = 10.0, rho = 28.0, beta = 8.0 / 3.0;
+			dudt[0] = sigma * (u[1] - u[0]);
+			dudt[1] = u[0] * (rho - u[2]) - u[1];
+			dudt[2] = u[0] * u[1] - beta * u[2];
+		}
+	};
+
+	/*
+		Modelo de Lorenz-96, com N variáveis em um anel:
+		du_i/dt = (u_{i+1} - u_{i-2}) * u_{i-1} - u_i + F.
+	*/
+	struct Lorenz96System {
+		template <typename Scalar, typename Precision>
+		void operator()(Precision t, std::vector<Scalar>& u, std::vector<Scalar>& dudt) const {
+			const double forcing = 8.0;
+			std::size_t n = u.size();
+			for (std::size_t i = 0; i < n; i++) {
+				const Scalar& next = u[(i + 1) % n];
+				const Scalar& previous = u[(i + n - 1) % n];
+				const Scalar& previous2 = u[(i + n - 2) % n];
+				dudt[i] = (next - previous2) * previous - u[i] + forcing;
+			}
+		}
+	};
+
+	/*
+		Mesmo sistema de Problems::NBody (estado AoS: x, y, z de cada corpo,
+		seguidos das velocidades), com Jacobiana densa no bloco das posições.
+	*/
+	struct NBodySystem {
+		std::size_t bodies;
+
+		template <typename Scalar, typename Precision>
+		void operator()(Precision t, std::vector<Scalar>& u, std::vector<Scalar>& dudt) const {
+			using std::sqrt;
+			const double softening2 = 0.05 * 0.05;
+			const double mass = 1.0 / static_cast<double>(bodies);
+			std::size_t n = 3 * bodies;
+			for (std::size_t i = 0; i < n; i++) {
+				dudt[i] = u[n + i];
+				dudt[n + i] = 0.0;
+			}
+			for (std::size_t i = 0; i < bodies; i++) {
+				for (std::size_t j = i + 1; j < bodies; j++) {
+					Scalar dx = u[3 * j] - u[3 * i];
+					Scalar dy = u[3 * j + 1] - u[3 * i + 1];
+					Scalar dz = u[3 * j + 2] - u[3 * i + 2];
+					Scalar r2 = dx * dx + dy * dy + dz * dz + softening2;
+					Scalar factor = mass / (r2 * sqrt(r2));
+					dudt[n + 3 * i] += factor * dx;
+					dudt[n + 3 * i + 1] += factor * dy;
+					dudt[n + 3 * i + 2] += factor * dz;
+					dudt[n + 3 * j] -= factor * dx;
+					dudt[n + 3 * j + 1] -= factor * dy;
+					dudt[n + 3 * j + 2] -= factor * dz;
+				}
+			}
+		}
+	};
+
+	std::vector<double> Lorenz96Initial(std::size_t n) {
+		std::vector<double> u(n);
+		for (std::size_t i = 0; i < n; i++)
+			u[i] = 8.0 + std::sin(0.7 * static_cast<double>(i));
+		return u;
+	}
+
+	std::vector<double> NBodyInitial(std::size_t bodies) {
+		std::vector<double> u(6 * bodies, 0.0);
+		for (std::size_t i = 0; i < bodies; i++) {
+			double angle = 2.0 * 3.14159265358979323846 * i / bodies;
+			u[3 * i] = std::cos(angle);
+			u[3 * i + 1] = std::sin(angle);
+			u[3 * i + 2] = 0.1 * std::sin(3.0 * angle);
+			u[3 * bodies + 3 * i] = -0.5 * std::sin(angle);
+			u[3 * bodies + 3 * i + 1] = 0.5 * std::cos(angle);
+		}
+		return u;
+	}
+
+	/*
+		Jacobiana por diferenças finitas progressivas: N + 1 avaliações.
+	*/
+	template <typename System>
+	void FiniteDifferenceJacobian(
+		System& system,
+		double t,
+		std::vector<double>& u,
+		std::vector<double>& jacobian,
+		std::vector<double>& dudt,
+		std::vector<double>& dudtPerturbed)
+	{
+		std::size_t uSize = u.size();
+		const double sqrtEpsilon = std::sqrt(DBL_EPSILON);
+		system(t, u, dudt);
+		for (std::size_t j = 0; j < uSize; j++) {
+			double uj = u[j];
+			double delta = sqrtEpsilon * std::max(1.0, std::abs(uj));
+			u[j] = uj + delta;
+			system(t, u, dudtPerturbed);
+			u[j] = uj;
+			for (std::size_t i = 0; i < uSize; i++)
+				jacobian[i * uSize + j] = (dudtPerturbed[i] - dudt[i]) / delta;
+		}
+	}
+
+	/*
+		Tempo de uma avaliação de system em double, para expressar o custo
+		da Jacobiana em avaliações equivalentes.
+	*/
+	template <typename System>
+	double RhsNanoseconds(System& system, std::vector<double>& u) {
+		std::vector<double> dudt(u.size());
+		std::size_t repetitions = std::max<std::size_t>(10, 1000000 / (u.size() + 1));
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (std::size_t r = 0; r < repetitions; r++) {
+			system(0.0, u, dudt);
+			u[0] += 1e-300 * dudt[0];
+		}
+		return std::chrono::duration<double, std::nano>(
+			std::chrono::steady_clock::now() - start).count() / repetitions;
+	}
+
+	/*
+		Lanes = 0 indica diferenças finitas. fd_error é a maior diferença entre
+		a Jacobiana por diferenças finitas e a obtida com números duais,
+		relativa ao maior elemento.
+	*/
+	template <std::size_t Lanes, typename System>
+	void JacobianBenchmark(Benchmark::State& state, System system, std::vector<double> u) {
+		std::size_t uSize = u.size();
+		std::vector<double> jacobian(uSize * uSize), exact(uSize * uSize);
+		std::vector<double> dudt(uSize), dudtPerturbed(uSize);
+		AutoDiff::Jacobian<4>(system, 0.0, u, exact);
+		double rhsNanoseconds = RhsNanoseconds(system, u);
+
+		AutoDiff::JacobianEvaluator<(Lanes > 0) ? Lanes : 1> evaluator(uSize);
+		while (state.KeepRunning()) {
+			if (Lanes == 0)
+				FiniteDifferenceJacobian(system, 0.0, u, jacobian, dudt, dudtPerturbed);
+			else
+				evaluator.Evaluate(system, 0.0, u, jacobian);
+		}
+
+		double maximum = 0.0, difference = 0.0;
+		std::vector<double> approximate(uSize * uSize);
+		FiniteDifferenceJacobian(system, 0.0, u, approximate, dudt, dudtPerturbed);
+		for (std::size_t k = 0; k < exact.size(); k++) {
+			maximum = std::max(maximum, std::abs(exact[k]));
+			difference = std::max(difference, std::abs(approximate[k] - exact[k]));
+		}
+
+		double jacobianNanoseconds = state.RealTime() / static_cast<double>(state.Iterations());
+		state.counters["n"] = static_cast<double>(uSize);
+		state.counters["evaluations"] =
+			static_cast<double>((Lanes == 0) ? uSize + 1 : evaluator.Passes());
+		state.counters["rhs_equivalents"] = jacobianNanoseconds / rhsNanoseconds;
+		state.counters["fd_error"] = difference / maximum;
+	}
+
+	template <typename System>
+	void RegisterJacobian(const std::string& name, System system, std::vector<double> u) {
+		Benchmark::Register("Jacobian/FiniteDifferences/" + name,
+			[system, u](Benchmark::State& state) { JacobianBenchmark<0>(state, system, u); });
+		Benchmark::Register("Jacobian/Dual4/" + name,
+			[system, u](Benchmark::State& state) { JacobianBenchmark<4>(state, system, u); });
+		Benchmark::Register("Jacobian/Dual8/" + name,
+			[system, u](Benchmark::State& state) { JacobianBenchmark<8>(state, system, u); });
+		Benchmark::Register("Jacobian/Dual16/" + name,
+			[system, u](Benchmark::State& state) { JacobianBenchmark<16>(state, system, u); });
+	}
+}
+
+void RegisterAutoDiffBenchmarks()
+{
+	RegisterJacobian("Lorenz/n:3", LorenzSystem(), { 1.0, 1.0, 1.0 });
+	for (std::size_t n : { 10, 100, 1000 })
+		RegisterJacobian("Lorenz96/n:" + std::to_string(n), Lorenz96System(), Lorenz96Initial(n));
+	for (std::size_t bodies : { 4, 16 }) {
+		RegisterJacobian("NBody/n:" + std::to_string(6 * bodies),
+			NBodySystem{ bodies }, NBodyInitial(bodies));
+	}
+}
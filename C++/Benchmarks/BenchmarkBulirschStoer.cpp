@@ -0,0 +1,204 @@
+/**
+* @file BenchmarkBulirschStoer.cpp
+* @brief Diagramas trabalho-precisão de Bulirsch-Stoer e Cash-Karp
+*/
+
+#include "Benchmark.hpp"
+#include "Problems.hpp"
+#include "BulirschStoer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <sstream>
+
+namespace {
+	std::string ToleranceName(double tolerance) {
+		std::ostringstream name;
+		name << "tol:" << tolerance;
+		return name.str();
+	}
+
+	enum class Method { CashKarp, BulirschStoer };
+
+	/*
+		Integração completa; o observador guarda apenas o ponto final. As
+		chamadas a dynFun são contadas por fora, para os dois métodos e
+		qualquer valor de CASHKARP_STATISTICS. Os passos aceitos são os
+		retornados pelo método.
+	*/
+	CashKarp::IntegrationStatistics Solve(
+		Problems::Problem& problem,
+		Method method,
+		double tolerance,
+		ThreadPool::ThreadPool* pool,
+		std::vector<double>& uFinal,
+		double* meanColumn = nullptr)
+	{
+		std::size_t evaluations = 0;
+		Problems::DynamicFunction countingFun = [&](
+			double t,
+			std::vector<double>& u,
+			std::vector<double>& dudt)
+		{
+			evaluations++;
+			problem.dynFun(t, u, dudt);
+		};
+		Problems::DynamicFunction& dynFun = (pool == nullptr) ? countingFun : problem.dynFun;
+		std::function<void(double, std::vector<double>&)> observer =
+			[&uFinal](double t, std::vector<double>& u) { uFinal = u; };
+
+		CashKarp::IntegrationStatistics statistics;
+		if (method == Method::CashKarp) {
+			statistics = CashKarp::CashKarpRange(
+				problem.uInitial, problem.tSpan, tolerance,
+				problem.initialStep, 0.0, problem.maximumNumberOfSteps,
+				dynFun, observer);
+			statistics.rhsEvaluations = evaluations;
+		}
+		else {
+			BulirschStoer::BulirschStoerOptions options;
+			options.pool = pool;
+			BulirschStoer::BulirschStoerStatistics result = BulirschStoer::BulirschStoerRange(
+				problem.uInitial, problem.tSpan, tolerance,
+				problem.initialStep, 0.0, problem.maximumNumberOfSteps,
+				dynFun, observer, options);
+			statistics = result.integration;
+			if (meanColumn != nullptr)
+				*meanColumn = result.meanColumn;
+		}
+		return statistics;
+	}
+
+	/*
+		Tempo médio de uma integração sem threads, repetida por ao menos
+		0,1 s, para comparar os dois métodos fora do laço de State.
+	*/
+	double MeanSeconds(Problems::Problem& problem, Method method, double tolerance) {
+		std::vector<double> uFinal;
+		std::size_t repetitions = 0;
+		double seconds = 0.0;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		while (repetitions == 0 || seconds < 0.1) {
+			Solve(problem, method, tolerance, nullptr, uFinal);
+			repetitions++;
+			seconds = std::chrono::duration<double>(
+				std::chrono::steady_clock::now() - start).count();
+		}
+		return seconds / repetitions;
+	}
+
+	/*
+		Um ponto do diagrama trabalho-precisão: erro em relação à referência
+		do problema e chamadas a dynFun. Com threads, o erro e as chamadas
+		são os da versão sem threads (o resultado é idêntico); o contador
+		difference confirma isso.
+
+		Sem threads, Bulirsch-Stoer é comparado a Cash-Karp com o mesmo erro,
+		como em BenchmarkNystrom.cpp: a tolerância de Cash-Karp parte de 100
+		vezes a de Bulirsch-Stoer e é reduzida (fator 10^(1/4), até 1e-13)
+		até que seu erro seja no máximo o de Bulirsch-Stoer, que com a mesma
+		tolerância pode ser maior que o de Cash-Karp. cashkarp_error e cashkarp_tolerance são os de
+		Cash-Karp nesse ponto; rhs_vs_cashkarp e time_vs_cashkarp são as
+		razões entre as chamadas e os tempos dos dois métodos (menores que 1
+		quando Bulirsch-Stoer é mais eficiente).
+	*/
+	void WorkPrecisionBenchmark(
+		Benchmark::State& state,
+		Problems::Problem& problem,
+		Method method,
+		double tolerance,
+		std::size_t threads)
+	{
+		std::unique_ptr<ThreadPool::ThreadPool> pool;
+		if (threads > 0)
+			pool.reset(new ThreadPool::ThreadPool(threads));
+
+		std::vector<double> uFinal, uThreaded;
+		CashKarp::IntegrationStatistics statistics;
+		double meanColumn = 0.0, difference = 0.0;
+		try {
+			statistics = Solve(problem, method, tolerance, nullptr, uFinal, &meanColumn);
+			if (pool) {
+				Solve(problem, method, tolerance, pool.get(), uThreaded);
+				for (std::size_t i = 0; i < uFinal.size(); i++)
+					difference = std::max(difference, std::abs(uFinal[i] - uThreaded[i]));
+			}
+		}
+		catch (const char* message) {
+			state.SkipWithError(message);
+			return;
+		}
+
+		double error = Problems::ErrorNorm(problem, uFinal);
+		bool compare = (method == Method::BulirschStoer && !pool);
+		double cashKarpTolerance = tolerance, cashKarpError = 0.0;
+		double rhsRatio = 0.0, timeRatio = 0.0;
+		if (compare) {
+			std::vector<double> cashKarpFinal;
+			CashKarp::IntegrationStatistics cashKarpStatistics;
+			for (int k = -8; tolerance * std::pow(10.0, -0.25 * k) >= 0.999e-13; k++) {
+				cashKarpTolerance = tolerance * std::pow(10.0, -0.25 * k);
+				cashKarpStatistics = Solve(
+					problem, Method::CashKarp, cashKarpTolerance, nullptr, cashKarpFinal);
+				cashKarpError = Problems::ErrorNorm(problem, cashKarpFinal);
+				if (cashKarpError <= error)
+					break;
+			}
+			rhsRatio = static_cast<double>(statistics.rhsEvaluations) /
+				static_cast<double>(cashKarpStatistics.rhsEvaluations);
+			timeRatio = MeanSeconds(problem, method, tolerance) /
+				MeanSeconds(problem, Method::CashKarp, cashKarpTolerance);
+		}
+
+		while (state.KeepRunning())
+			Solve(problem, method, tolerance, pool.get(), uThreaded);
+
+		state.counters["tolerance"] = tolerance;
+		state.counters["error"] = error;
+		state.counters["rhs_evaluations"] = static_cast<double>(statistics.rhsEvaluations);
+		state.counters["accepted_steps"] = static_cast<double>(statistics.acceptedSteps);
+		state.counters["rejected_steps"] = static_cast<double>(statistics.rejectedSteps);
+		if (method == Method::BulirschStoer)
+			state.counters["mean_column"] = meanColumn;
+		if (pool)
+			state.counters["difference"] = difference;
+		if (compare) {
+			state.counters["cashkarp_error"] = cashKarpError;
+			state.counters["cashkarp_tolerance"] = cashKarpTolerance;
+			state.counters["rhs_vs_cashkarp"] = rhsRatio;
+			state.counters["time_vs_cashkarp"] = timeRatio;
+		}
+	}
+}
+
+void RegisterBulirschStoerBenchmarks()
+{
+	/*
+		Problemas suaves com referência; as tolerâncias vão até 1e-12. As
+		referências não vêm de nenhum dos dois métodos em double: Arenstorf
+		tem solução exata, e as demais são de Cash-Karp em long double
+		(Problems.cpp). N corpos, com referência de Bulirsch-Stoer, não é
+		avaliado.
+	*/
+	for (Problems::Problem& problem : Problems::StandardProblems()) {
+		if (problem.uReference.empty() || problem.name.rfind("NBody", 0) == 0)
+			continue;
+
+		for (double tolerance : { 1e-6, 1e-8, 1e-10, 1e-12 }) {
+			std::string suffix = "/" + problem.name + "/" + ToleranceName(tolerance);
+			Benchmark::Register("WorkPrecision/CashKarp" + suffix,
+				[&problem, tolerance](Benchmark::State& state) {
+					WorkPrecisionBenchmark(state, problem, Method::CashKarp, tolerance, 0);
+				});
+			Benchmark::Register("WorkPrecision/BulirschStoer" + suffix,
+				[&problem, tolerance](Benchmark::State& state) {
+					WorkPrecisionBenchmark(state, problem, Method::BulirschStoer, tolerance, 0);
+				});
+			Benchmark::Register("WorkPrecision/BulirschStoer/threads:4" + suffix,
+				[&problem, tolerance](Benchmark::State& state) {
+					WorkPrecisionBenchmark(state, problem, Method::BulirschStoer, tolerance, 4);
+				});
+		}
+	}
+}
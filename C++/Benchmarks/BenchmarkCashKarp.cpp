@@ -0,0 +1,250 @@
+/**
+* @file BenchmarkCashKarp.cpp
+* @brief Benchmarks do método de Cash-Karp e do método da Secante
+*/
+
+#include "Benchmark.hpp"
+#include "Problems.hpp"
+#include "CashKarp.hpp"
+#include "CashKarpTrace.hpp"
+#include "Secant.hpp"
+#include <cmath>
+#include <sstream>
+
+namespace {
+	/*
+		Representação curta da tolerância para o nome do benchmark,
+		por exemplo "tol:1e-06".
+	*/
+	std::string ToleranceName(double tolerance) {
+		std::ostringstream name;
+		name << "tol:" << tolerance;
+		return name.str();
+	}
+
+	/*
+		Integração completa do problema, retornando as estatísticas.
+		Se a instrumentação tiver sido removida na compilação
+		(CASHKARP_STATISTICS igual a 0), as chamadas à função são contadas
+		envolvendo dynFun em outra função, e os passos são deduzidos delas.
+	*/
+	CashKarp::IntegrationStatistics CountedRange(
+		Problems::Problem& problem,
+		double tolerance,
+		std::vector<double>& tValues,
+		std::vector<std::vector<double>>& uValues)
+	{
+#if CASHKARP_STATISTICS
+		return CashKarp::CashKarpRange(
+			problem.uInitial, problem.tSpan, tolerance,
+			problem.initialStep, 0.0, problem.maximumNumberOfSteps,
+			problem.dynFun, tValues, uValues);
+#else
+		CashKarp::IntegrationStatistics statistics;
+		Problems::DynamicFunction countingFun = [&](
+			double t,
+			std::vector<double>& u,
+			std::vector<double>& dudt)
+		{
+			statistics.rhsEvaluations++;
+			problem.dynFun(t, u, dudt);
+		};
+		CashKarp::CashKarpRange(
+			problem.uInitial, problem.tSpan, tolerance,
+			problem.initialStep, 0.0, problem.maximumNumberOfSteps,
+			countingFun, tValues, uValues);
+
+		/*
+			Cada passo aceito calcula dudt uma vez em CashKarpRange, e cada
+			tentativa em CashKarpQualityStep realiza 5 chamadas.
+		*/
+		statistics.acceptedSteps = tValues.size() - 1;
+		statistics.rejectedSteps =
+			(statistics.rhsEvaluations - statistics.acceptedSteps) / 5 -
+			statistics.acceptedSteps;
+		return statistics;
+#endif
+	}
+
+	/*
+		Integração completa do problema em seu intervalo.
+		Os contadores são obtidos em uma execução separada, fora da medição
+		de tempo.
+	*/
+	void RangeBenchmark(
+		Benchmark::State& state,
+		Problems::Problem& problem,
+		double tolerance)
+	{
+		std::vector<double> tValues;
+		std::vector<std::vector<double>> uValues;
+		CashKarp::IntegrationStatistics statistics;
+
+		try {
+			statistics = CountedRange(problem, tolerance, tValues, uValues);
+		}
+		catch (const char* message) {
+			state.SkipWithError(message);
+			return;
+		}
+
+		double accepted = static_cast<double>(statistics.acceptedSteps);
+		double error = Problems::ErrorNorm(problem, uValues.back());
+
+		while (state.KeepRunning()) {
+			CashKarp::CashKarpRange(
+				problem.uInitial, problem.tSpan, tolerance,
+				problem.initialStep, 0.0, problem.maximumNumberOfSteps,
+				problem.dynFun, tValues, uValues);
+		}
+
+		state.counters["tolerance"] = tolerance;
+		state.counters["error"] = error;
+		state.counters["accepted_steps"] = accepted;
+		state.counters["rejected_steps"] =
+			static_cast<double>(statistics.rejectedSteps);
+		state.counters["rhs_evaluations"] =
+			static_cast<double>(statistics.rhsEvaluations);
+		state.counters["ns_per_step"] =
+			state.RealTime() / static_cast<double>(state.Iterations()) / accepted;
+#if CASHKARP_STATISTICS
+		state.counters["mean_step"] = statistics.MeanStep();
+#endif
+#if CASHKARP_STATISTICS >= 2
+		state.counters["rhs_cycle_fraction"] =
+			static_cast<double>(statistics.rhsCycles) /
+			static_cast<double>(statistics.rhsCycles + statistics.integratorCycles);
+#endif
+	}
+
+	/*
+		Integração completa registrando o histórico de passos, para medir o
+		custo do modo de rastreamento em relação a RangeBenchmark.
+	*/
+	void TraceBenchmark(
+		Benchmark::State& state,
+		Problems::Problem& problem,
+		double tolerance)
+	{
+		std::vector<double> tValues;
+		std::vector<std::vector<double>> uValues;
+		CashKarp::StepTrace trace(4096);
+		CashKarp::IntegrationStatistics statistics;
+
+		while (state.KeepRunning()) {
+			trace.Clear();
+			statistics = CashKarp::CashKarpRange(
+				problem.uInitial, problem.tSpan, tolerance,
+				problem.initialStep, 0.0, problem.maximumNumberOfSteps,
+				problem.dynFun, tValues, uValues, &trace);
+		}
+
+		double accepted = static_cast<double>(tValues.size() - 1);
+		state.counters["tolerance"] = tolerance;
+		state.counters["trace_records"] = static_cast<double>(trace.Size());
+		state.counters["ns_per_step"] =
+			state.RealTime() / static_cast<double>(state.Iterations()) / accepted;
+	}
+
+	/*
+		Um único passo (sem controle de erro) a partir do estado inicial.
+	*/
+	template <typename StepFunction>
+	void StepBenchmark(
+		Benchmark::State& state,
+		Problems::Problem& problem,
+		StepFunction step)
+	{
+		std::vector<double> u = problem.uInitial;
+		std::vector<double> dudt(u.size());
+		std::vector<double> uOutput(u.size());
+		std::vector<double> uError(u.size());
+		problem.dynFun(problem.tSpan.first, u, dudt);
+
+		while (state.KeepRunning()) {
+			step(
+				u, dudt, problem.tSpan.first, problem.initialStep,
+				uOutput, uError, problem.dynFun);
+		}
+
+		state.counters["rhs_evaluations"] = 5.0;
+		state.counters["ns_per_step"] =
+			state.RealTime() / static_cast<double>(state.Iterations());
+	}
+}
+
+void RegisterCashKarpBenchmarks()
+{
+	std::vector<Problems::Problem>& problems = Problems::StandardProblems();
+
+	for (Problems::Problem& problem : problems) {
+
+		Benchmark::Register(
+			"CashKarpStep/" + problem.name,
+			[&problem](Benchmark::State& state) {
+				StepBenchmark(state, problem, CashKarp::CashKarpStep);
+			});
+
+		if (problem.uInitial.size() <= 4) {
+			Benchmark::Register(
+				"CashKarpStepAVX2/" + problem.name,
+				[&problem](Benchmark::State& state) {
+					StepBenchmark(state, problem, CashKarp::CashKarpStepAVX2);
+				});
+		}
+
+		/*
+			Varredura de tolerâncias, para os diagramas trabalho-precisão.
+			O intervalo longo de Blasius utiliza apenas a tolerância de main.cpp.
+		*/
+		std::vector<double> tolerances = { 1e-4, 1e-6, 1e-8, 1e-10 };
+		if (problem.name == "BlasiusLong")
+			tolerances = { 1e-5 };
+
+		for (double tolerance : tolerances) {
+			Benchmark::Register(
+				"CashKarpRange/" + problem.name + "/" + ToleranceName(tolerance),
+				[&problem, tolerance](Benchmark::State& state) {
+					RangeBenchmark(state, problem, tolerance);
+				});
+		}
+
+		Benchmark::Register(
+			"CashKarpRangeTrace/" + problem.name + "/" + ToleranceName(tolerances[0]),
+			[&problem, tolerances](Benchmark::State& state) {
+				TraceBenchmark(state, problem, tolerances[0]);
+			});
+	}
+
+	/*
+		Método da Secante: equação de Kepler (função barata, mede o custo
+		do próprio método) e o método do tiro para a equação de Blasius,
+		encontrando u''(0) tal que u'(10) = 1.
+	*/
+	Benchmark::Register("Secant/Kepler", [](Benchmark::State& state) {
+		std::function<double(double)> kepler = [](double E) {
+			return E - 0.5 * std::sin(E) - 1.0;
+		};
+		double root = 0.0;
+		while (state.KeepRunning())
+			root = secant(kepler, 0.5, 1.5, 1e-12, 100);
+		state.counters["root"] = root;
+	});
+
+	Benchmark::Register("Secant/BlasiusShooting", [&problems](Benchmark::State& state) {
+		Problems::Problem& problem = problems[0];
+		std::vector<double> tValues;
+		std::vector<std::vector<double>> uValues;
+		std::function<double(double)> shooting = [&](double curvature) {
+			std::vector<double> uInitial = { 0.0, 0.0, curvature };
+			CashKarp::CashKarpRange(
+				uInitial, problem.tSpan, 1e-8, problem.initialStep,
+				0.0, 1000000, problem.dynFun, tValues, uValues);
+			return uValues.back()[1] - 1.0;
+		};
+		double root = 0.0;
+		while (state.KeepRunning())
+			root = secant(shooting, 0.3, 0.4, 1e-8, 100);
+		state.counters["root"] = root;
+	});
+}
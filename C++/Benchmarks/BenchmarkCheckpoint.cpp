@@ -0,0 +1,71 @@
+/**
+* @file BenchmarkCheckpoint.cpp
+* @brief Benchmarks do custo de gravar checkpoints durante a integração
+*/
+
+#include "Benchmark.hpp"
+#include "Problems.hpp"
+#include "CashKarp.hpp"
+#include <cstdio>
+
+namespace {
+	/*
+		Integração gravando um checkpoint a cada interval passos aceitos.
+		Comparar com CashKarpRange/... para obter o custo dos checkpoints.
+	*/
+	void CheckpointBenchmark(
+		Benchmark::State& state,
+		Problems::Problem& problem,
+		double tolerance,
+		std::size_t interval)
+	{
+		CashKarp::CheckpointOptions checkpoint;
+		checkpoint.path = "benchmark_checkpoint.bin";
+		checkpoint.interval = interval;
+
+		std::size_t steps = 0;
+		std::function<void(double, std::vector<double>&)> observer =
+			[&steps](double t, std::vector<double>& u) {
+				steps++;
+			};
+
+		try {
+			while (state.KeepRunning()) {
+				steps = 0;
+				CashKarp::IntegratorState integratorState =
+					CashKarp::CashKarpInitialState(
+						problem.uInitial, problem.tSpan, problem.initialStep);
+				CashKarp::CashKarpRange(
+					integratorState, problem.tSpan, tolerance, 0.0,
+					problem.maximumNumberOfSteps, problem.dynFun,
+					observer, &checkpoint);
+			}
+		}
+		catch (const char* message) {
+			state.SkipWithError(message);
+		}
+		std::remove(checkpoint.path.c_str());
+
+		double accepted = static_cast<double>(steps - 1);
+		state.counters["tolerance"] = tolerance;
+		state.counters["checkpoints"] = static_cast<double>(steps / interval);
+		state.counters["ns_per_step"] =
+			state.RealTime() / static_cast<double>(state.Iterations()) / accepted;
+	}
+}
+
+void RegisterCheckpointBenchmarks()
+{
+	for (Problems::Problem& problem : Problems::StandardProblems()) {
+		if (problem.name != "Lorenz" && problem.name != "NBody64")
+			continue;
+		for (std::size_t interval : { 10, 100 }) {
+			Benchmark::Register(
+				"CashKarpRangeCheckpoint/" + problem.name +
+				"/tol:1e-08/interval:" + std::to_string(interval),
+				[&problem, interval](Benchmark::State& state) {
+					CheckpointBenchmark(state, problem, 1e-8, interval);
+				});
+		}
+	}
+}
@@ -0,0 +1,256 @@
+/**
+* @file BenchmarkDelay.cpp
+* @brief Benchmarks de equações com atraso e do custo de consulta ao histórico
+*/
+
+#include "Benchmark.hpp"
+#include "Delay.hpp"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace {
+	std::string ToleranceName(double tolerance) {
+		std::ostringstream name;
+		name << "tol:" << tolerance;
+		return name.str();
+	}
+
+	/*
+		Problema com atrasos constantes. Sem initialHistory, o histórico
+		inicial é constante (uInitial).
+	*/
+	struct DelayProblem {
+		std::string name;
+		std::vector<double> uInitial;
+		Delay::InitialHistory initialHistory;
+		std::vector<double> delays;
+		std::pair<double, double> tSpan;
+		Delay::DelayFunction dynFun;
+		// Solução exata em tSpan.second; vazia se não houver
+		std::vector<double> uExact;
+	};
+
+	/*
+		u'(t) = -u(t - 1), u = 1 para t <= 0. Pelo método dos passos, em [2, 3]
+		u(t) = 1 - t + (t - 1)^2 / 2 - (t - 2)^3 / 6, logo u(3) = -1/6.
+		A derivada segunda é descontínua em t = 1 e a terceira em t = 2.
+		A solução é polinomial (de grau até 3) entre as descontinuidades,
+		portanto a interpolação do histórico é exata.
+	*/
+	DelayProblem DelayedDecay() {
+		DelayProblem problem;
+		problem.name = "DelayedDecay";
+		problem.uInitial = { 1.0 };
+		problem.delays = { 1.0 };
+		problem.tSpan = { 0.0, 3.0 };
+		problem.dynFun = [](double t, std::vector<double>& u, std::vector<double>& uDelayed, std::vector<double>& dudt) {
+			dudt[0] = -uDelayed[0];
+		};
+		problem.uExact = { -1.0 / 6.0 };
+		return problem;
+	}
+
+	/*
+		u'(t) = -u(t - 1), u = cos(t) para t <= 0. Pelo método dos passos,
+		u(t) = 1 - sin(1) - sin(t - 1) em [0, 1] e, em [1, 2],
+		u(t) = (1 - sin(1)) (2 - t) + cos(1) - cos(t - 2), logo
+		u(2) = cos(1) - 1. Em [1, 2] os valores atrasados vêm do histórico,
+		que não é polinomial: o erro da interpolação aparece no resultado.
+	*/
+	DelayProblem CosineHistory() {
+		DelayProblem problem;
+		problem.name = "CosineHistory";
+		problem.uInitial = { 1.0 };
+		problem.initialHistory = [](double t, std::vector<double>& u) {
+			u[0] = std::cos(t);
+		};
+		problem.delays = { 1.0 };
+		problem.tSpan = { 0.0, 2.0 };
+		problem.dynFun = [](double t, std::vector<double>& u, std::vector<double>& uDelayed, std::vector<double>& dudt) {
+			dudt[0] = -uDelayed[0];
+		};
+		problem.uExact = { std::cos(1.0) - 1.0 };
+		return problem;
+	}
+
+	/*
+		Equação de Mackey-Glass (beta = 0.2, gamma = 0.1, n = 10, tau = 17),
+		com solução caótica.
+	*/
+	DelayProblem MackeyGlass() {
+		DelayProblem problem;
+		problem.name = "MackeyGlass";
+		problem.uInitial = { 0.5 };
+		problem.delays = { 17.0 };
+		problem.tSpan = { 0.0, 300.0 };
+		problem.dynFun = [](double t, std::vector<double>& u, std::vector<double>& uDelayed, std::vector<double>& dudt) {
+			double delayed = uDelayed[0];
+			double delayed2 = delayed * delayed;
+			double delayed4 = delayed2 * delayed2;
+			double delayed10 = delayed4 * delayed4 * delayed2;
+			dudt[0] = 0.2 * delayed / (1.0 + delayed10) - 0.1 * u[0];
+		};
+		return problem;
+	}
+
+	/*
+		Equação logística com atraso (Hutchinson), u' = r u(t) (1 - u(t - 1))
+		com r = 1.8: oscilação periódica estável.
+	*/
+	DelayProblem Hutchinson() {
+		DelayProblem problem;
+		problem.name = "Hutchinson";
+		problem.uInitial = { 0.5 };
+		problem.delays = { 1.0 };
+		problem.tSpan = { 0.0, 100.0 };
+		problem.dynFun = [](double t, std::vector<double>& u, std::vector<double>& uDelayed, std::vector<double>& dudt) {
+			dudt[0] = 1.8 * u[0] * (1.0 - uDelayed[0]);
+		};
+		return problem;
+	}
+
+	/*
+		Sistema linear com dois atrasos incomensuráveis (1 e sqrt(2)), cujas
+		descontinuidades se combinam (t_0 + tau_1 + tau_2, ...).
+	*/
+	DelayProblem TwoDelays() {
+		DelayProblem problem;
+		problem.name = "TwoDelays";
+		problem.uInitial = { 1.0, 0.0 };
+		problem.delays = { 1.0, std::sqrt(2.0) };
+		problem.tSpan = { 0.0, 20.0 };
+		problem.dynFun = [](double t, std::vector<double>& u, std::vector<double>& uDelayed, std::vector<double>& dudt) {
+			// uDelayed[k * 2 + i] = u_i(t - tau_k)
+			dudt[0] = u[1];
+			dudt[1] = -u[0] - 0.3 * uDelayed[1] + 0.2 * uDelayed[2];
+		};
+		return problem;
+	}
+
+	CashKarp::IntegrationStatistics Solve(
+		DelayProblem& problem,
+		double tolerance,
+		std::vector<double>& uFinal,
+		Delay::HistoryStatistics* historyStatistics = nullptr)
+	{
+		std::vector<double> uInitial = problem.uInitial;
+		Delay::InitialHistory initialHistory = problem.initialHistory;
+		if (!initialHistory) {
+			initialHistory = [&uInitial](double t, std::vector<double>& u) {
+				u = uInitial;
+			};
+		}
+		std::function<void(double, std::vector<double>&)> observer =
+			[&uFinal](double t, std::vector<double>& u) { uFinal = u; };
+		return Delay::DelayRange(
+			uInitial, initialHistory, problem.delays, problem.tSpan, tolerance,
+			1e-3, 0.0, 10000000, problem.dynFun, observer, historyStatistics);
+	}
+
+	/*
+		Integração completa. O erro é medido em relação à solução exata ou,
+		na falta dela, a uma integração com tolerância 1e-12, que não revela
+		erros da interpolação do histórico (ver CosineHistory).
+	*/
+	void RangeBenchmark(Benchmark::State& state, DelayProblem problem, double tolerance) {
+		std::vector<double> uFinal, uReference = problem.uExact;
+		Delay::HistoryStatistics historyStatistics;
+		CashKarp::IntegrationStatistics statistics;
+		try {
+			if (uReference.empty())
+				Solve(problem, 1e-12, uReference);
+			statistics = Solve(problem, tolerance, uFinal, &historyStatistics);
+		}
+		catch (const char* message) {
+			state.SkipWithError(message);
+			return;
+		}
+
+		double error = 0.0;
+		for (std::size_t i = 0; i < uFinal.size(); i++)
+			error = std::max(error, std::abs(uFinal[i] - uReference[i]));
+
+		while (state.KeepRunning())
+			Solve(problem, tolerance, uFinal);
+
+		double evaluations = static_cast<double>(statistics.rhsEvaluations);
+		state.counters["error"] = error;
+		state.counters["accepted_steps"] = static_cast<double>(statistics.acceptedSteps);
+		state.counters["history_nodes"] = static_cast<double>(historyStatistics.largestSize);
+		state.counters["lookups_per_rhs"] = static_cast<double>(historyStatistics.lookups) / evaluations;
+		state.counters["search_fraction"] =
+			static_cast<double>(historyStatistics.searches) /
+			static_cast<double>(std::max<std::uint64_t>(1, historyStatistics.lookups));
+		state.counters["ns_per_rhs"] =
+			state.RealTime() / static_cast<double>(state.Iterations()) / evaluations;
+	}
+
+	/*
+		Custo de uma consulta ao histórico com nodes nós de 4 variáveis.
+		Sequential imita um atraso constante (instantes crescentes, com
+		cursor); Random consulta instantes aleatórios (busca binária).
+	*/
+	void LookupBenchmark(Benchmark::State& state, std::size_t nodes, bool sequential) {
+		const std::size_t systemSize = 4;
+		const double dt = 0.01;
+		Delay::History history(systemSize, 1e300, 0.0,
+			[](double t, std::vector<double>& u) { std::fill(u.begin(), u.end(), 1.0); });
+		std::vector<double> u(systemSize), dudt(systemSize);
+		for (std::size_t k = 0; k < nodes; k++) {
+			double t = dt * static_cast<double>(k);
+			for (std::size_t i = 0; i < systemSize; i++) {
+				u[i] = std::sin(t + static_cast<double>(i));
+				dudt[i] = std::cos(t + static_cast<double>(i));
+			}
+			history.Push(t, u, dudt);
+		}
+
+		const std::size_t lookups = 1000;
+		double tLast = dt * static_cast<double>(nodes - 1);
+		double t = 0.0, sum = 0.0;
+		std::uint64_t random = 12345, cursor = 0;
+		std::vector<double> output(systemSize);
+		while (state.KeepRunning()) {
+			for (std::size_t l = 0; l < lookups; l++) {
+				if (sequential) {
+					// Três consultas por intervalo, como os estágios de um passo
+					t += 0.37 * dt;
+					if (t > tLast)
+						t = 0.0;
+				}
+				else {
+					random = random * 6364136223846793005ULL + 1442695040888963407ULL;
+					t = tLast * static_cast<double>(random >> 11) * (1.0 / 9007199254740992.0);
+				}
+				history.Evaluate(t, output.data(), cursor);
+				sum += output[0];
+			}
+		}
+
+		state.counters["nodes"] = static_cast<double>(nodes);
+		state.counters["ns_per_lookup"] =
+			state.RealTime() / static_cast<double>(state.Iterations() * lookups);
+		state.counters["search_fraction"] =
+			static_cast<double>(history.Searches()) / static_cast<double>(history.Lookups());
+		state.counters["checksum"] = sum;
+	}
+}
+
+void RegisterDelayBenchmarks()
+{
+	for (std::size_t nodes : { 64, 4096, 262144 }) {
+		std::string suffix = "/nodes:" + std::to_string(nodes);
+		Benchmark::Register("Delay/Lookup/Sequential" + suffix,
+			[nodes](Benchmark::State& state) { LookupBenchmark(state, nodes, true); });
+		Benchmark::Register("Delay/Lookup/Random" + suffix,
+			[nodes](Benchmark::State& state) { LookupBenchmark(state, nodes, false); });
+	}
+
+	for (const DelayProblem& problem : { DelayedDecay(), CosineHistory(), MackeyGlass(), Hutchinson(), TwoDelays() }) {
+		for (double tolerance : { 1e-6, 1e-9 }) {
+			Benchmark::Register("Delay/Range/" + problem.name + "/" + ToleranceName(tolerance),
+				[problem, tolerance](Benchmark::State& state) { RangeBenchmark(state, problem, tolerance); });
+		}
+	}
+}
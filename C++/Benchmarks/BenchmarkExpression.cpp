@@ -0,0 +1,251 @@
+/**
+* @file BenchmarkExpression.cpp
+* @brief Benchmarks de sistemas definidos em texto contra funções compiladas
+*/
+
+#include "Benchmark.hpp"
+#include "Problems.hpp"
+#include "CashKarp.hpp"
+#include "Expression.hpp"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <sstream>
+
+namespace {
+	std::string ToleranceName(double tolerance) {
+		std::ostringstream name;
+		name << "tol:" << tolerance;
+		return name.str();
+	}
+
+	/*
+		Mesmos sistemas de Problems.cpp, escritos na linguagem de Expression.
+	*/
+	const char* blasiusSource =
+		"state f, fp, fpp\n"
+		"parameter a = -1 / 2\n"
+		"f' = fp\n"
+		"fp' = fpp\n"
+		"fpp' = a * f * fpp\n";
+
+	const char* lorenzSource =
+		"state x, y, z\n"
+		"parameter sigma = 10, rho = 28, beta = 8 / 3\n"
+		"x' = sigma * (y - x)\n"
+		"y' = x * (rho - z) - y\n"
+		"z' = x * y - beta * z\n";
+
+	/*
+		As subexpressões (x + mu) e y * y aparecem várias vezes e são
+		calculadas uma única vez.
+	*/
+	const char* arenstorfSource =
+		"state x, y, vx, vy\n"
+		"parameter mu = 0.012277471\n"
+		"let mu2 = 1 - mu\n"
+		"let d1 = pow((x + mu) * (x + mu) + y * y, 1.5)\n"
+		"let d2 = pow((x - mu2) * (x - mu2) + y * y, 1.5)\n"
+		"x' = vx\n"
+		"y' = vy\n"
+		"vx' = x + 2 * vy - mu2 * (x + mu) / d1 - mu * (x - mu2) / d2\n"
+		"vy' = y - 2 * vx - mu2 * y / d1 - mu * y / d2\n";
+
+	// Quantidade de sistemas de Lorenz independentes no conjunto
+	const std::size_t ensembleSize = 1024;
+
+	/*
+		Conjunto de sistemas de Lorenz no formato SoA de EvaluateBatch,
+		escrito diretamente em C++.
+	*/
+	void LorenzEnsemble(double t, std::vector<double>& u, std::vector<double>& dudt) {
+		const double sigma = 10.0, rho = 28.0, beta = 8.0 / 3.0;
+		std::size_t count = u.size() / 3;
+		const double* x = u.data();
+		const double* y = x + count;
+		const double* z = y + count;
+		for (std::size_t k = 0; k < count; k++) {
+			dudt[k] = sigma * (y[k] - x[k]);
+			dudt[count + k] = x[k] * (rho - z[k]) - y[k];
+			dudt[2 * count + k] = x[k] * y[k] - beta * z[k];
+		}
+	}
+
+	std::vector<double> EnsembleInitial(std::size_t count) {
+		std::vector<double> u(3 * count);
+		for (std::size_t k = 0; k < count; k++) {
+			double offset = 0.01 * static_cast<double>(k) / static_cast<double>(count);
+			u[k] = 1.0 + offset;
+			u[count + k] = 1.0 - offset;
+			u[2 * count + k] = 1.0;
+		}
+		return u;
+	}
+
+	/*
+		Custo de uma avaliação de dynFun. Com expression verdadeiro, o
+		sistema compilado de source substitui dynFun.
+	*/
+	void CallBenchmark(
+		Benchmark::State& state,
+		Problems::DynamicFunction dynFun,
+		std::vector<double> u,
+		const char* source,
+		bool expression)
+	{
+		std::unique_ptr<Expression::System> system;
+		try {
+			system.reset(new Expression::System(source));
+		}
+		catch (const char* message) {
+			state.SkipWithError(message);
+			return;
+		}
+		if (expression)
+			dynFun = system->ToFunction();
+
+		const std::size_t calls = 1000;
+		std::vector<double> dudt(u.size());
+		while (state.KeepRunning()) {
+			for (std::size_t c = 0; c < calls; c++) {
+				dynFun(0.0, u, dudt);
+				u[0] += 1e-300 * dudt[0];
+			}
+		}
+
+		state.counters["instructions"] = static_cast<double>(system->InstructionCount());
+		state.counters["registers"] = static_cast<double>(system->RegisterCount());
+		state.counters["ns_per_call"] =
+			state.RealTime() / static_cast<double>(state.Iterations() * calls);
+	}
+
+	/*
+		Integração completa com CashKarpRange. difference é a maior
+		diferença entre a solução final com a função compilada e com o
+		sistema em texto.
+	*/
+	void RangeBenchmark(
+		Benchmark::State& state,
+		Problems::DynamicFunction dynFun,
+		std::vector<double> uInitial,
+		std::pair<double, double> tSpan,
+		double initialStep,
+		double tolerance,
+		Problems::DynamicFunction expressionFun,
+		bool expression)
+	{
+		std::vector<double> tValues;
+		std::vector<std::vector<double>> uValues;
+		CashKarp::CashKarpRange(uInitial, tSpan, tolerance, initialStep, 0.0,
+			10000000, dynFun, tValues, uValues);
+		std::vector<double> uCompiled = uValues.back();
+		CashKarp::CashKarpRange(uInitial, tSpan, tolerance, initialStep, 0.0,
+			10000000, expressionFun, tValues, uValues);
+
+		double difference = 0.0;
+		for (std::size_t i = 0; i < uCompiled.size(); i++)
+			difference = std::max(difference, std::abs(uCompiled[i] - uValues.back()[i]));
+
+		Problems::DynamicFunction& measured = expression ? expressionFun : dynFun;
+		while (state.KeepRunning()) {
+			CashKarp::CashKarpRange(uInitial, tSpan, tolerance, initialStep, 0.0,
+				10000000, measured, tValues, uValues);
+		}
+
+		state.counters["accepted_steps"] = static_cast<double>(tValues.size() - 1);
+		state.counters["difference"] = difference;
+		state.counters["ns_per_step"] =
+			state.RealTime() / static_cast<double>(state.Iterations()) /
+			static_cast<double>(tValues.size() - 1);
+	}
+
+	void RegisterProblem(Problems::Problem problem, const char* source) {
+		Benchmark::Register("Expression/Call/Lambda/" + problem.name,
+			[problem, source](Benchmark::State& state) {
+				CallBenchmark(state, problem.dynFun, problem.uInitial, source, false);
+			});
+		Benchmark::Register("Expression/Call/Bytecode/" + problem.name,
+			[problem, source](Benchmark::State& state) {
+				CallBenchmark(state, problem.dynFun, problem.uInitial, source, true);
+			});
+
+		Problems::DynamicFunction expressionFun = Expression::System(source).ToFunction();
+		for (double tolerance : { 1e-6, 1e-10 }) {
+			std::string suffix = problem.name + "/" + ToleranceName(tolerance);
+			Benchmark::Register("Expression/Range/Lambda/" + suffix,
+				[problem, expressionFun, tolerance](Benchmark::State& state) {
+					RangeBenchmark(state, problem.dynFun, problem.uInitial, problem.tSpan,
+						problem.initialStep, tolerance, expressionFun, false);
+				});
+			Benchmark::Register("Expression/Range/Bytecode/" + suffix,
+				[problem, expressionFun, tolerance](Benchmark::State& state) {
+					RangeBenchmark(state, problem.dynFun, problem.uInitial, problem.tSpan,
+						problem.initialStep, tolerance, expressionFun, true);
+				});
+		}
+	}
+}
+
+void RegisterExpressionBenchmarks()
+{
+	std::vector<Problems::Problem>& problems = Problems::StandardProblems();
+	for (Problems::Problem& problem : problems) {
+		if (problem.name == "Blasius")
+			RegisterProblem(problem, blasiusSource);
+		else if (problem.name == "Lorenz")
+			RegisterProblem(problem, lorenzSource);
+		else if (problem.name == "Arenstorf")
+			RegisterProblem(problem, arenstorfSource);
+	}
+
+	/*
+		Conjunto de sistemas: cada instrução do bytecode é aplicada a
+		BatchWidth sistemas por vez.
+	*/
+	std::string ensembleName = "LorenzEnsemble/n:" + std::to_string(ensembleSize);
+	Problems::DynamicFunction ensembleFun = LorenzEnsemble;
+	Problems::DynamicFunction ensembleExpression =
+		Expression::System(lorenzSource).ToEnsembleFunction(ensembleSize);
+	Problems::DynamicFunction ensembleScalar = [](
+		double t,
+		std::vector<double>& u,
+		std::vector<double>& dudt)
+	{
+		// Uma avaliação escalar por sistema, sem o processamento em lotes
+		static thread_local Expression::System system(lorenzSource);
+		static thread_local std::vector<double> uSystem(3), dudtSystem(3);
+		for (std::size_t k = 0; k < ensembleSize; k++) {
+			for (std::size_t i = 0; i < 3; i++)
+				uSystem[i] = u[i * ensembleSize + k];
+			system.Evaluate(t, uSystem, dudtSystem);
+			for (std::size_t i = 0; i < 3; i++)
+				dudt[i * ensembleSize + k] = dudtSystem[i];
+		}
+	};
+	std::vector<double> ensembleInitial = EnsembleInitial(ensembleSize);
+
+	Benchmark::Register("Expression/Call/Lambda/" + ensembleName,
+		[ensembleFun, ensembleInitial](Benchmark::State& state) {
+			CallBenchmark(state, ensembleFun, ensembleInitial, lorenzSource, false);
+		});
+	Benchmark::Register("Expression/Call/Scalar/" + ensembleName,
+		[ensembleScalar, ensembleInitial](Benchmark::State& state) {
+			CallBenchmark(state, ensembleScalar, ensembleInitial, lorenzSource, false);
+		});
+	Benchmark::Register("Expression/Call/Bytecode/" + ensembleName,
+		[ensembleExpression, ensembleInitial](Benchmark::State& state) {
+			CallBenchmark(state, ensembleExpression, ensembleInitial, lorenzSource, false);
+		});
+
+	std::pair<double, double> tSpan = { 0.0, 1.0 };
+	Benchmark::Register("Expression/Range/Lambda/" + ensembleName + "/" + ToleranceName(1e-8),
+		[ensembleFun, ensembleExpression, ensembleInitial, tSpan](Benchmark::State& state) {
+			RangeBenchmark(state, ensembleFun, ensembleInitial, tSpan, 1e-3, 1e-8,
+				ensembleExpression, false);
+		});
+	Benchmark::Register("Expression/Range/Bytecode/" + ensembleName + "/" + ToleranceName(1e-8),
+		[ensembleFun, ensembleExpression, ensembleInitial, tSpan](Benchmark::State& state) {
+			RangeBenchmark(state, ensembleFun, ensembleInitial, tSpan, 1e-3, 1e-8,
+				ensembleExpression, true);
+		});
+}
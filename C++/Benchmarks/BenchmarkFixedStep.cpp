@@ -0,0 +1,169 @@
+/**
+* @file BenchmarkFixedStep.cpp
+* @brief Benchmarks dos métodos de Runge-Kutta de passo constante
+*/
+
+#include "Benchmark.hpp"
+#include "Problems.hpp"
+#include "CashKarp.hpp"
+#include "FixedStep.hpp"
+#include <cmath>
+
+namespace {
+	/*
+		Um único passo do método a partir do estado inicial, para comparar com
+		CashKarpStep/... (que realiza 5 chamadas à função por passo).
+	*/
+	template <typename Method>
+	void FixedStepBenchmark(
+		Benchmark::State& state,
+		Problems::Problem& problem)
+	{
+		FixedStep::Integrator<Method> integrator(problem.uInitial.size());
+		std::vector<double> u = problem.uInitial;
+
+		while (state.KeepRunning()) {
+			u = problem.uInitial;
+			integrator.Step(problem.dynFun, problem.tSpan.first, problem.initialStep, u);
+		}
+
+		state.counters["rhs_evaluations"] = static_cast<double>(Method::stages);
+		state.counters["ns_per_step"] =
+			state.RealTime() / static_cast<double>(state.Iterations());
+	}
+
+	/*
+		Erro no final do intervalo com numberOfSteps passos iguais.
+	*/
+	template <typename Method>
+	double FixedStepError(
+		Problems::Problem& problem,
+		std::size_t numberOfSteps,
+		std::vector<double>& uValues)
+	{
+		FixedStep::Integrator<Method> integrator(problem.uInitial.size());
+		integrator.Range(problem.dynFun, problem.uInitial, problem.tSpan, numberOfSteps, uValues);
+		std::vector<double> uLast(
+			uValues.end() - problem.uInitial.size(), uValues.end());
+		/*
+			Passos grandes demais podem divergir; um estado não finito é
+			tratado como erro infinito.
+		*/
+		for (double value : uLast) {
+			if (!std::isfinite(value))
+				return INFINITY;
+		}
+		return Problems::ErrorNorm(problem, uLast);
+	}
+
+	/*
+		Integração completa com a quantidade de passos que iguala o erro de
+		CashKarpRange na mesma tolerância. A quantidade de passos é
+		procurada (dobrando e depois por bisseção) fora da medição de tempo.
+	*/
+	template <typename Method>
+	void MatchedRangeBenchmark(
+		Benchmark::State& state,
+		Problems::Problem& problem,
+		double tolerance)
+	{
+		std::vector<double> tValues;
+		std::vector<std::vector<double>> uValues;
+		double cashKarpError;
+		try {
+			CashKarp::CashKarpRange(
+				problem.uInitial, problem.tSpan, tolerance,
+				problem.initialStep, 0.0, problem.maximumNumberOfSteps,
+				problem.dynFun, tValues, uValues);
+			cashKarpError = Problems::ErrorNorm(problem, uValues.back());
+		}
+		catch (const char* message) {
+			state.SkipWithError(message);
+			return;
+		}
+
+		std::vector<double> trajectory;
+		std::size_t maximumNumberOfSteps = 1 << 22;
+		std::size_t upper = 16;
+		while (FixedStepError<Method>(problem, upper, trajectory) > cashKarpError) {
+			upper *= 2;
+			if (upper > maximumNumberOfSteps) {
+				state.SkipWithError("Precisão de CashKarpRange não alcançada.");
+				return;
+			}
+		}
+		std::size_t lower = upper / 2;
+		while (upper - lower > 1) {
+			std::size_t middle = (lower + upper) / 2;
+			if (FixedStepError<Method>(problem, middle, trajectory) > cashKarpError)
+				lower = middle;
+			else
+				upper = middle;
+		}
+		std::size_t numberOfSteps = upper;
+		double error = FixedStepError<Method>(problem, numberOfSteps, trajectory);
+
+		/*
+			A trajetória e os vetores do integrador são reaproveitados:
+			nenhuma alocação dentro do laço medido.
+		*/
+		FixedStep::Integrator<Method> integrator(problem.uInitial.size());
+		while (state.KeepRunning()) {
+			integrator.Range(
+				problem.dynFun, problem.uInitial, problem.tSpan,
+				numberOfSteps, trajectory);
+		}
+
+		state.counters["tolerance"] = tolerance;
+		state.counters["error"] = error;
+		state.counters["ck_error"] = cashKarpError;
+		state.counters["ck_accepted_steps"] = static_cast<double>(tValues.size() - 1);
+		state.counters["steps"] = static_cast<double>(numberOfSteps);
+		state.counters["rhs_evaluations"] =
+			static_cast<double>(numberOfSteps * Method::stages);
+		state.counters["ns_per_step"] =
+			state.RealTime() / static_cast<double>(state.Iterations()) /
+			static_cast<double>(numberOfSteps);
+	}
+}
+
+void RegisterFixedStepBenchmarks()
+{
+	for (Problems::Problem& problem : Problems::StandardProblems()) {
+		Benchmark::Register("FixedStep/Euler/" + problem.name,
+			[&problem](Benchmark::State& state) {
+				FixedStepBenchmark<FixedStep::ExplicitEuler>(state, problem);
+			});
+		Benchmark::Register("FixedStep/Heun/" + problem.name,
+			[&problem](Benchmark::State& state) {
+				FixedStepBenchmark<FixedStep::HeunMethod>(state, problem);
+			});
+		Benchmark::Register("FixedStep/Midpoint/" + problem.name,
+			[&problem](Benchmark::State& state) {
+				FixedStepBenchmark<FixedStep::MidpointMethod>(state, problem);
+			});
+		Benchmark::Register("FixedStep/RK4/" + problem.name,
+			[&problem](Benchmark::State& state) {
+				FixedStepBenchmark<FixedStep::RungeKutta4>(state, problem);
+			});
+		Benchmark::Register("FixedStep/Ralston/" + problem.name,
+			[&problem](Benchmark::State& state) {
+				FixedStepBenchmark<FixedStep::RungeKuttaRalston>(state, problem);
+			});
+
+		/*
+			Comparação com CashKarpRange/<problema>/tol:1e-08 na mesma precisão.
+			Problemas sem solução de referência não permitem a comparação.
+		*/
+		if (problem.uReference.empty())
+			continue;
+		Benchmark::Register("FixedStepRange/RK4/" + problem.name + "/tol:1e-08",
+			[&problem](Benchmark::State& state) {
+				MatchedRangeBenchmark<FixedStep::RungeKutta4>(state, problem, 1e-8);
+			});
+		Benchmark::Register("FixedStepRange/Ralston/" + problem.name + "/tol:1e-08",
+			[&problem](Benchmark::State& state) {
+				MatchedRangeBenchmark<FixedStep::RungeKuttaRalston>(state, problem, 1e-8);
+			});
+	}
+}
@@ -0,0 +1,158 @@
+/**
+* @file BenchmarkLargeSystem.cpp
+* @brief Benchmarks de sistemas muito grandes (método das linhas)
+*/
+
+#include "Benchmark.hpp"
+#include "CashKarp.hpp"
+#include "CashKarpParallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <thread>
+
+namespace {
+	const double tolerance = 1e-6;
+	const double diffusion = 0.1;
+	const double growth = 1.0;
+	const double pi = 3.14159265358979323846;
+
+	/*
+		Equação de Fisher-KPP, du/dt = D * d2u/dx2 + r * u * (1 - u),
+		discretizada em n pontos de uma malha periódica com espaçamento
+		unitário. Calcula dudt[begin, end); as extremidades são tratadas fora
+		do laço, para que este seja vetorizado.
+	*/
+	template <typename Vector>
+	void FisherKPP(const Vector& u, Vector& dudt, std::size_t begin, std::size_t end) {
+		std::size_t n = u.size();
+		auto point = [&](std::size_t i, double left, double right) {
+			dudt[i] = diffusion * (left - 2.0 * u[i] + right) + growth * u[i] * (1.0 - u[i]);
+		};
+		if (begin == 0) {
+			point(0, u[n - 1], u[1 % n]);
+			begin = 1;
+		}
+		bool last = (end == n && begin < end);
+		if (last)
+			end--;
+		for (std::size_t i = begin; i < end; i++)
+			point(i, u[i - 1], u[i + 1]);
+		if (last)
+			point(n - 1, u[n - 2], u[0]);
+	}
+
+	std::vector<double> InitialState(std::size_t n) {
+		std::vector<double> u(n);
+		for (std::size_t i = 0; i < n; i++) {
+			double x = static_cast<double>(i) / static_cast<double>(n);
+			u[i] = 0.5 + 0.4 * std::sin(2.0 * pi * 8.0 * x) + 0.05 * std::sin(2.0 * pi * 1000.0 * x);
+		}
+		return u;
+	}
+
+	/*
+		Integração de referência, com CashKarpRange (uma thread, vetores
+		intermediários alocados a cada passo).
+	*/
+	void SerialBenchmark(Benchmark::State& state, std::size_t n) {
+		std::vector<double> uInitial = InitialState(n);
+		std::pair<double, double> tSpan(0.0, 5.0);
+		std::function<void(double, std::vector<double>&, std::vector<double>&)> dynFun =
+			[](double t, std::vector<double>& u, std::vector<double>& dudt) {
+				FisherKPP(u, dudt, 0, u.size());
+			};
+		std::size_t steps = 0;
+		std::function<void(double, std::vector<double>&)> observer =
+			[&steps](double t, std::vector<double>& u) { steps++; };
+
+		CashKarp::IntegrationStatistics statistics;
+		while (state.KeepRunning()) {
+			steps = 0;
+			statistics = CashKarp::CashKarpRange(
+				uInitial, tSpan, tolerance, 1e-2, 0.0, 100000, dynFun, observer);
+		}
+
+		state.counters["n"] = static_cast<double>(n);
+		state.counters["steps"] = static_cast<double>(steps - 1);
+		state.counters["rejected_steps"] = static_cast<double>(statistics.rejectedSteps);
+		state.counters["ns_per_step"] =
+			state.RealTime() / static_cast<double>(state.Iterations() * (steps - 1));
+	}
+
+	/*
+		CashKarp::Parallel::CashKarpRange com a quantidade de threads
+		indicada. difference é a maior diferença, ao final, em relação a
+		CashKarpRange.
+	*/
+	void ParallelBenchmark(Benchmark::State& state, std::size_t n, std::size_t threads) {
+		std::vector<double> uInitial = InitialState(n);
+		std::pair<double, double> tSpan(0.0, 5.0);
+
+		std::vector<double> uSerial;
+		std::function<void(double, std::vector<double>&, std::vector<double>&)> serialFun =
+			[](double t, std::vector<double>& u, std::vector<double>& dudt) {
+				FisherKPP(u, dudt, 0, u.size());
+			};
+		std::function<void(double, std::vector<double>&)> serialObserver =
+			[&uSerial, &tSpan](double t, std::vector<double>& u) {
+				if (t == tSpan.second)
+					uSerial = u;
+			};
+		CashKarp::CashKarpRange(
+			uInitial, tSpan, tolerance, 1e-2, 0.0, 100000, serialFun, serialObserver);
+
+		ThreadPool::ThreadPool pool(threads);
+		CashKarp::Parallel::PartitionedFunction dynFun =
+			[](double t, ThreadPool::Vector& u, ThreadPool::Vector& dudt,
+				std::size_t begin, std::size_t end) {
+				FisherKPP(u, dudt, begin, end);
+			};
+		std::size_t steps = 0;
+		double difference = 0.0;
+		std::function<void(double, ThreadPool::Vector&)> observer =
+			[&](double t, ThreadPool::Vector& u) {
+				steps++;
+				if (t == tSpan.second && uSerial.size() == u.size()) {
+					difference = 0.0;
+					for (std::size_t i = 0; i < n; i++)
+						difference = std::max(difference, std::abs(u[i] - uSerial[i]));
+				}
+			};
+
+		CashKarp::IntegrationStatistics statistics;
+		while (state.KeepRunning()) {
+			steps = 0;
+			statistics = CashKarp::Parallel::CashKarpRange(
+				uInitial, tSpan, tolerance, 1e-2, 0.0, 100000, dynFun, observer, pool);
+		}
+
+		state.counters["n"] = static_cast<double>(n);
+		state.counters["threads"] = static_cast<double>(pool.Size());
+		state.counters["steps"] = static_cast<double>(steps - 1);
+		state.counters["rejected_steps"] = static_cast<double>(statistics.rejectedSteps);
+		state.counters["ns_per_step"] =
+			state.RealTime() / static_cast<double>(state.Iterations() * (steps - 1));
+		state.counters["difference"] = difference;
+	}
+}
+
+void RegisterLargeSystemBenchmarks()
+{
+	std::size_t hardwareThreads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+	for (std::size_t n : { 1 << 16, 1 << 20 }) {
+		Benchmark::Register(
+			"LargeSystem/CashKarp/FisherKPP/n:" + std::to_string(n),
+			[n](Benchmark::State& state) { SerialBenchmark(state, n); });
+
+		std::vector<std::size_t> threadCounts = { 1 };
+		if (hardwareThreads > 1)
+			threadCounts.push_back(hardwareThreads);
+		for (std::size_t threads : threadCounts) {
+			Benchmark::Register(
+				"LargeSystem/Parallel/FisherKPP/n:" + std::to_string(n) +
+				"/threads:" + std::to_string(threads),
+				[n, threads](Benchmark::State& state) { ParallelBenchmark(state, n, threads); });
+		}
+	}
+}
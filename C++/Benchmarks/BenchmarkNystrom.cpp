@@ -0,0 +1,265 @@
+/**
+* @file BenchmarkNystrom.cpp
+* @brief Pares de Runge-Kutta-Nyström contra Cash-Karp na forma de primeira ordem
+*/
+
+#include "Benchmark.hpp"
+#include "Problems.hpp"
+#include "Nystrom.hpp"
+#include "BulirschStoer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace {
+	std::string ToleranceName(double tolerance) {
+		std::ostringstream name;
+		name << "tol:" << tolerance;
+		return name.str();
+	}
+
+	/*
+		Sistema u'' = f(t, u, u'). A forma de primeira ordem, com estado
+		(u, v), é a entregue a CashKarpRange.
+	*/
+	struct SecondOrderProblem {
+		std::string name;
+		std::vector<double> uInitial;
+		std::vector<double> vInitial;
+		std::pair<double, double> tSpan;
+		double initialStep;
+		Nystrom::SecondOrderFunction dynFun;
+		// f depende de u': Nystrom64 não se aplica
+		bool dependsOnVelocity;
+		// (u, v) em tSpan.second, calculado uma única vez quando necessário
+		std::vector<double> reference;
+	};
+
+	/*
+		Pêndulo simples com amplitude de 3 rad (perto da separatriz), em
+		[0, 50].
+	*/
+	SecondOrderProblem Pendulum() {
+		SecondOrderProblem problem;
+		problem.name = "Pendulum";
+		problem.uInitial = { 3.0 };
+		problem.vInitial = { 0.0 };
+		problem.tSpan = { 0.0, 50.0 };
+		problem.initialStep = 1e-3;
+		problem.dependsOnVelocity = false;
+		problem.dynFun = [](
+			double t,
+			std::vector<double>& u,
+			std::vector<double>& v,
+			std::vector<double>& d2udt2)
+		{
+			d2udt2[0] = -std::sin(u[0]);
+		};
+		return problem;
+	}
+
+	/*
+		Pêndulo amortecido e forçado: a força depende de u', o que exige o
+		par CashKarp54.
+	*/
+	SecondOrderProblem DampedPendulum() {
+		SecondOrderProblem problem = Pendulum();
+		problem.name = "DampedPendulum";
+		problem.dependsOnVelocity = true;
+		problem.dynFun = [](
+			double t,
+			std::vector<double>& u,
+			std::vector<double>& v,
+			std::vector<double>& d2udt2)
+		{
+			d2udt2[0] = -std::sin(u[0]) - 0.2 * v[0] + 1.2 * std::cos(0.7 * t);
+		};
+		return problem;
+	}
+
+	/*
+		Problems::NBody já guarda as posições seguidas das velocidades:
+		u'' é a segunda metade de sua derivada.
+	*/
+	SecondOrderProblem NBody(std::size_t bodies) {
+		Problems::Problem firstOrder = Problems::NBody(bodies);
+		std::size_t half = 3 * bodies;
+
+		SecondOrderProblem problem;
+		problem.name = firstOrder.name;
+		problem.uInitial.assign(firstOrder.uInitial.begin(), firstOrder.uInitial.begin() + half);
+		problem.vInitial.assign(firstOrder.uInitial.begin() + half, firstOrder.uInitial.end());
+		problem.tSpan = firstOrder.tSpan;
+		problem.initialStep = firstOrder.initialStep;
+		problem.dependsOnVelocity = false;
+
+		Problems::DynamicFunction firstOrderFun = firstOrder.dynFun;
+		std::vector<double> state(2 * half), derivative(2 * half);
+		problem.dynFun = [=](
+			double t,
+			std::vector<double>& u,
+			std::vector<double>& v,
+			std::vector<double>& d2udt2) mutable
+		{
+			std::copy(u.begin(), u.end(), state.begin());
+			std::copy(v.begin(), v.end(), state.begin() + half);
+			firstOrderFun(t, state, derivative);
+			std::copy(derivative.begin() + half, derivative.end(), d2udt2.begin());
+		};
+		return problem;
+	}
+
+	std::vector<SecondOrderProblem>& SecondOrderProblems() {
+		static std::vector<SecondOrderProblem> problems = {
+			Pendulum(), DampedPendulum(), NBody(16) };
+		return problems;
+	}
+
+	// BulirschStoer: apenas para a referência
+	enum class Method { CashKarp, Nystrom64, CashKarp54, BulirschStoer };
+
+	/*
+		Integração completa, devolvendo (u, v) final e as chamadas a
+		dynFun, contadas por fora para qualquer valor de CASHKARP_STATISTICS.
+		CashKarp e BulirschStoer integram a forma de primeira ordem; cada
+		chamada calcula f uma vez, como nos pares de Nyström.
+	*/
+	std::size_t Solve(
+		SecondOrderProblem& problem,
+		Method method,
+		double tolerance,
+		std::vector<double>& solution)
+	{
+		std::size_t evaluations = 0, size = problem.uInitial.size();
+		Nystrom::SecondOrderFunction countingFun = [&](
+			double t,
+			std::vector<double>& u,
+			std::vector<double>& v,
+			std::vector<double>& d2udt2)
+		{
+			evaluations++;
+			problem.dynFun(t, u, v, d2udt2);
+		};
+
+		if (method == Method::CashKarp || method == Method::BulirschStoer) {
+			std::vector<double> uInitial = problem.uInitial, u(size), v(size), d2udt2(size);
+			uInitial.insert(uInitial.end(), problem.vInitial.begin(), problem.vInitial.end());
+			Problems::DynamicFunction firstOrderFun = [&](
+				double t,
+				std::vector<double>& state,
+				std::vector<double>& dudt)
+			{
+				std::copy(state.begin(), state.begin() + size, u.begin());
+				std::copy(state.begin() + size, state.end(), v.begin());
+				countingFun(t, u, v, d2udt2);
+				std::copy(v.begin(), v.end(), dudt.begin());
+				std::copy(d2udt2.begin(), d2udt2.end(), dudt.begin() + size);
+			};
+			std::function<void(double, std::vector<double>&)> observer =
+				[&solution](double t, std::vector<double>& state) { solution = state; };
+			if (method == Method::CashKarp) {
+				CashKarp::CashKarpRange(
+					uInitial, problem.tSpan, tolerance, problem.initialStep, 0.0,
+					10000000, firstOrderFun, observer);
+			}
+			else {
+				BulirschStoer::BulirschStoerRange(
+					uInitial, problem.tSpan, tolerance, problem.initialStep, 0.0,
+					10000000, firstOrderFun, observer);
+			}
+		}
+		else {
+			Nystrom::StepObserver observer = [&solution](
+				double t,
+				std::vector<double>& u,
+				std::vector<double>& v)
+			{
+				solution = u;
+				solution.insert(solution.end(), v.begin(), v.end());
+			};
+			Nystrom::NystromRange(
+				problem.uInitial, problem.vInitial, problem.tSpan, tolerance,
+				problem.initialStep, 0.0, 10000000, countingFun, observer,
+				(method == Method::Nystrom64)
+				? Nystrom::Method::Nystrom64
+				: Nystrom::Method::CashKarp54);
+		}
+		return evaluations;
+	}
+
+	double Error(SecondOrderProblem& problem, const std::vector<double>& solution) {
+		double error = 0.0;
+		for (std::size_t i = 0; i < solution.size(); i++)
+			error = std::max(error, std::abs(solution[i] - problem.reference[i]));
+		return error;
+	}
+
+	/*
+		Erro em u e v em relação à referência (Bulirsch-Stoer com tolerância
+		1e-14, independente dos métodos comparados) e chamadas a dynFun. Como
+		o erro de cada método varia com a tolerância de forma diferente, a
+		comparação é feita com o mesmo erro: a tolerância de Cash-Karp na
+		forma de primeira ordem é reduzida (fator 10^(1/4), até 1e-13) até que
+		seu erro seja no máximo o do método, e rhs_vs_cashkarp é a razão entre
+		as chamadas dos dois.
+	*/
+	void NystromBenchmark(
+		Benchmark::State& state,
+		SecondOrderProblem& problem,
+		Method method,
+		double tolerance)
+	{
+		std::vector<double> solution, cashKarpSolution;
+		std::size_t evaluations, cashKarpEvaluations = 0;
+		double error;
+		try {
+			if (problem.reference.empty())
+				Solve(problem, Method::BulirschStoer, 1e-14, problem.reference);
+			evaluations = Solve(problem, method, tolerance, solution);
+			error = Error(problem, solution);
+
+			for (int k = 0; tolerance * std::pow(10.0, -0.25 * k) >= 0.999e-13; k++) {
+				double cashKarpTolerance = tolerance * std::pow(10.0, -0.25 * k);
+				cashKarpEvaluations = Solve(problem, Method::CashKarp, cashKarpTolerance, cashKarpSolution);
+				if (Error(problem, cashKarpSolution) <= error)
+					break;
+			}
+		}
+		catch (const char* message) {
+			state.SkipWithError(message);
+			return;
+		}
+
+		while (state.KeepRunning())
+			Solve(problem, method, tolerance, solution);
+
+		state.counters["tolerance"] = tolerance;
+		state.counters["error"] = error;
+		state.counters["rhs_evaluations"] = static_cast<double>(evaluations);
+		state.counters["rhs_vs_cashkarp"] =
+			static_cast<double>(evaluations) / static_cast<double>(cashKarpEvaluations);
+	}
+}
+
+void RegisterNystromBenchmarks()
+{
+	for (SecondOrderProblem& problem : SecondOrderProblems()) {
+		for (double tolerance : { 1e-6, 1e-9, 1e-12 }) {
+			std::string suffix = "/" + problem.name + "/" + ToleranceName(tolerance);
+			Benchmark::Register("Nystrom/CashKarp" + suffix,
+				[&problem, tolerance](Benchmark::State& state) {
+					NystromBenchmark(state, problem, Method::CashKarp, tolerance);
+				});
+			if (!problem.dependsOnVelocity) {
+				Benchmark::Register("Nystrom/Nystrom64" + suffix,
+					[&problem, tolerance](Benchmark::State& state) {
+						NystromBenchmark(state, problem, Method::Nystrom64, tolerance);
+					});
+			}
+			Benchmark::Register("Nystrom/CashKarp54" + suffix,
+				[&problem, tolerance](Benchmark::State& state) {
+					NystromBenchmark(state, problem, Method::CashKarp54, tolerance);
+				});
+		}
+	}
+}
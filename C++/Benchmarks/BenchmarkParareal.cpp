@@ -0,0 +1,118 @@
+/**
+* @file BenchmarkParareal.cpp
+* @brief Benchmarks do algoritmo Parareal contra a integração sequencial
+*/
+
+#include "Benchmark.hpp"
+#include "Problems.hpp"
+#include "CashKarp.hpp"
+#include "Parareal.hpp"
+#include <chrono>
+#include <thread>
+
+namespace {
+	const double tolerance = 1e-8;
+
+	/*
+		Tempo da integração sequencial com CashKarpRange, na mesma tolerância
+		do propagador fino (melhor de três execuções).
+	*/
+	double SerialSeconds(Problems::Problem& problem, std::vector<double>& uLast) {
+		std::vector<double> tValues;
+		std::vector<std::vector<double>> uValues;
+		double best = 0.0;
+		for (int repetition = 0; repetition < 3; repetition++) {
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			CashKarp::CashKarpRange(
+				problem.uInitial, problem.tSpan, tolerance,
+				problem.initialStep, 0.0, problem.maximumNumberOfSteps,
+				problem.dynFun, tValues, uValues);
+			double seconds = std::chrono::duration<double>(
+				std::chrono::steady_clock::now() - start).count();
+			if (repetition == 0 || seconds < best)
+				best = seconds;
+		}
+		uLast = uValues.back();
+		return best;
+	}
+
+	/*
+		Parareal com o propagador grosseiro indicado. speedup é medido nesta
+		máquina; critical_path_speedup estima o ganho com um núcleo por fatia.
+	*/
+	void PararealBenchmark(
+		Benchmark::State& state,
+		Problems::Problem& problem,
+		Parareal::PararealOptions options)
+	{
+		std::vector<double> uSerial;
+		double serialSeconds = SerialSeconds(problem, uSerial);
+
+		Parareal::PararealResult result;
+		try {
+			while (state.KeepRunning()) {
+				result = Parareal::PararealRange(
+					problem.uInitial, problem.tSpan, tolerance,
+					problem.initialStep, problem.maximumNumberOfSteps,
+					problem.dynFun, options);
+			}
+		}
+		catch (const char* message) {
+			state.SkipWithError(message);
+			return;
+		}
+
+		double pararealSeconds =
+			state.RealTime() * 1e-9 / static_cast<double>(state.Iterations());
+		std::size_t threads = options.threads;
+		if (threads == 0)
+			threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+
+		state.counters["slices"] = static_cast<double>(options.slices);
+		state.counters["threads"] = static_cast<double>(threads);
+		state.counters["iterations"] = static_cast<double>(result.iterations);
+		state.counters["correction"] = result.correction;
+		state.counters["converged"] = result.converged ? 1.0 : 0.0;
+		state.counters["error"] = Problems::ErrorNorm(problem, result.uBoundaries.back());
+		state.counters["serial_error"] = Problems::ErrorNorm(problem, uSerial);
+		state.counters["fine_steps"] = static_cast<double>(result.fineSteps);
+		state.counters["serial_ns"] = serialSeconds * 1e9;
+		state.counters["speedup"] = serialSeconds / pararealSeconds;
+		state.counters["critical_path_speedup"] =
+			serialSeconds / result.criticalPathSeconds;
+	}
+}
+
+void RegisterPararealBenchmarks()
+{
+	for (Problems::Problem& problem : Problems::StandardProblems()) {
+		if (problem.uReference.empty())
+			continue;
+		for (std::size_t slices : { 4, 8, 16 }) {
+			Parareal::PararealOptions options;
+			options.slices = slices;
+			options.maximumIterations = slices;
+
+			/*
+				O propagador grosseiro precisa ser muito mais barato que o fino
+				em cada fatia, caso contrário as propagações sequenciais
+				dominam o tempo.
+			*/
+			options.coarse = Parareal::CoarsePropagator::RungeKutta4;
+			options.coarseSteps = 2;
+			Benchmark::Register(
+				"Parareal/RK4/" + problem.name + "/slices:" + std::to_string(slices),
+				[&problem, options](Benchmark::State& state) {
+					PararealBenchmark(state, problem, options);
+				});
+
+			options.coarse = Parareal::CoarsePropagator::CashKarp;
+			options.coarseTolerance = 1e-3;
+			Benchmark::Register(
+				"Parareal/CashKarp/" + problem.name + "/slices:" + std::to_string(slices),
+				[&problem, options](Benchmark::State& state) {
+					PararealBenchmark(state, problem, options);
+				});
+		}
+	}
+}
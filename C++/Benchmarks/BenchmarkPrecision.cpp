@@ -0,0 +1,318 @@
+/**
+* @file BenchmarkPrecision.cpp
+* @brief Benchmarks do método de Cash-Karp em double, float e precisão mista
+*/
+
+#include "Benchmark.hpp"
+#include "Problems.hpp"
+#include "CashKarpGeneric.hpp"
+#include "BulirschStoer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <sstream>
+
+namespace {
+	/*
+		Sistemas dos problemas padrão, escritos como templates para que as
+		contas sejam feitas no próprio tipo Scalar (e não convertidas para
+		double e de volta).
+	*/
+	struct BlasiusSystem {
+		template <typename Scalar, typename Precision>
+		void operator()(Precision t, std::vector<Scalar>& u, std::vector<Scalar>& dudt) const {
+			dudt[0] = u[1];
+			dudt[1] = u[2];
+			dudt[2] = static_cast<Scalar>(-0.5) * u[0] * u[2];
+		}
+	};
+
+	struct LorenzSystem {
+		template <typename Scalar, typename Precision>
+		void operator()(Precision t, std::vector<Scalar>& u, std::vector<Scalar>& dudt) const {
+			const Scalar sigma = 10.0, rho = 28.0, beta = static_cast<Scalar>(8.0 / 3.0);
+			dudt[0] = sigma * (u[1] - u[0]);
+			dudt[1] = u[0] * (rho - u[2]) - u[1];
+			dudt[2] = u[0] * u[1] - beta * u[2];
+		}
+	};
+
+	struct ArenstorfSystem {
+		template <typename Scalar, typename Precision>
+		void operator()(Precision t, std::vector<Scalar>& u, std::vector<Scalar>& dudt) const {
+			const Scalar mu = static_cast<Scalar>(0.012277471), mu2 = 1 - mu;
+			Scalar r1 = (u[0] + mu) * (u[0] + mu) + u[1] * u[1];
+			Scalar r2 = (u[0] - mu2) * (u[0] - mu2) + u[1] * u[1];
+			Scalar d1 = r1 * std::sqrt(r1);
+			Scalar d2 = r2 * std::sqrt(r2);
+			dudt[0] = u[2];
+			dudt[1] = u[3];
+			dudt[2] = u[0] + 2 * u[3] - mu2 * (u[0] + mu) / d1 - mu * (u[0] - mu2) / d2;
+			dudt[3] = u[1] - 2 * u[2] - mu2 * u[1] / d1 - mu * u[1] / d2;
+		}
+	};
+
+	struct VanDerPolSystem {
+		template <typename Scalar, typename Precision>
+		void operator()(Precision t, std::vector<Scalar>& u, std::vector<Scalar>& dudt) const {
+			const Scalar mu = 10.0;
+			dudt[0] = u[1];
+			dudt[1] = mu * (1 - u[0] * u[0]) * u[1] - u[0];
+		}
+	};
+
+	/*
+		Mesmo sistema de Problems::NBody (estado AoS: x, y, z de cada corpo).
+	*/
+	struct NBodySystem {
+		std::size_t bodies;
+
+		template <typename Scalar, typename Precision>
+		void operator()(Precision t, std::vector<Scalar>& u, std::vector<Scalar>& dudt) const {
+			const Scalar softening2 = static_cast<Scalar>(0.05 * 0.05);
+			const Scalar mass = static_cast<Scalar>(1.0 / static_cast<double>(bodies));
+			std::size_t n = 3 * bodies;
+			for (std::size_t i = 0; i < n; i++) {
+				dudt[i] = u[n + i];
+				dudt[n + i] = 0;
+			}
+			for (std::size_t i = 0; i < bodies; i++) {
+				for (std::size_t j = i + 1; j < bodies; j++) {
+					Scalar dx = u[3 * j] - u[3 * i];
+					Scalar dy = u[3 * j + 1] - u[3 * i + 1];
+					Scalar dz = u[3 * j + 2] - u[3 * i + 2];
+					Scalar d2 = dx * dx + dy * dy + dz * dz + softening2;
+					Scalar f = mass / (d2 * std::sqrt(d2));
+					dudt[n + 3 * i] += f * dx;
+					dudt[n + 3 * i + 1] += f * dy;
+					dudt[n + 3 * i + 2] += f * dz;
+					dudt[n + 3 * j] -= f * dx;
+					dudt[n + 3 * j + 1] -= f * dy;
+					dudt[n + 3 * j + 2] -= f * dz;
+				}
+			}
+		}
+	};
+
+	/*
+		Conjunto de sistemas de Lorenz independentes, em formato SoA
+		(x de todos os membros, depois y, depois z): o laço sobre os membros
+		é vetorizado, com 4 (double) ou 8 (float) membros por instrução AVX2.
+	*/
+	struct LorenzEnsembleSystem {
+		std::size_t members;
+
+		template <typename Scalar, typename Precision>
+		void operator()(Precision t, std::vector<Scalar>& u, std::vector<Scalar>& dudt) const {
+			const Scalar sigma = 10.0, rho = 28.0, beta = static_cast<Scalar>(8.0 / 3.0);
+			const Scalar* x = u.data();
+			const Scalar* y = x + members;
+			const Scalar* z = y + members;
+			Scalar* dx = dudt.data();
+			Scalar* dy = dx + members;
+			Scalar* dz = dy + members;
+			// Um laço por derivada, para que cada um seja vetorizado.
+			for (std::size_t m = 0; m < members; m++)
+				dx[m] = sigma * (y[m] - x[m]);
+			for (std::size_t m = 0; m < members; m++)
+				dy[m] = x[m] * (rho - z[m]) - y[m];
+			for (std::size_t m = 0; m < members; m++)
+				dz[m] = x[m] * y[m] - beta * z[m];
+		}
+	};
+
+	/*
+		Problema em double, convertido para Scalar em cada benchmark.
+	*/
+	struct PrecisionProblem {
+		std::string name;
+		std::vector<double> uInitial;
+		std::pair<double, double> tSpan;
+		double initialStep;
+		std::size_t maximumNumberOfSteps;
+		std::vector<double> uReference;
+	};
+
+	PrecisionProblem FromStandard(const std::string& name) {
+		for (Problems::Problem& problem : Problems::StandardProblems()) {
+			if (problem.name == name) {
+				return {
+					problem.name, problem.uInitial, problem.tSpan,
+					problem.initialStep, problem.maximumNumberOfSteps,
+					problem.uReference };
+			}
+		}
+		throw "Problema padrão inexistente.";
+	}
+
+	/*
+		Integração em Scalar/Precision, retornando o último estado em double.
+	*/
+	template <typename Scalar, typename Precision, typename System>
+	std::vector<double> FinalState(
+		PrecisionProblem& problem,
+		System& system,
+		double tolerance,
+		CashKarp::IntegrationStatistics& statistics)
+	{
+		std::vector<Scalar> uInitial(problem.uInitial.begin(), problem.uInitial.end());
+		std::pair<Precision, Precision> tSpan(
+			static_cast<Precision>(problem.tSpan.first),
+			static_cast<Precision>(problem.tSpan.second));
+		std::vector<double> uLast;
+		auto observer = [&uLast](Precision t, std::vector<Scalar>& u) {
+			uLast.assign(u.begin(), u.end());
+		};
+		statistics = CashKarp::Generic::CashKarpRange(
+			uInitial, tSpan, static_cast<Precision>(tolerance),
+			static_cast<Precision>(problem.initialStep), static_cast<Precision>(0.0),
+			problem.maximumNumberOfSteps, system, observer);
+		return uLast;
+	}
+
+	/*
+		Conjunto de 1024 sistemas de Lorenz com condições iniciais
+		ligeiramente diferentes, em [0, 2]. A referência é calculada com
+		BulirschStoerRange e tolerância 1e-14, método que este arquivo não
+		avalia.
+	*/
+	PrecisionProblem LorenzEnsemble(std::size_t members) {
+		PrecisionProblem problem;
+		problem.name = "LorenzEnsemble" + std::to_string(members);
+		problem.uInitial.resize(3 * members);
+		for (std::size_t m = 0; m < members; m++) {
+			double offset = static_cast<double>(m) / static_cast<double>(members);
+			problem.uInitial[m] = 1.0 + offset;
+			problem.uInitial[members + m] = 1.0 - offset;
+			problem.uInitial[2 * members + m] = 1.0 + 0.5 * offset;
+		}
+		problem.tSpan = { 0.0, 2.0 };
+		problem.initialStep = 1e-3;
+		problem.maximumNumberOfSteps = 10000000;
+
+		LorenzEnsembleSystem system{ members };
+		std::function<void(double, std::vector<double>&, std::vector<double>&)> dynFun =
+			[&system](double t, std::vector<double>& u, std::vector<double>& dudt) {
+				system(t, u, dudt);
+			};
+		std::function<void(double, std::vector<double>&)> lastState =
+			[&problem](double t, std::vector<double>& u) {
+				problem.uReference = u;
+			};
+		std::vector<double> uInitial = problem.uInitial;
+		BulirschStoer::BulirschStoerRange(
+			uInitial, problem.tSpan, 1e-14, problem.initialStep, 0.0,
+			problem.maximumNumberOfSteps, dynFun, lastState);
+		return problem;
+	}
+
+	double ErrorNorm(const PrecisionProblem& problem, const std::vector<double>& u) {
+		double error = 0.0;
+		for (std::size_t i = 0; i < u.size(); i++) {
+			double difference = std::abs(u[i] - problem.uReference[i]);
+			if (!std::isfinite(difference))
+				return INFINITY;
+			error = std::max(error, difference);
+		}
+		return error;
+	}
+
+	template <typename Scalar, typename Precision, typename System>
+	void PrecisionBenchmark(
+		Benchmark::State& state,
+		PrecisionProblem& problem,
+		System system,
+		double tolerance)
+	{
+		CashKarp::IntegrationStatistics statistics;
+		std::vector<double> uLast;
+		try {
+			uLast = FinalState<Scalar, Precision>(problem, system, tolerance, statistics);
+		}
+		catch (const char* message) {
+			state.SkipWithError(message);
+			return;
+		}
+
+		std::vector<Scalar> uInitial(problem.uInitial.begin(), problem.uInitial.end());
+		std::pair<Precision, Precision> tSpan(
+			static_cast<Precision>(problem.tSpan.first),
+			static_cast<Precision>(problem.tSpan.second));
+		std::size_t accepted = 0;
+		auto observer = [&accepted](Precision t, std::vector<Scalar>& u) {
+			accepted++;
+		};
+		while (state.KeepRunning()) {
+			accepted = 0;
+			CashKarp::Generic::CashKarpRange(
+				uInitial, tSpan, static_cast<Precision>(tolerance),
+				static_cast<Precision>(problem.initialStep), static_cast<Precision>(0.0),
+				problem.maximumNumberOfSteps, system, observer);
+		}
+		accepted--;
+
+		double nsPerStep =
+			state.RealTime() / static_cast<double>(state.Iterations()) /
+			static_cast<double>(accepted);
+		state.counters["tolerance"] = tolerance;
+		state.counters["error"] = ErrorNorm(problem, uLast);
+		state.counters["accepted_steps"] = static_cast<double>(accepted);
+#if CASHKARP_STATISTICS
+		state.counters["rejected_steps"] = static_cast<double>(statistics.rejectedSteps);
+		state.counters["rhs_evaluations"] = static_cast<double>(statistics.rhsEvaluations);
+#endif
+		state.counters["ns_per_step"] = nsPerStep;
+		state.counters["ns_per_equation_step"] =
+			nsPerStep / static_cast<double>(problem.uInitial.size());
+	}
+
+	std::string ToleranceName(double tolerance) {
+		std::ostringstream name;
+		name << "tol:" << tolerance;
+		return name.str();
+	}
+
+	/*
+		Registra as três variantes (double, float e precisão mista) para um
+		problema.
+	*/
+	template <typename System>
+	void RegisterProblem(PrecisionProblem& problem, System system) {
+		for (double tolerance : { 1e-4, 1e-6 }) {
+			std::string suffix = "/" + problem.name + "/" + ToleranceName(tolerance);
+			Benchmark::Register("CashKarpPrecision/double" + suffix,
+				[&problem, system, tolerance](Benchmark::State& state) {
+					PrecisionBenchmark<double, double>(state, problem, system, tolerance);
+				});
+			Benchmark::Register("CashKarpPrecision/float" + suffix,
+				[&problem, system, tolerance](Benchmark::State& state) {
+					PrecisionBenchmark<float, float>(state, problem, system, tolerance);
+				});
+			Benchmark::Register("CashKarpPrecision/mixed" + suffix,
+				[&problem, system, tolerance](Benchmark::State& state) {
+					PrecisionBenchmark<float, double>(state, problem, system, tolerance);
+				});
+		}
+	}
+}
+
+void RegisterPrecisionBenchmarks()
+{
+	/*
+		Os problemas são construídos uma única vez; as referências dos
+		problemas padrão são as mesmas de Problems::StandardProblems().
+	*/
+	static PrecisionProblem blasius = FromStandard("Blasius");
+	static PrecisionProblem lorenz = FromStandard("Lorenz");
+	static PrecisionProblem arenstorf = FromStandard("Arenstorf");
+	static PrecisionProblem vanDerPol = FromStandard("VanDerPol");
+	static PrecisionProblem nBody = FromStandard("NBody64");
+	static PrecisionProblem ensemble = LorenzEnsemble(1024);
+
+	RegisterProblem(blasius, BlasiusSystem());
+	RegisterProblem(lorenz, LorenzSystem());
+	RegisterProblem(arenstorf, ArenstorfSystem());
+	RegisterProblem(vanDerPol, VanDerPolSystem());
+	RegisterProblem(nBody, NBodySystem{ 64 });
+	RegisterProblem(ensemble, LorenzEnsembleSystem{ 1024 });
+}
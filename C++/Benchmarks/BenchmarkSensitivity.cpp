@@ -0,0 +1,369 @@
+/**
+* @file BenchmarkSensitivity.cpp
+* @brief Benchmarks do gradiente em relação a parâmetros: sensibilidades
+* contra diferenças finitas
+*/
+
+#include "Benchmark.hpp"
+#include "CashKarp.hpp"
+#include "Sensitivity.hpp"
+#include <cmath>
+#include <sstream>
+
+namespace {
+	/*
+		Problema de ajuste de parâmetros: o gradiente desejado é o da função
+		custo L(p) = 0.5 * |u(tSpan.second) - target|^2.
+	*/
+	struct ParameterProblem;
+	using AutomaticFunction = std::function<void(
+		ParameterProblem&,
+		double,
+		std::function<void(double, std::vector<double>&, std::vector<double>&)>&,
+		std::size_t&)>;
+
+	struct ParameterProblem {
+		std::string name;
+		std::vector<double> uInitial;
+		std::vector<double> parameters;
+		std::vector<double> target;
+		std::pair<double, double> tSpan;
+		Sensitivity::ParametricFunction dynFun;
+		Sensitivity::SensitivityFunction sensitivityFun;
+		/*
+			AutomaticSensitivityRange com o sistema em template, contando as
+			avaliações (com double e com números duais) em counter.
+		*/
+		AutomaticFunction automatic;
+	};
+
+	/*
+		Envolve um sistema em template para contar as avaliações, com
+		qualquer tipo de escalar.
+	*/
+	template <typename System>
+	struct CountedSystem {
+		System system;
+		std::size_t* counter;
+
+		template <typename Scalar>
+		void operator()(
+			double t,
+			std::vector<Scalar>& u,
+			std::vector<Scalar>& p,
+			std::vector<Scalar>& dudt) const
+		{
+			(*counter)++;
+			system(t, u, p, dudt);
+		}
+	};
+
+	/*
+		Preenche dynFun e automatic a partir do sistema em template.
+	*/
+	template <typename System>
+	void SetSystem(ParameterProblem& problem, System system) {
+		problem.dynFun =
+			[system](double t, std::vector<double>& u, std::vector<double>& p, std::vector<double>& dudt) {
+				system(t, u, p, dudt);
+			};
+		problem.automatic = [system](
+			ParameterProblem& target,
+			double tolerance,
+			std::function<void(double, std::vector<double>&, std::vector<double>&)>& observer,
+			std::size_t& counter)
+		{
+			CountedSystem<System> counted{ system, &counter };
+			std::vector<double> sensitivityInitial;
+			Sensitivity::AutomaticSensitivityRange<4>(
+				target.uInitial, sensitivityInitial, target.parameters, target.tSpan,
+				tolerance, 1e-3, 0.0, 1000000, counted, observer);
+		};
+	}
+
+	struct LotkaVolterraSystem {
+		template <typename Scalar>
+		void operator()(
+			double t,
+			std::vector<Scalar>& u,
+			std::vector<Scalar>& p,
+			std::vector<Scalar>& dudt) const
+		{
+			dudt[0] = p[0] * u[0] - p[1] * u[0] * u[1];
+			dudt[1] = p[2] * u[0] * u[1] - p[3] * u[1];
+		}
+	};
+
+	struct LorenzSystem {
+		template <typename Scalar>
+		void operator()(
+			double t,
+			std::vector<Scalar>& u,
+			std::vector<Scalar>& p,
+			std::vector<Scalar>& dudt) const
+		{
+			dudt[0] = p[0] * (u[1] - u[0]);
+			dudt[1] = u[0] * (p[1] - u[2]) - u[1];
+			dudt[2] = u[0] * u[1] - p[2] * u[2];
+		}
+	};
+
+	/*
+		Lotka-Volterra: x' = a * x - b * x * y, y' = d * x * y - g * y.
+	*/
+	ParameterProblem LotkaVolterra() {
+		ParameterProblem problem;
+		problem.name = "LotkaVolterra";
+		problem.uInitial = { 1.0, 1.0 };
+		problem.parameters = { 1.5, 1.0, 3.0, 1.0 };
+		problem.target = { 1.0, 1.0 };
+		problem.tSpan = { 0.0, 10.0 };
+		SetSystem(problem, LotkaVolterraSystem());
+		problem.sensitivityFun =
+			[](double t, std::vector<double>& u, std::vector<double>& p,
+				std::vector<double>& dudt, std::vector<double>& s, std::vector<double>& dsdt) {
+				double j00 = p[0] - p[1] * u[1], j01 = -p[1] * u[0];
+				double j10 = p[2] * u[1], j11 = p[2] * u[0] - p[3];
+				for (std::size_t j = 0; j < 4; j++) {
+					dsdt[2 * j] = j00 * s[2 * j] + j01 * s[2 * j + 1];
+					dsdt[2 * j + 1] = j10 * s[2 * j] + j11 * s[2 * j + 1];
+				}
+				dsdt[0] += u[0];
+				dsdt[2] -= u[0] * u[1];
+				dsdt[5] += u[0] * u[1];
+				dsdt[7] -= u[1];
+			};
+		return problem;
+	}
+
+	/*
+		Sistema de Lorenz com parâmetros sigma, rho e beta, em um intervalo
+		curto (as sensibilidades crescem exponencialmente no regime caótico).
+	*/
+	ParameterProblem Lorenz() {
+		ParameterProblem problem;
+		problem.name = "Lorenz";
+		problem.uInitial = { 1.0, 1.0, 1.0 };
+		problem.parameters = { 10.0, 28.0, 8.0 / 3.0 };
+		problem.target = { 0.0, 0.0, 25.0 };
+		problem.tSpan = { 0.0, 2.0 };
+		SetSystem(problem, LorenzSystem());
+		problem.sensitivityFun =
+			[](double t, std::vector<double>& u, std::vector<double>& p,
+				std::vector<double>& dudt, std::vector<double>& s, std::vector<double>& dsdt) {
+				for (std::size_t j = 0; j < 3; j++) {
+					const double* sj = s.data() + 3 * j;
+					double* dsj = dsdt.data() + 3 * j;
+					dsj[0] = p[0] * (sj[1] - sj[0]);
+					dsj[1] = (p[1] - u[2]) * sj[0] - sj[1] - u[0] * sj[2];
+					dsj[2] = u[1] * sj[0] + u[0] * sj[1] - p[2] * sj[2];
+				}
+				dsdt[0] += u[1] - u[0];
+				dsdt[4] += u[0];
+				dsdt[8] -= u[2];
+			};
+		return problem;
+	}
+
+	std::vector<ParameterProblem>& ParameterProblems() {
+		static std::vector<ParameterProblem> problems = { LotkaVolterra(), Lorenz() };
+		return problems;
+	}
+
+	std::string ToleranceName(double tolerance) {
+		std::ostringstream name;
+		name << "tol:" << tolerance;
+		return name.str();
+	}
+
+	/*
+		Resultado de um cálculo do gradiente.
+	*/
+	struct Gradient {
+		std::vector<double> values;
+		std::size_t rhsEvaluations = 0;
+		std::size_t acceptedSteps = 0;
+		std::size_t solves = 0;
+	};
+
+	/*
+		Envolve dynFun para contar as chamadas.
+	*/
+	Sensitivity::ParametricFunction Counted(ParameterProblem& problem, std::size_t& counter) {
+		Sensitivity::ParametricFunction& dynFun = problem.dynFun;
+		return [&dynFun, &counter](double t, std::vector<double>& u,
+			std::vector<double>& p, std::vector<double>& dudt) {
+			counter++;
+			dynFun(t, u, p, dudt);
+		};
+	}
+
+	/*
+		Custo L(p) em uma integração com CashKarpRange.
+	*/
+	double Loss(
+		ParameterProblem& problem,
+		std::vector<double>& parameters,
+		double tolerance,
+		Sensitivity::ParametricFunction& dynFun,
+		Gradient& gradient)
+	{
+		std::function<void(double, std::vector<double>&, std::vector<double>&)> system =
+			[&dynFun, &parameters](double t, std::vector<double>& u, std::vector<double>& dudt) {
+				dynFun(t, u, parameters, dudt);
+			};
+		std::vector<double> uFinal;
+		std::size_t steps = 0;
+		std::function<void(double, std::vector<double>&)> observer =
+			[&uFinal, &steps](double t, std::vector<double>& u) {
+				uFinal = u;
+				steps++;
+			};
+		CashKarp::CashKarpRange(
+			problem.uInitial, problem.tSpan, tolerance, 1e-3, 0.0, 1000000, system, observer);
+		gradient.acceptedSteps += steps - 1;
+		gradient.solves++;
+
+		double loss = 0.0;
+		for (std::size_t i = 0; i < uFinal.size(); i++)
+			loss += 0.5 * (uFinal[i] - problem.target[i]) * (uFinal[i] - problem.target[i]);
+		return loss;
+	}
+
+	/*
+		Diferenças finitas centradas: 2P + 1 integrações, cada uma com sua
+		própria sequência de passos. O incremento tolerance^(1/3) equilibra
+		o erro de truncamento e o erro das integrações.
+	*/
+	Gradient FiniteDifferenceGradient(ParameterProblem& problem, double tolerance) {
+		Gradient gradient;
+		Sensitivity::ParametricFunction dynFun = Counted(problem, gradient.rhsEvaluations);
+		std::vector<double> parameters = problem.parameters;
+		Loss(problem, parameters, tolerance, dynFun, gradient);
+
+		for (std::size_t j = 0; j < parameters.size(); j++) {
+			double delta = std::cbrt(tolerance) * std::max(1.0, std::abs(problem.parameters[j]));
+			parameters[j] = problem.parameters[j] + delta;
+			double lossPlus = Loss(problem, parameters, tolerance, dynFun, gradient);
+			parameters[j] = problem.parameters[j] - delta;
+			double lossMinus = Loss(problem, parameters, tolerance, dynFun, gradient);
+			parameters[j] = problem.parameters[j];
+			gradient.values.push_back((lossPlus - lossMinus) / (2.0 * delta));
+		}
+		return gradient;
+	}
+
+	/*
+		Sensibilidades em uma única integração: dL/dp_j = (u - target) . s_j.
+		Com analytic, o lado direito das sensibilidades é o fornecido pelo
+		problema; caso contrário, é obtido por números duais, cujas
+		avaliações também são contadas.
+	*/
+	Gradient SensitivityGradient(ParameterProblem& problem, double tolerance, bool analytic) {
+		Gradient gradient;
+		Sensitivity::ParametricFunction dynFun = Counted(problem, gradient.rhsEvaluations);
+		std::vector<double> sensitivityInitial;
+		std::vector<double> uFinal, sensitivitiesFinal;
+		std::function<void(double, std::vector<double>&, std::vector<double>&)> observer =
+			[&](double t, std::vector<double>& u, std::vector<double>& s) {
+				uFinal = u;
+				sensitivitiesFinal = s;
+				gradient.acceptedSteps++;
+			};
+		if (analytic) {
+			Sensitivity::SensitivityRange(
+				problem.uInitial, sensitivityInitial, problem.parameters, problem.tSpan,
+				tolerance, 1e-3, 0.0, 1000000, dynFun, observer, problem.sensitivityFun);
+		}
+		else {
+			problem.automatic(problem, tolerance, observer, gradient.rhsEvaluations);
+		}
+		gradient.acceptedSteps--;
+		gradient.solves = 1;
+
+		std::size_t uSize = uFinal.size();
+		for (std::size_t j = 0; j < problem.parameters.size(); j++) {
+			double value = 0.0;
+			for (std::size_t i = 0; i < uSize; i++)
+				value += (uFinal[i] - problem.target[i]) * sensitivitiesFinal[j * uSize + i];
+			gradient.values.push_back(value);
+		}
+		return gradient;
+	}
+
+	/*
+		Gradiente de referência: sensibilidades analíticas com tolerância
+		muito menor que as medidas.
+	*/
+	std::vector<double>& ReferenceGradient(ParameterProblem& problem) {
+		static std::vector<std::vector<double>> references(ParameterProblems().size());
+		std::size_t index = &problem - ParameterProblems().data();
+		if (references[index].empty())
+			references[index] = SensitivityGradient(problem, 1e-13, true).values;
+		return references[index];
+	}
+
+	enum class Method { FiniteDifferences, Automatic, Analytic };
+
+	void GradientBenchmark(
+		Benchmark::State& state,
+		ParameterProblem& problem,
+		Method method,
+		double tolerance)
+	{
+		std::vector<double>& reference = ReferenceGradient(problem);
+		Gradient gradient;
+		try {
+			while (state.KeepRunning()) {
+				if (method == Method::FiniteDifferences)
+					gradient = FiniteDifferenceGradient(problem, tolerance);
+				else
+					gradient = SensitivityGradient(problem, tolerance, method == Method::Analytic);
+			}
+		}
+		catch (const char* message) {
+			state.SkipWithError(message);
+			return;
+		}
+
+		/*
+			Erro relativo do gradiente, na norma euclidiana.
+		*/
+		double difference = 0.0, norm = 0.0;
+		for (std::size_t j = 0; j < reference.size(); j++) {
+			difference += (gradient.values[j] - reference[j]) * (gradient.values[j] - reference[j]);
+			norm += reference[j] * reference[j];
+		}
+
+		state.counters["tolerance"] = tolerance;
+		state.counters["parameters"] = static_cast<double>(problem.parameters.size());
+		state.counters["solves"] = static_cast<double>(gradient.solves);
+		state.counters["steps"] = static_cast<double>(gradient.acceptedSteps);
+		state.counters["rhs_evaluations"] = static_cast<double>(gradient.rhsEvaluations);
+		state.counters["gradient_error"] = std::sqrt(difference / norm);
+	}
+}
+
+void RegisterSensitivityBenchmarks()
+{
+	for (ParameterProblem& problem : ParameterProblems()) {
+		for (double tolerance : { 1e-6, 1e-8, 1e-10 }) {
+			std::string suffix = "/" + problem.name + "/" + ToleranceName(tolerance);
+			Benchmark::Register(
+				"Gradient/FiniteDifferences" + suffix,
+				[&problem, tolerance](Benchmark::State& state) {
+					GradientBenchmark(state, problem, Method::FiniteDifferences, tolerance);
+				});
+			Benchmark::Register(
+				"Gradient/SensitivityAutomatic" + suffix,
+				[&problem, tolerance](Benchmark::State& state) {
+					GradientBenchmark(state, problem, Method::Automatic, tolerance);
+				});
+			Benchmark::Register(
+				"Gradient/SensitivityAnalytic" + suffix,
+				[&problem, tolerance](Benchmark::State& state) {
+					GradientBenchmark(state, problem, Method::Analytic, tolerance);
+				});
+		}
+	}
+}
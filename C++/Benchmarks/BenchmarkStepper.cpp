@@ -0,0 +1,186 @@
+/**
+* @file BenchmarkStepper.cpp
+* @brief Custo de alternar entre integrações com CashKarp::Stepper
+*/
+
+#include "Benchmark.hpp"
+#include "CashKarpStepper.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+
+namespace {
+	/*
+		Osciladores u'' = -w^2 u com frequências w = 1 + k / integrations,
+		em [0, 10]: sistema barato, para que o custo de alternar entre
+		integrações não fique escondido atrás de dynFun.
+	*/
+	struct OscillatorFamily {
+		std::vector<std::vector<double>> uInitial;
+		std::pair<double, double> tSpan = { 0.0, 10.0 };
+		std::vector<std::function<
+			void(double,
+				std::vector<double>&,
+				std::vector<double>&)>> dynFuns;
+
+		explicit OscillatorFamily(std::size_t integrations) {
+			for (std::size_t k = 0; k < integrations; k++) {
+				double w = 1.0 + static_cast<double>(k) / static_cast<double>(integrations);
+				uInitial.push_back({ 1.0, 0.0 });
+				dynFuns.push_back([w](
+					double t,
+					std::vector<double>& u,
+					std::vector<double>& dudt)
+				{
+					dudt[0] = u[1];
+					dudt[1] = -w * w * u[0];
+				});
+			}
+		}
+	};
+
+	const double tolerance = 1e-8;
+	const double initialStep = 1e-3;
+	const std::size_t maximumNumberOfSteps = 1000000;
+
+	enum class Mode { RunToCompletion, Sequential, RoundRobin };
+
+	/*
+		Todas as integrações da família. Cada ponto é consumido assim que é
+		calculado, com o mesmo trabalho nos três modos: soma de u[0] e cópia
+		de u para finals, que termina com o último u de cada integração.
+		Retorna a quantidade de pontos.
+	*/
+	std::size_t Run(OscillatorFamily& family, Mode mode, std::vector<std::vector<double>>& finals)
+	{
+		std::size_t integrations = family.uInitial.size(), points = 0;
+		double checksum = 0.0;
+		finals.resize(integrations);
+
+		if (mode == Mode::RunToCompletion) {
+			for (std::size_t k = 0; k < integrations; k++) {
+				std::function<void(double, std::vector<double>&)> observer =
+					[&](double t, std::vector<double>& u) {
+						checksum += u[0];
+						points++;
+						finals[k] = u;
+					};
+				CashKarp::CashKarpRange(
+					family.uInitial[k], family.tSpan, tolerance, initialStep, 0.0,
+					maximumNumberOfSteps, family.dynFuns[k], observer);
+			}
+		}
+		else {
+			std::vector<CashKarp::Stepper> steppers;
+			steppers.reserve(integrations);
+			for (std::size_t k = 0; k < integrations; k++) {
+				steppers.emplace_back(
+					family.uInitial[k], family.tSpan, tolerance, initialStep,
+					maximumNumberOfSteps, family.dynFuns[k]);
+			}
+
+			if (mode == Mode::Sequential) {
+				for (std::size_t k = 0; k < integrations; k++) {
+					while (steppers[k].Next()) {
+						checksum += steppers[k].U()[0];
+						points++;
+						finals[k] = steppers[k].U();
+					}
+				}
+			}
+			else {
+				std::function<void(std::size_t, double, const std::vector<double>&)> consumer =
+					[&](std::size_t index, double t, const std::vector<double>& u) {
+						checksum += u[0];
+						finals[index] = u;
+					};
+				points = CashKarp::RoundRobin(steppers, consumer);
+			}
+		}
+
+		// Impede que o consumo dos pontos seja eliminado pelo compilador
+		if (std::isnan(checksum))
+			throw "Stepper: soma inválida.";
+		return points;
+	}
+
+	/*
+		Menor tempo por ponto em algumas repetições, alternando entre o modo
+		medido e CashKarpRange para que os dois sofram as mesmas variações
+		da máquina. Retorna a diferença entre eles.
+	*/
+	double SwitchNanoseconds(OscillatorFamily& family, Mode mode, std::size_t points) {
+		std::vector<std::vector<double>> finals;
+		double best[2] = { 0.0, 0.0 };
+		for (int r = 0; r < 10; r++) {
+			int k = r % 2;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			Run(family, (k == 0) ? mode : Mode::RunToCompletion, finals);
+			double elapsed = std::chrono::duration<double, std::nano>(
+				std::chrono::steady_clock::now() - start).count();
+			best[k] = (r < 2) ? elapsed : std::min(best[k], elapsed);
+		}
+		return (best[0] - best[1]) / static_cast<double>(points);
+	}
+
+	/*
+		ns_per_step: tempo por ponto entregue. switch_ns_per_step: diferença
+		em relação a CashKarpRange (SwitchNanoseconds), ou seja, o custo de
+		devolver o controle a quem consome a cada passo (e, em RoundRobin, de
+		trocar de integração). difference confirma que os resultados são
+		idênticos.
+	*/
+	void StepperBenchmark(Benchmark::State& state, std::size_t integrations, Mode mode) {
+		OscillatorFamily family(integrations);
+		std::vector<std::vector<double>> reference, finals;
+		std::size_t points;
+		try {
+			Run(family, Mode::RunToCompletion, reference);
+			points = Run(family, mode, finals);
+		}
+		catch (const char* message) {
+			state.SkipWithError(message);
+			return;
+		}
+
+		double difference = 0.0;
+		for (std::size_t k = 0; k < integrations; k++) {
+			for (std::size_t i = 0; i < finals[k].size(); i++)
+				difference = std::max(difference, std::abs(finals[k][i] - reference[k][i]));
+		}
+
+		while (state.KeepRunning())
+			Run(family, mode, finals);
+
+		double nanosecondsPerStep =
+			state.RealTime() / static_cast<double>(state.Iterations()) / static_cast<double>(points);
+		state.counters["integrations"] = static_cast<double>(integrations);
+		state.counters["steps"] = static_cast<double>(points);
+		state.counters["ns_per_step"] = nanosecondsPerStep;
+		if (mode != Mode::RunToCompletion) {
+			state.counters["switch_ns_per_step"] =
+				SwitchNanoseconds(family, mode, points);
+			state.counters["difference"] = difference;
+		}
+	}
+}
+
+void RegisterStepperBenchmarks()
+{
+	for (std::size_t integrations : { 1, 100, 10000 }) {
+		std::string suffix = "/integrations:" + std::to_string(integrations);
+		Benchmark::Register("Stepper/RunToCompletion" + suffix,
+			[integrations](Benchmark::State& state) {
+				StepperBenchmark(state, integrations, Mode::RunToCompletion);
+			});
+		Benchmark::Register("Stepper/Sequential" + suffix,
+			[integrations](Benchmark::State& state) {
+				StepperBenchmark(state, integrations, Mode::Sequential);
+			});
+		Benchmark::Register("Stepper/RoundRobin" + suffix,
+			[integrations](Benchmark::State& state) {
+				StepperBenchmark(state, integrations, Mode::RoundRobin);
+			});
+	}
+}
@@ -0,0 +1,363 @@
+/**
+* @file BenchmarkSymplectic.cpp
+* @brief Benchmarks dos integradores simpléticos contra o método de Cash-Karp
+*/
+
+#include "Benchmark.hpp"
+#include "Problems.hpp"
+#include "CashKarp.hpp"
+#include "Symplectic.hpp"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace {
+	using ForceFunction = std::function<
+		void(
+			std::vector<double>&,
+			std::vector<double>&)>;
+
+	/*
+		Sistema Hamiltoniano com massa unitária, H = |v|^2 / 2 + V(q).
+	*/
+	struct HamiltonianProblem {
+		std::string name;
+		Symplectic::PhaseSpace initial;
+		std::pair<double, double> tSpan;
+		ForceFunction forceFun;
+		std::function<double(std::vector<double>&)> potential;
+	};
+
+	double Energy(
+		HamiltonianProblem& problem,
+		std::vector<double>& q,
+		std::vector<double>& v)
+	{
+		double kinetic = 0.0;
+		for (double value : v)
+			kinetic += 0.5 * value * value;
+		return kinetic + problem.potential(q);
+	}
+
+	/*
+		Problema de Kepler (excentricidade 0.6) ao longo de 100 órbitas.
+		A energia exata é -1/2.
+	*/
+	HamiltonianProblem Kepler() {
+		const double eccentricity = 0.6;
+		HamiltonianProblem problem;
+		problem.name = "Kepler";
+		problem.initial = Symplectic::PhaseSpace(1, 2);
+		problem.initial.position = { 1.0 - eccentricity, 0.0 };
+		problem.initial.velocity = {
+			0.0, std::sqrt((1.0 + eccentricity) / (1.0 - eccentricity)) };
+		problem.tSpan = { 0.0, 100.0 * 2.0 * 3.14159265358979323846 };
+		problem.forceFun = [](std::vector<double>& q, std::vector<double>& force) {
+			double r2 = q[0] * q[0] + q[1] * q[1];
+			double r3 = r2 * std::sqrt(r2);
+			force[0] = -q[0] / r3;
+			force[1] = -q[1] / r3;
+		};
+		problem.potential = [](std::vector<double>& q) {
+			return -1.0 / std::sqrt(q[0] * q[0] + q[1] * q[1]);
+		};
+		return problem;
+	}
+
+	/*
+		Mesmo problema de N corpos de Problems::NBody (mesmas condições
+		iniciais e suavização), reorganizado em formato SoA, em [0, 10].
+	*/
+	HamiltonianProblem NBody(std::size_t bodies) {
+		HamiltonianProblem problem;
+		problem.name = "NBody" + std::to_string(bodies);
+		problem.initial = Symplectic::PhaseSpace(bodies, 3);
+		problem.tSpan = { 0.0, 10.0 };
+
+		std::vector<double> u = Problems::NBody(bodies).uInitial;
+		for (std::size_t b = 0; b < bodies; b++) {
+			for (std::size_t d = 0; d < 3; d++) {
+				problem.initial.Position(d)[b] = u[3 * b + d];
+				problem.initial.Velocity(d)[b] = u[3 * (bodies + b) + d];
+			}
+		}
+
+		const double softening2 = 0.05 * 0.05;
+		const double mass = 1.0 / static_cast<double>(bodies);
+		problem.forceFun = [=](std::vector<double>& q, std::vector<double>& force) {
+			const double* x = q.data();
+			const double* y = x + bodies;
+			const double* z = y + bodies;
+			double* fx = force.data();
+			double* fy = fx + bodies;
+			double* fz = fy + bodies;
+			for (std::size_t i = 0; i < 3 * bodies; i++)
+				force[i] = 0.0;
+			for (std::size_t i = 0; i < bodies; i++) {
+				for (std::size_t j = i + 1; j < bodies; j++) {
+					double dx = x[j] - x[i];
+					double dy = y[j] - y[i];
+					double dz = z[j] - z[i];
+					double d2 = dx * dx + dy * dy + dz * dz + softening2;
+					double f = mass / (d2 * std::sqrt(d2));
+					fx[i] += f * dx;
+					fy[i] += f * dy;
+					fz[i] += f * dz;
+					fx[j] -= f * dx;
+					fy[j] -= f * dy;
+					fz[j] -= f * dz;
+				}
+			}
+		};
+		problem.potential = [=](std::vector<double>& q) {
+			const double* x = q.data();
+			const double* y = x + bodies;
+			const double* z = y + bodies;
+			double potential = 0.0;
+			for (std::size_t i = 0; i < bodies; i++) {
+				for (std::size_t j = i + 1; j < bodies; j++) {
+					double dx = x[j] - x[i];
+					double dy = y[j] - y[i];
+					double dz = z[j] - z[i];
+					potential -= mass / std::sqrt(dx * dx + dy * dy + dz * dz + softening2);
+				}
+			}
+			return potential;
+		};
+		return problem;
+	}
+
+	std::vector<HamiltonianProblem>& HamiltonianProblems() {
+		static std::vector<HamiltonianProblem> problems = { Kepler(), NBody(16) };
+		return problems;
+	}
+
+	const double initialStep = 1e-3;
+	const std::size_t maximumNumberOfSteps = 100000000;
+
+	std::string ToleranceName(double tolerance) {
+		std::ostringstream name;
+		name << "tol:" << tolerance;
+		return name.str();
+	}
+
+	/*
+		Sistema de primeira ordem u = (q, v), du/dt = (v, F(q)), no formato
+		aceito por CashKarpRange.
+	*/
+	Problems::DynamicFunction FirstOrderSystem(HamiltonianProblem& problem) {
+		std::size_t size = problem.initial.position.size();
+		std::vector<double> q(size), force(size);
+		return [&problem, size, q, force](
+			double t,
+			std::vector<double>& u,
+			std::vector<double>& dudt) mutable
+		{
+			std::copy(u.begin(), u.begin() + size, q.begin());
+			problem.forceFun(q, force);
+			std::copy(u.begin() + size, u.end(), dudt.begin());
+			std::copy(force.begin(), force.end(), dudt.begin() + size);
+		};
+	}
+
+	std::vector<double> FirstOrderInitial(HamiltonianProblem& problem) {
+		std::vector<double> uInitial = problem.initial.position;
+		uInitial.insert(uInitial.end(),
+			problem.initial.velocity.begin(), problem.initial.velocity.end());
+		return uInitial;
+	}
+
+	/*
+		Maior erro relativo na energia entre todos os passos aceitos por
+		CashKarpRange.
+	*/
+	double CashKarpEnergyError(
+		HamiltonianProblem& problem,
+		double tolerance,
+		CashKarp::IntegrationStatistics& statistics)
+	{
+		std::size_t size = problem.initial.position.size();
+		std::vector<double> q(size), v(size);
+		Problems::DynamicFunction dynFun = FirstOrderSystem(problem);
+		std::vector<double> uInitial = FirstOrderInitial(problem);
+		double energy = Energy(problem, problem.initial.position, problem.initial.velocity);
+
+		double error = 0.0;
+		std::function<void(double, std::vector<double>&)> observer = [&](
+			double t,
+			std::vector<double>& u)
+		{
+			std::copy(u.begin(), u.begin() + size, q.begin());
+			std::copy(u.begin() + size, u.end(), v.begin());
+			double relative = std::abs(Energy(problem, q, v) / energy - 1.0);
+			error = std::isfinite(relative) ? std::max(error, relative) : INFINITY;
+		};
+		statistics = CashKarp::CashKarpRange(
+			uInitial, problem.tSpan, tolerance,
+			initialStep, 0.0, maximumNumberOfSteps, dynFun, observer);
+		return error;
+	}
+
+	/*
+		Maior erro relativo na energia do método simplético com
+		numberOfSteps passos iguais.
+	*/
+	template <typename Method>
+	double SymplecticEnergyError(
+		HamiltonianProblem& problem,
+		std::size_t numberOfSteps)
+	{
+		Symplectic::UnitMass unitMass;
+		Symplectic::PhaseSpace state = problem.initial;
+		Symplectic::Integrator<Method> integrator(state.position.size());
+		double energy = Energy(problem, state.position, state.velocity);
+		double error = 0.0;
+		auto observer = [&](double t, Symplectic::PhaseSpace& current) {
+			double relative =
+				std::abs(Energy(problem, current.position, current.velocity) / energy - 1.0);
+			error = std::isfinite(relative) ? std::max(error, relative) : INFINITY;
+		};
+		integrator.Range(unitMass, problem.forceFun, state, problem.tSpan, numberOfSteps, observer);
+		return error;
+	}
+
+	/*
+		Integração completa com CashKarpRange, sem calcular a energia.
+	*/
+	void CashKarpBenchmark(
+		Benchmark::State& state,
+		HamiltonianProblem& problem,
+		double tolerance)
+	{
+		CashKarp::IntegrationStatistics statistics;
+		double energyError = CashKarpEnergyError(problem, tolerance, statistics);
+
+		Problems::DynamicFunction dynFun = FirstOrderSystem(problem);
+		std::vector<double> uInitial = FirstOrderInitial(problem);
+		std::function<void(double, std::vector<double>&)> observer =
+			[](double, std::vector<double>&) {};
+		while (state.KeepRunning()) {
+			CashKarp::CashKarpRange(
+				uInitial, problem.tSpan, tolerance,
+				initialStep, 0.0, maximumNumberOfSteps, dynFun, observer);
+		}
+
+		std::size_t accepted = statistics.acceptedSteps;
+		std::size_t rhsEvaluations = statistics.rhsEvaluations;
+#if !CASHKARP_STATISTICS
+		// Sem estatísticas: um passo aceito a cada 6 chamadas (aproximado).
+		std::size_t counted = 0;
+		std::function<void(double, std::vector<double>&)> counter =
+			[&counted](double, std::vector<double>&) { counted++; };
+		CashKarp::CashKarpRange(
+			uInitial, problem.tSpan, tolerance,
+			initialStep, 0.0, maximumNumberOfSteps, dynFun, counter);
+		accepted = counted - 1;
+		rhsEvaluations = 6 * accepted;
+#endif
+		state.counters["tolerance"] = tolerance;
+		state.counters["energy_error"] = energyError;
+		state.counters["steps"] = static_cast<double>(accepted);
+		state.counters["force_evaluations"] = static_cast<double>(rhsEvaluations);
+		state.counters["ns_per_step"] =
+			state.RealTime() / static_cast<double>(state.Iterations()) /
+			static_cast<double>(accepted);
+	}
+
+	/*
+		Integração com o método simplético e a menor quantidade de passos cujo
+		erro na energia não ultrapassa o de CashKarpRange na tolerância
+		indicada. A busca (dobrando e depois por bisseção) é feita fora da
+		medição de tempo.
+	*/
+	template <typename Method>
+	void SymplecticBenchmark(
+		Benchmark::State& state,
+		HamiltonianProblem& problem,
+		double tolerance)
+	{
+		CashKarp::IntegrationStatistics statistics;
+		double cashKarpError = CashKarpEnergyError(problem, tolerance, statistics);
+
+		const std::size_t maximumSearchSteps = std::size_t(1) << 24;
+		std::size_t upper = 16;
+		while (SymplecticEnergyError<Method>(problem, upper) > cashKarpError) {
+			upper *= 2;
+			if (upper > maximumSearchSteps) {
+				state.SkipWithError("Erro na energia de CashKarpRange não alcançado.");
+				return;
+			}
+		}
+		std::size_t lower = upper / 2;
+		while (upper - lower > 1) {
+			std::size_t middle = (lower + upper) / 2;
+			if (SymplecticEnergyError<Method>(problem, middle) > cashKarpError)
+				lower = middle;
+			else
+				upper = middle;
+		}
+		std::size_t numberOfSteps = upper;
+		double energyError = SymplecticEnergyError<Method>(problem, numberOfSteps);
+
+		Symplectic::UnitMass unitMass;
+		Symplectic::PhaseSpace phaseSpace = problem.initial;
+		Symplectic::Integrator<Method> integrator(phaseSpace.position.size());
+		auto observer = [](double, Symplectic::PhaseSpace&) {};
+		while (state.KeepRunning()) {
+			phaseSpace.position = problem.initial.position;
+			phaseSpace.velocity = problem.initial.velocity;
+			integrator.Range(
+				unitMass, problem.forceFun, phaseSpace,
+				problem.tSpan, numberOfSteps, observer);
+		}
+
+		state.counters["tolerance"] = tolerance;
+		state.counters["energy_error"] = energyError;
+		state.counters["ck_energy_error"] = cashKarpError;
+		state.counters["steps"] = static_cast<double>(numberOfSteps);
+		state.counters["force_evaluations"] =
+			static_cast<double>(integrator.ForceEvaluations()) /
+			static_cast<double>(state.Iterations());
+		state.counters["ns_per_step"] =
+			state.RealTime() / static_cast<double>(state.Iterations()) /
+			static_cast<double>(numberOfSteps);
+	}
+
+	template <typename Method>
+	void RegisterMethod(
+		const std::string& methodName,
+		HamiltonianProblem& problem,
+		double tolerance)
+	{
+		Benchmark::Register(
+			"HamiltonianRange/" + methodName + "/" + problem.name + "/" +
+				ToleranceName(tolerance),
+			[&problem, tolerance](Benchmark::State& state) {
+				SymplecticBenchmark<Method>(state, problem, tolerance);
+			});
+	}
+}
+
+void RegisterSymplecticBenchmarks()
+{
+	/*
+		Para cada tolerância de CashKarpRange, os métodos simpléticos são
+		executados com a quantidade de passos que atinge o mesmo erro na
+		energia. Comparar steps e real_time com HamiltonianRange/CashKarp/...
+	*/
+	for (HamiltonianProblem& problem : HamiltonianProblems()) {
+		for (double tolerance : { 1e-6, 1e-8, 1e-10 }) {
+			Benchmark::Register(
+				"HamiltonianRange/CashKarp/" + problem.name + "/" +
+					ToleranceName(tolerance),
+				[&problem, tolerance](Benchmark::State& state) {
+					CashKarpBenchmark(state, problem, tolerance);
+				});
+			RegisterMethod<Symplectic::VelocityVerlet>("VelocityVerlet", problem, tolerance);
+			RegisterMethod<Symplectic::Yoshida4>("Yoshida4", problem, tolerance);
+			RegisterMethod<Symplectic::Yoshida6>("Yoshida6", problem, tolerance);
+			RegisterMethod<Symplectic::ForestRuth>("ForestRuth", problem, tolerance);
+			RegisterMethod<Symplectic::OmelyanForestRuth>("OmelyanForestRuth", problem, tolerance);
+		}
+	}
+}
@@ -0,0 +1,76 @@
+/**
+* @file BenchmarkTrajectory.cpp
+* @brief Benchmarks da gravação de trajetórias em arquivos mapeados
+*/
+
+#include "Benchmark.hpp"
+#include "Problems.hpp"
+#include "CashKarp.hpp"
+#include "MappedTrajectory.hpp"
+#include <cstdio>
+
+namespace {
+	const char* trajectoryPath = "benchmark_trajectory.bin";
+
+	/*
+		Integração gravando cada passo em um arquivo mapeado, em vez de
+		std::vector<std::vector<double>> (comparar com CashKarpRange/...).
+		Ao final, a trajetória é lida de volta e o último estado comparado
+		com a solução de referência.
+	*/
+	void MappedRangeBenchmark(
+		Benchmark::State& state,
+		Problems::Problem& problem,
+		double tolerance)
+	{
+		std::size_t steps = 0;
+		double error = 0.0;
+
+		try {
+			while (state.KeepRunning()) {
+				Trajectory::MappedTrajectoryWriter writer(
+					trajectoryPath, problem.uInitial.size());
+				std::function<void(double, std::vector<double>&)> observer =
+					writer.Observer();
+				CashKarp::CashKarpRange(
+					problem.uInitial, problem.tSpan, tolerance,
+					problem.initialStep, 0.0, problem.maximumNumberOfSteps,
+					problem.dynFun, observer);
+				writer.Close();
+			}
+
+			Trajectory::MappedTrajectoryReader reader(trajectoryPath);
+			steps = reader.StepCount();
+			const double* uLast = reader.State(steps - 1);
+			error = Problems::ErrorNorm(
+				problem, std::vector<double>(uLast, uLast + reader.SystemSize()));
+		}
+		catch (const char* message) {
+			state.SkipWithError(message);
+		}
+		std::remove(trajectoryPath);
+
+		double accepted = static_cast<double>(steps - 1);
+		state.counters["tolerance"] = tolerance;
+		state.counters["error"] = error;
+		state.counters["accepted_steps"] = accepted;
+		state.counters["bytes"] = static_cast<double>(
+			sizeof(Trajectory::TrajectoryHeader) +
+			steps * (problem.uInitial.size() + 1) * sizeof(double));
+		state.counters["ns_per_step"] =
+			state.RealTime() / static_cast<double>(state.Iterations()) / accepted;
+	}
+}
+
+void RegisterTrajectoryBenchmarks()
+{
+	for (Problems::Problem& problem : Problems::StandardProblems()) {
+		if (problem.name == "BlasiusLong")
+			continue;
+		Benchmark::Register(
+			"CashKarpRangeMapped/" + problem.name + "/tol:1e-08",
+			[&problem](Benchmark::State& state) {
+				MappedRangeBenchmark(state, problem, 1e-8);
+			});
+	}
+}
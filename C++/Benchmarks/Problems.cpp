@@ -0,0 +1,283 @@
+/**
+* @file Problems.cpp
+* @brief Problemas de Valor Inicial padrão, utilizados pelos benchmarks
+*/
+
+#include "Problems.hpp"
+#include "BulirschStoer.hpp"
+#include "CashKarpGeneric.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+	/*
+		Tolerância utilizada nas soluções de referência, em long double
+		(épsilon de 1e-19 em x86), cinco ordens de grandeza menor que a
+		menor tolerância utilizada nos benchmarks.
+	*/
+	const long double referenceTolerance = 1.0e-17L;
+
+	/*
+		Calcula a solução de referência integrando o problema com
+		CashKarp::Generic::CashKarpRange em long double, que nenhum
+		benchmark avalia: a referência não é a saída de um dos métodos
+		comparados (Cash-Karp e Bulirsch-Stoer em double). system é o mesmo
+		sistema de problem.dynFun, chamado com vetores de long double; as
+		constantes do sistema e o estado inicial são os valores em double,
+		para que o problema resolvido seja o mesmo. As referências coincidem
+		com as de BulirschStoerRange com tolerância 1e-14 a menos de 3e-13,
+		exceto em Lorenz (caótico), a menos de 2e-11.
+	*/
+	template <typename System>
+	void Reference(Problems::Problem& problem, System system) {
+		std::vector<long double> uInitial(problem.uInitial.begin(), problem.uInitial.end());
+		std::pair<long double, long double> tSpan(problem.tSpan.first, problem.tSpan.second);
+		auto lastState = [&problem](long double t, std::vector<long double>& u) {
+			problem.uReference.assign(u.begin(), u.end());
+		};
+		CashKarp::Generic::CashKarpRange(
+			uInitial,
+			tSpan,
+			referenceTolerance,
+			problem.initialStep,
+			0.0,
+			problem.maximumNumberOfSteps,
+			system,
+			lastState);
+	}
+
+	/*
+		Referência com BulirschStoerRange em double e tolerância 1e-14, para
+		problemas em que a integração em long double seria lenta demais (N
+		corpos: cerca de 10 s). Só pode ser usada em problemas que os
+		benchmarks de Bulirsch-Stoer não avaliam.
+	*/
+	void BulirschStoerReference(Problems::Problem& problem) {
+		std::function<void(double, std::vector<double>&)> lastState =
+			[&problem](double t, std::vector<double>& u) {
+				problem.uReference = u;
+			};
+		BulirschStoer::BulirschStoerRange(
+			problem.uInitial,
+			problem.tSpan,
+			1.0e-14,
+			problem.initialStep,
+			0.0,
+			problem.maximumNumberOfSteps,
+			problem.dynFun,
+			lastState);
+	}
+
+	/*
+		Sistemas dos problemas padrão, para Scalar = double (dynFun) e
+		Scalar = long double (Reference).
+	*/
+	struct BlasiusSystem {
+		template <typename Scalar, typename Precision>
+		void operator()(Precision t, std::vector<Scalar>& u, std::vector<Scalar>& dudt) const {
+			dudt[0] = u[1];
+			dudt[1] = u[2];
+			dudt[2] = static_cast<Scalar>(-1.0 / 2.0) * u[0] * u[2];
+		}
+	};
+
+	struct LorenzSystem {
+		template <typename Scalar, typename Precision>
+		void operator()(Precision t, std::vector<Scalar>& u, std::vector<Scalar>& dudt) const {
+			const Scalar sigma = 10.0, rho = 28.0, beta = static_cast<Scalar>(8.0 / 3.0);
+			dudt[0] = sigma * (u[1] - u[0]);
+			dudt[1] = u[0] * (rho - u[2]) - u[1];
+			dudt[2] = u[0] * u[1] - beta * u[2];
+		}
+	};
+
+	struct VanDerPolSystem {
+		template <typename Scalar, typename Precision>
+		void operator()(Precision t, std::vector<Scalar>& u, std::vector<Scalar>& dudt) const {
+			const Scalar mu = 10.0;
+			dudt[0] = u[1];
+			dudt[1] = mu * (1.0 - u[0] * u[0]) * u[1] - u[0];
+		}
+	};
+
+	struct NBodySystem {
+		std::size_t bodies;
+
+		template <typename Scalar, typename Precision>
+		void operator()(Precision t, std::vector<Scalar>& u, std::vector<Scalar>& dudt) const {
+			const Scalar softening2 = 0.05 * 0.05;
+			const Scalar mass = 1.0 / static_cast<double>(bodies);
+			std::size_t n = 3 * bodies;
+			for (std::size_t i = 0; i < n; i++) {
+				dudt[i] = u[n + i];
+				dudt[n + i] = 0.0;
+			}
+			for (std::size_t i = 0; i < bodies; i++) {
+				for (std::size_t j = i + 1; j < bodies; j++) {
+					Scalar dx = u[3 * j] - u[3 * i];
+					Scalar dy = u[3 * j + 1] - u[3 * i + 1];
+					Scalar dz = u[3 * j + 2] - u[3 * i + 2];
+					Scalar d2 = dx * dx + dy * dy + dz * dz + softening2;
+					Scalar f = mass / (d2 * std::sqrt(d2));
+					dudt[n + 3 * i] += f * dx;
+					dudt[n + 3 * i + 1] += f * dy;
+					dudt[n + 3 * i + 2] += f * dz;
+					dudt[n + 3 * j] -= f * dx;
+					dudt[n + 3 * j + 1] -= f * dy;
+					dudt[n + 3 * j + 2] -= f * dz;
+				}
+			}
+		}
+	};
+}
+
+Problems::Problem Problems::Blasius()
+{
+	Problem problem;
+	problem.name = "Blasius";
+	problem.uInitial = { 0.0, 0.0, 0.33206 };
+	problem.tSpan = { 0.0, 10.0 };
+	problem.initialStep = 1e-1;
+	problem.maximumNumberOfSteps = 10000000;
+	problem.dynFun = BlasiusSystem();
+	Reference(problem, BlasiusSystem());
+	return problem;
+}
+
+Problems::Problem Problems::BlasiusLong()
+{
+	Problem problem = Blasius();
+	problem.name = "BlasiusLong";
+	problem.tSpan = { 0.0, 50000.0 };
+	problem.maximumNumberOfSteps = 100000;
+	problem.uReference.clear();
+	return problem;
+}
+
+Problems::Problem Problems::Lorenz()
+{
+	Problem problem;
+	problem.name = "Lorenz";
+	problem.uInitial = { 1.0, 1.0, 1.0 };
+	problem.tSpan = { 0.0, 10.0 };
+	problem.initialStep = 1e-3;
+	problem.maximumNumberOfSteps = 10000000;
+	problem.dynFun = LorenzSystem();
+	Reference(problem, LorenzSystem());
+	return problem;
+}
+
+Problems::Problem Problems::Arenstorf()
+{
+	/*
+		Valores retirados de Hairer, Nørsett e Wanner, "Solving Ordinary
+		Differential Equations I", seção II.0. Estado: (x, y, x', y').
+	*/
+	Problem problem;
+	problem.name = "Arenstorf";
+	problem.uInitial = { 0.994, 0.0, 0.0, -2.00158510637908252240537862224 };
+	problem.tSpan = { 0.0, 17.0652165601579625588917206249 };
+	problem.initialStep = 1e-4;
+	problem.maximumNumberOfSteps = 10000000;
+	problem.dynFun = [](
+		double t,
+		std::vector<double>& u,
+		std::vector<double>& dudt)
+	{
+		const double mu = 0.012277471, mu2 = 1.0 - mu;
+		double d1 = std::pow((u[0] + mu) * (u[0] + mu) + u[1] * u[1], 1.5);
+		double d2 = std::pow((u[0] - mu2) * (u[0] - mu2) + u[1] * u[1], 1.5);
+		dudt[0] = u[2];
+		dudt[1] = u[3];
+		dudt[2] = u[0] + 2.0 * u[3] - mu2 * (u[0] + mu) / d1 - mu * (u[0] - mu2) / d2;
+		dudt[3] = u[1] - 2.0 * u[2] - mu2 * u[1] / d1 - mu * u[1] / d2;
+	};
+	// Solução periódica: ao final de um período retorna ao estado inicial.
+	problem.uReference = problem.uInitial;
+	return problem;
+}
+
+Problems::Problem Problems::VanDerPol()
+{
+	Problem problem;
+	problem.name = "VanDerPol";
+	problem.uInitial = { 2.0, 0.0 };
+	problem.tSpan = { 0.0, 20.0 };
+	problem.initialStep = 1e-3;
+	problem.maximumNumberOfSteps = 10000000;
+	problem.dynFun = VanDerPolSystem();
+	Reference(problem, VanDerPolSystem());
+	return problem;
+}
+
+Problems::Problem Problems::NBody(std::size_t bodies)
+{
+	/*
+		Estado: posições (x, y, z) de todos os corpos, seguidas das
+		velocidades. Massas iguais (soma unitária), G = 1.
+	*/
+	Problem problem;
+	problem.name = "NBody" + std::to_string(bodies);
+	problem.uInitial.assign(6 * bodies, 0.0);
+	problem.tSpan = { 0.0, 1.0 };
+	problem.initialStep = 1e-3;
+	problem.maximumNumberOfSteps = 10000000;
+
+	/*
+		Gerador congruencial linear, para que as condições iniciais sejam as
+		mesmas em qualquer plataforma (ao contrário de std::uniform_*).
+	*/
+	std::uint64_t seed = 12345;
+	auto uniform = [&seed]() {
+		seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+		return static_cast<double>(seed >> 11) / 9007199254740992.0;
+	};
+
+	for (std::size_t b = 0; b < bodies; b++) {
+		double r = 0.2 + 0.8 * uniform();
+		double theta = std::acos(2.0 * uniform() - 1.0);
+		double phi = 2.0 * 3.14159265358979323846 * uniform();
+		double x = r * std::sin(theta) * std::cos(phi);
+		double y = r * std::sin(theta) * std::sin(phi);
+		double z = r * std::cos(theta);
+		// Velocidade aproximadamente circular em torno do eixo z.
+		double speed = 0.5 * std::sqrt(r);
+		double rho = std::max(std::sqrt(x * x + y * y), 1e-12);
+		problem.uInitial[3 * b] = x;
+		problem.uInitial[3 * b + 1] = y;
+		problem.uInitial[3 * b + 2] = z;
+		problem.uInitial[3 * (bodies + b)] = -speed * y / rho;
+		problem.uInitial[3 * (bodies + b) + 1] = speed * x / rho;
+		problem.uInitial[3 * (bodies + b) + 2] = 0.0;
+	}
+
+	problem.dynFun = NBodySystem{ bodies };
+	// Não avaliado pelos benchmarks de Bulirsch-Stoer
+	BulirschStoerReference(problem);
+	return problem;
+}
+
+std::vector<Problems::Problem>& Problems::StandardProblems()
+{
+	static std::vector<Problem> problems = {
+		Blasius(),
+		BlasiusLong(),
+		Lorenz(),
+		Arenstorf(),
+		VanDerPol(),
+		NBody(64)
+	};
+	return problems;
+}
+
+double Problems::ErrorNorm(const Problem& problem, const std::vector<double>& u)
+{
+	if (problem.uReference.empty())
+		return std::nan("");
+
+	double error = 0.0;
+	for (std::size_t i = 0; i < u.size(); i++)
+		error = std::max(error, std::abs(u[i] - problem.uReference[i]));
+	return error;
+}
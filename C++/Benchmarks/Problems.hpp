@@ -0,0 +1,100 @@
+/**
+* @file Problems.hpp
+* @brief Problemas de Valor Inicial padrão, utilizados pelos benchmarks
+*/
+
+/*
+	* Arquivo de cabeçalho, não contém implementações.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Problems {
+	/**
+	* @brief Protótipo das funções que computam o sistema de EDO`s, o mesmo
+	* aceito por CashKarp::CashKarpRange.
+	*/
+	using DynamicFunction = std::function<
+		void(
+			double,
+			std::vector<double>&,
+			std::vector<double>&)>;
+
+	/**
+	* @brief Problema de Valor Inicial com solução de referência no final do
+	* intervalo de integração.
+	*/
+	struct Problem {
+		std::string name;
+		std::vector<double> uInitial;
+		std::pair<double, double> tSpan;
+		double initialStep;
+		std::size_t maximumNumberOfSteps;
+		DynamicFunction dynFun;
+		/**
+		* @brief Solução de referência em tSpan.second.
+		* Quando não há solução analítica, é calculada uma única vez com
+		* Cash-Karp em long double e tolerância muito mais rigorosa que a dos
+		* benchmarks (N corpos: Bulirsch-Stoer em double).
+		* Vazia quando não há referência confiável.
+		*/
+		std::vector<double> uReference;
+	};
+
+	/**
+	* @brief Equação de Blasius (camada limite), a mesma de main.cpp, em [0, 10].
+	*/
+	Problem Blasius();
+
+	/**
+	* @brief Equação de Blasius no intervalo longo [0, 50000] de main.cpp,
+	* com o mesmo limite de passos. Reproduz a carga de trabalho do executável
+	* NumericalMethods, portanto não possui solução de referência.
+	*/
+	Problem BlasiusLong();
+
+	/**
+	* @brief Atrator de Lorenz (sigma = 10, rho = 28, beta = 8/3) em [0, 10].
+	*/
+	Problem Lorenz();
+
+	/**
+	* @brief Órbita periódica de Arenstorf (problema restrito de três corpos).
+	* Após um período a solução retorna ao estado inicial, que é portanto
+	* a solução de referência exata.
+	*/
+	Problem Arenstorf();
+
+	/**
+	* @brief Oscilador de van der Pol com mu = 10 em [0, 20].
+	*/
+	Problem VanDerPol();
+
+	/**
+	* @brief Problema gravitacional de N corpos (3 dimensões, com suavização).
+	* Condições iniciais são geradas de maneira determinística.
+	* @param[in] bodies Quantidade de corpos (entrada)
+	*/
+	Problem NBody(std::size_t bodies);
+
+	/**
+	* @brief Todos os problemas padrão, na ordem utilizada nos relatórios.
+	* São construídos (com suas soluções de referência) uma única vez e
+	* compartilhados por todos os arquivos de benchmarks.
+	*/
+	std::vector<Problem>& StandardProblems();
+
+	/**
+	* @brief Maior erro absoluto entre u e a solução de referência do problema.
+	* Retorna NaN caso o problema não possua solução de referência.
+	* @param[in] problem Problema considerado (entrada)
+	* @param[in] u Solução obtida no final do intervalo (entrada)
+	*/
+	double ErrorNorm(const Problem& problem, const std::vector<double>& u);
+}
@@ -0,0 +1,45 @@
+/**
+* @file main.cpp
+* @brief Executável dos benchmarks
+*/
+
+#include "Benchmark.hpp"
+
+/*
+	Cada arquivo de benchmarks expõe uma função que registra seus casos.
+*/
+void RegisterCashKarpBenchmarks();
+void RegisterTrajectoryBenchmarks();
+void RegisterCheckpointBenchmarks();
+void RegisterFixedStepBenchmarks();
+void RegisterSymplecticBenchmarks();
+void RegisterPrecisionBenchmarks();
+void RegisterPararealBenchmarks();
+void RegisterLargeSystemBenchmarks();
+void RegisterSensitivityBenchmarks();
+void RegisterAutoDiffBenchmarks();
+void RegisterExpressionBenchmarks();
+void RegisterDelayBenchmarks();
+void RegisterBulirschStoerBenchmarks();
+void RegisterNystromBenchmarks();
+void RegisterStepperBenchmarks();
+
+int main(int argc, char** argv)
+{
+	RegisterCashKarpBenchmarks();
+	RegisterTrajectoryBenchmarks();
+	RegisterCheckpointBenchmarks();
+	RegisterFixedStepBenchmarks();
+	RegisterSymplecticBenchmarks();
+	RegisterPrecisionBenchmarks();
+	RegisterPararealBenchmarks();
+	RegisterLargeSystemBenchmarks();
+	RegisterSensitivityBenchmarks();
+	RegisterAutoDiffBenchmarks();
+	RegisterExpressionBenchmarks();
+	RegisterDelayBenchmarks();
+	RegisterBulirschStoerBenchmarks();
+	RegisterNystromBenchmarks();
+	RegisterStepperBenchmarks();
+	return Benchmark::RunBenchmarks(argc, argv);
+}
@@ -0,0 +1,301 @@
+/**
+* @file BulirschStoer.cpp
+* @brief Método de extrapolação de Gragg-Bulirsch-Stoer, com ordem variável
+*/
+
+#include "BulirschStoer.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	// Maior coluna aceita em BulirschStoerOptions::maximumColumn
+	const std::size_t largestColumn = 15;
+
+	/*
+		Memória de uma sequência de ponto médio: os dois últimos pontos, a
+		derivada e o resultado T_j,0.
+	*/
+	struct Sequence {
+		std::vector<double> previous;
+		std::vector<double> current;
+		std::vector<double> derivative;
+		std::vector<double> result;
+	};
+
+	/*
+		Regra do ponto médio modificada (Numerical Recipes, mmid) com n
+		subpassos de H / n, a partir de u e dudt = f(t, u). n chamadas a
+		dynFun.
+	*/
+	void ModifiedMidpoint(
+		const std::vector<double>& u,
+		const std::vector<double>& dudt,
+		double t,
+		double stepSize,
+		std::size_t substeps,
+		Sequence& sequence,
+		std::function<
+		void(double,
+			std::vector<double>&,
+			std::vector<double>&)
+		>& dynFun)
+	{
+		std::size_t i, uSize = u.size();
+		double h = stepSize / static_cast<double>(substeps);
+		double h2 = 2.0 * h;
+
+		for (i = 0; i < uSize; i++) {
+			sequence.previous[i] = u[i];
+			sequence.current[i] = u[i] + h * dudt[i];
+		}
+		dynFun(t + h, sequence.current, sequence.derivative);
+
+		for (std::size_t m = 1; m < substeps; m++) {
+			for (i = 0; i < uSize; i++)
+				sequence.previous[i] += h2 * sequence.derivative[i];
+			sequence.previous.swap(sequence.current);
+			dynFun(t + static_cast<double>(m + 1) * h, sequence.current, sequence.derivative);
+		}
+
+		for (i = 0; i < uSize; i++) {
+			sequence.result[i] = 0.5 * (
+				sequence.current[i] + sequence.previous[i] + h * sequence.derivative[i]);
+		}
+	}
+}
+
+BulirschStoer::BulirschStoerStatistics BulirschStoer::BulirschStoerRange(
+	std::vector<double>& uInitial,
+	std::pair<double, double>& tSpan,
+	double tolerance,
+	double initialStep,
+	double minimumStep,
+	std::size_t maximumNumberOfSteps,
+	std::function<
+	void(double,
+		std::vector<double>&,
+		std::vector<double>&)
+	>& dynFun,
+	std::function<
+	void(double,
+		std::vector<double>&)
+	>& stepObserver,
+	const BulirschStoerOptions& options)
+{
+	std::size_t i, j, k, uSize = uInitial.size();
+	std::size_t maximumColumn = std::min(options.maximumColumn, largestColumn);
+	if (maximumColumn < 3)
+		throw "BulirschStoer: maximumColumn deve ser ao menos 3.";
+
+	/*
+		Sequência harmônica dupla n_j = 2, 4, 6, ... e trabalho acumulado
+		A_j = 1 + n_0 + ... + n_j (chamadas a dynFun até a coluna j).
+	*/
+	std::vector<double> substeps(maximumColumn + 1), work(maximumColumn + 1);
+	for (j = 0; j <= maximumColumn; j++) {
+		substeps[j] = 2.0 * static_cast<double>(j + 1);
+		work[j] = ((j > 0) ? work[j - 1] : 1.0) + substeps[j];
+	}
+
+	std::vector<Sequence> sequences(maximumColumn + 1);
+	for (Sequence& sequence : sequences) {
+		sequence.previous.resize(uSize);
+		sequence.current.resize(uSize);
+		sequence.derivative.resize(uSize);
+		sequence.result.resize(uSize);
+	}
+
+	// Linhas j - 1 e j do quadro de extrapolação
+	std::vector<std::vector<double>> previousRow(maximumColumn + 1, std::vector<double>(uSize));
+	std::vector<std::vector<double>> currentRow(maximumColumn + 1, std::vector<double>(uSize));
+	std::vector<double> errors(maximumColumn + 1), stepSizes(maximumColumn + 1), costs(maximumColumn + 1);
+
+	std::vector<double> u = uInitial, dudt(uSize), uScaled(uSize);
+	BulirschStoerStatistics statistics;
+	CashKarp::IntegrationStatistics& integration = statistics.integration;
+	double columnSum = 0.0;
+
+	/*
+		Coluna inicial em função da tolerância (Hairer, Nørsett e Wanner).
+	*/
+	double logTolerance = -std::log10(std::max(tolerance, 1e-300));
+	std::size_t optimalColumn = static_cast<std::size_t>(std::max(2.0, 0.6 * logTolerance + 0.5));
+	optimalColumn = std::min(std::max<std::size_t>(optimalColumn, 2), maximumColumn - 1);
+
+	/*
+		Distribuição das sequências entre as threads: da mais cara à mais
+		barata, cada uma vai para a parte com menor custo acumulado.
+	*/
+	ThreadPool::ThreadPool* pool = options.pool;
+	std::size_t parts = (pool != nullptr) ? pool->Size() : 1;
+	std::vector<std::vector<std::size_t>> assignment(parts);
+	std::vector<double> load(parts);
+	double t = tSpan.first, stepSize = 0.0;
+	std::size_t computedColumns = 0;
+
+	auto computeSequences = [&](std::size_t part) {
+		for (std::size_t sequence : assignment[part]) {
+			ModifiedMidpoint(u, dudt, t, stepSize,
+				static_cast<std::size_t>(substeps[sequence]), sequences[sequence], dynFun);
+		}
+	};
+
+	auto computeInParallel = [&](std::size_t lastColumn) {
+		for (std::size_t p = 0; p < parts; p++) {
+			assignment[p].clear();
+			load[p] = 0.0;
+		}
+		for (std::size_t column = lastColumn + 1; column-- > 0;) {
+			std::size_t lightest = std::min_element(load.begin(), load.end()) - load.begin();
+			assignment[lightest].push_back(column);
+			load[lightest] += substeps[column];
+		}
+		pool->RunOnEachThread(computeSequences);
+	};
+
+	stepSize =
+		(tSpan.second - tSpan.first >= 0.0)
+		? std::abs(initialStep)
+		: -std::abs(initialStep);
+
+	stepObserver(t, u);
+
+	for (std::size_t step = 0; step <= maximumNumberOfSteps; step++)
+	{
+		dynFun(t, u, dudt);
+		integration.rhsEvaluations++;
+
+		double tNext = t + stepSize;
+		if ((tNext - tSpan.second) * (tNext - tSpan.first) > 0.0)
+			stepSize = tSpan.second - t;
+
+		/*
+			Tentativas até que o erro de alguma coluna entre
+			optimalColumn - 1 e optimalColumn + 1 seja aceitável.
+		*/
+		std::size_t acceptedColumn = 0;
+		while (acceptedColumn == 0)
+		{
+			if (t + stepSize == t)
+				throw "Mathematical error: step size is equal to zero.";
+
+			for (i = 0; i < uSize; i++)
+				uScaled[i] = std::abs(u[i]) + std::abs(dudt[i] * stepSize) + 1.0e-30;
+
+			std::size_t lastColumn = optimalColumn + 1;
+			computedColumns = 0;
+			if (pool != nullptr) {
+				computeInParallel(lastColumn);
+				computedColumns = lastColumn + 1;
+				for (j = 0; j <= lastColumn; j++)
+					integration.rhsEvaluations += static_cast<std::size_t>(substeps[j]);
+			}
+
+			for (j = 0; j <= lastColumn; j++) {
+				if (j >= computedColumns) {
+					ModifiedMidpoint(u, dudt, t, stepSize,
+						static_cast<std::size_t>(substeps[j]), sequences[j], dynFun);
+					integration.rhsEvaluations += static_cast<std::size_t>(substeps[j]);
+				}
+
+				/*
+					Linha j do quadro de Aitken-Neville.
+				*/
+				std::vector<double>& first = currentRow[0];
+				for (i = 0; i < uSize; i++)
+					first[i] = sequences[j].result[i];
+				for (k = 1; k <= j; k++) {
+					double ratio = substeps[j] / substeps[j - k];
+					double factor = 1.0 / (ratio * ratio - 1.0);
+					const std::vector<double>& left = currentRow[k - 1];
+					const std::vector<double>& above = previousRow[k - 1];
+					std::vector<double>& entry = currentRow[k];
+					for (i = 0; i < uSize; i++)
+						entry[i] = left[i] + (left[i] - above[i]) * factor;
+				}
+				previousRow.swap(currentRow);
+
+				if (j == 0)
+					continue;
+
+				/*
+					Erro de T_j,j-1 e passo que o tornaria 0.65 * tolerance,
+					limitado entre 0.02 e 4 vezes o atual.
+				*/
+				const std::vector<double>& diagonal = previousRow[j];
+				const std::vector<double>& below = previousRow[j - 1];
+				double maximumError = 0.0;
+				for (i = 0; i < uSize; i++)
+					maximumError = std::max(maximumError, std::abs(diagonal[i] - below[i]) / uScaled[i]);
+				maximumError /= tolerance;
+				errors[j] = maximumError;
+
+				double factor = (maximumError > 0.0)
+					? 0.94 * std::pow(0.65 / maximumError, 1.0 / static_cast<double>(2 * j + 1))
+					: 4.0;
+				factor = std::min(4.0, std::max(0.02, factor));
+				stepSizes[j] = stepSize * factor;
+				costs[j] = work[j] / std::abs(stepSizes[j]);
+
+				if (j + 1 >= optimalColumn && maximumError <= 1.0) {
+					acceptedColumn = j;
+					break;
+				}
+			}
+
+			if (acceptedColumn > 0)
+				break;
+
+			/*
+				Passo rejeitado: nova tentativa com o passo estimado para a
+				coluna ótima (ou a anterior, se for mais barata).
+			*/
+			integration.rejectedSteps++;
+			if (optimalColumn > 2 && costs[optimalColumn - 1] < 0.8 * costs[optimalColumn])
+				optimalColumn--;
+			stepSize = stepSizes[optimalColumn];
+		}
+
+		/*
+			Passo aceito: u recebe T_k,k.
+		*/
+		std::vector<double>& solution = previousRow[acceptedColumn];
+		for (i = 0; i < uSize; i++)
+			u[i] = solution[i];
+
+		integration.AcceptStep(stepSize);
+		columnSum += static_cast<double>(acceptedColumn);
+
+		t += stepSize;
+		stepObserver(t, u);
+
+		if ((t - tSpan.second) * (tSpan.second - tSpan.first) >= 0.0)
+			break;
+
+		/*
+			Próxima coluna (até maximumColumn - 1): desce se a anterior for
+			mais barata por unidade de t, sobe se o passo foi aceito na coluna
+			ótima e o custo ainda está diminuindo.
+		*/
+		std::size_t column = acceptedColumn;
+		double nextStepSize = stepSizes[column];
+		if (column + 1 > maximumColumn ||
+			(column > 2 && costs[column - 1] < 0.8 * costs[column]))
+		{
+			column--;
+			nextStepSize = stepSizes[column];
+		}
+		else if (column >= optimalColumn && column + 1 < maximumColumn &&
+			costs[column] < 0.9 * costs[column - 1])
+		{
+			nextStepSize = stepSizes[column] * work[column + 1] / work[column];
+			column++;
+		}
+		optimalColumn = std::max<std::size_t>(2, column);
+		stepSize = nextStepSize;
+	}
+
+	statistics.meanColumn =
+		(integration.acceptedSteps > 0) ? columnSum / integration.acceptedSteps : 0.0;
+	return statistics;
+}
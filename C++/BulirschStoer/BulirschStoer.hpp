@@ -0,0 +1,99 @@
+/**
+* @file BulirschStoer.hpp
+* @brief Método de extrapolação de Gragg-Bulirsch-Stoer, com ordem variável
+*/
+
+/*
+	* Numerical Recipes, seção 16.4 (mesmo capítulo de Cash-Karp). Um passo
+	H é calculado pela regra do ponto médio modificada (Gragg) com
+	n_j = 2, 4, 6, ... subpassos; como o erro desta regra só contém potências
+	pares de H / n_j, os resultados T_j,0 são extrapolados para H / n -> 0
+	pelo esquema de Aitken-Neville:
+		T_j,k = T_j,k-1 + (T_j,k-1 - T_j-1,k-1) / ((n_j / n_j-k)^2 - 1)
+	A coluna k tem ordem 2k + 2, e T_k,k - T_k,k-1 estima o erro de T_k,k-1.
+
+	* Controle de ordem e de passo como em ODEX (Hairer, Nørsett e Wanner,
+	"Solving Ordinary Differential Equations I", seção II.9): o passo é
+	aceito na primeira coluna k, entre kOptimal - 1 e kOptimal + 1, cujo erro
+	é menor que a tolerância; a próxima coluna é a de menor trabalho por
+	unidade de t (chamadas a dynFun / passo estimado), e pode subir ou descer
+	uma posição a cada passo. Em problemas suaves com tolerâncias rigorosas
+	(1e-10 a 1e-12) a ordem sobe até 12 a 16, com passos muito maiores que os
+	de Cash-Karp (ordem 5).
+
+	* As sequências de ponto médio de um passo são independentes: com um
+	ThreadPool, todas as colunas até kOptimal + 1 são calculadas de uma vez,
+	distribuídas entre as threads pelo custo (n_j chamadas a dynFun cada),
+	e a extrapolação e a verificação do erro são feitas em seguida. O
+	resultado é idêntico ao da versão sem threads. dynFun é então chamada
+	simultaneamente por várias threads, portanto não deve alterar estados
+	compartilhados.
+
+	* Arquivo de cabeçalho, não contém implementações.
+*/
+
+#pragma once
+
+#include "CashKarp.hpp"
+#include "ThreadPool.hpp"
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace BulirschStoer {
+	/**
+	* @brief Parâmetros do método.
+	*/
+	struct BulirschStoerOptions {
+		// Maior coluna do quadro de extrapolação (ordem 2k + 2), até 15
+		std::size_t maximumColumn = 8;
+		// Threads para as sequências de ponto médio; sem threads se nulo
+		ThreadPool::ThreadPool* pool = nullptr;
+	};
+
+	/**
+	* @brief Estatísticas da integração.
+	*/
+	struct BulirschStoerStatistics {
+		// Passos aceitos e rejeitados, chamadas a dynFun e passos mínimo e máximo
+		CashKarp::IntegrationStatistics integration;
+		// Média da coluna em que os passos foram aceitos
+		double meanColumn = 0.0;
+	};
+
+	/**
+	* @brief Rotina que aplica o método de Bulirsch-Stoer para realizar a
+	* integração de um sistema de EDO`s em um intervalo, entregando cada
+	* passo aceito a uma função.
+	* O erro é medido como em CashKarpRange (relativo a |u| + |h * du/dt|).
+	* @param[in] uInitial Valores iniciais do sistema de EDO`s (entrada)
+	* @param[in] tSpan Intervalo de integração, com início e fim (entrada)
+	* @param[in] tolerance Tolerância aceita pelo algoritmo (entrada)
+	* @param[in] initialStep Passo inicial (entrada)
+	* @param[in] minimumStep Passo mínimo, atualmente não implementado (entrada)
+	* @param[in] maximumNumberOfSteps Quantidade máxima de iterações (entrada)
+	* @param[in] dynFun Função que computa os valores do sistema de EDO`s (entrada)
+	* @param[in] stepObserver Função chamada com t e u no ponto inicial e após
+	* cada passo aceito (entrada)
+	* @param[in] options Parâmetros do método (entrada)
+	* @return Estatísticas da integração
+	*/
+	BulirschStoerStatistics BulirschStoerRange(
+		std::vector<double>& uInitial,
+		std::pair<double, double>& tSpan,
+		double tolerance,
+		double initialStep,
+		double minimumStep,
+		std::size_t maximumNumberOfSteps,
+		std::function<
+		void(double,
+			std::vector<double>&,
+			std::vector<double>&)
+		>& dynFun,
+		std::function<
+		void(double,
+			std::vector<double>&)
+		>& stepObserver,
+		const BulirschStoerOptions& options = BulirschStoerOptions());
+}
@@ -21,12 +21,21 @@
 */
 
 #include "CashKarp.hpp"
+#include "CashKarpTrace.hpp"
+#include "CashKarpCheckpoint.hpp"
+#include "CashKarpStepControl.hpp"
+#include "CashKarpCycleCounter.hpp"
 #include <utility>
 #include <vector>
 #include <functional>
 #include <iostream>
-#include <intrin.h>
 #include <cmath>
+#include <algorithm>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
 
 void CashKarp::CashKarpStep(
 	std::vector<double>& u,
@@ -210,6 +219,12 @@ void CashKarp::CashKarpStepAVX2(
 		)
 	>& dynFun)
 {
+#if !__AVX2__
+	/*
+		Compilao sem suporte a AVX2: utiliza a implementao escalar.
+	*/
+	CashKarpStep(u, dudt, t, stepSize, uOutput, uError, dynFun);
+#else
 	/*
 		Valor dos coeficientes  constante, logo so utilizadas
 		variveis estticas.
@@ -279,10 +294,16 @@ void CashKarp::CashKarpStepAVX2(
 	std::vector<double> kTemporary(uSize);
 	std::vector<double> uTemporary(uSize);
 
-	static int* mask = new int[4]{};
-	static double* aux = new double[4]{};
-	for (i = 0; i < uSize; i++)
-		mask[i] = -1;
+	/*
+		Mscara e vetor auxiliar locais (e no estticos), para que a funo
+		possa ser chamada simultaneamente por vrias threads. Posies alm do
+		tamanho do sistema so zeradas na mscara, para que a leitura no
+		ultrapasse os limites dos vetores.
+	*/
+	int mask[4];
+	double aux[4];
+	for (i = 0; i < 4; i++)
+		mask[i] = (i < uSize) ? -1 : 0;
 
 	__m256i _mask = _mm256_set_epi64x(mask[3], mask[2], mask[1], mask[0]);
 	__m256d _u = _mm256_maskload_pd(u.data(), _mask);
@@ -302,7 +323,7 @@ void CashKarp::CashKarpStepAVX2(
 	_aux = _mm256_mul_pd(_aux, _dudt);
 	// u + a21 * stepSize * dudt
 	_aux = _mm256_add_pd(_aux, _u);
-	_mm256_store_pd(aux, _aux);
+	_mm256_storeu_pd(aux, _aux);
 	uTemporary.assign(aux, aux + uSize);
 
 	dynFun(t + c2 * stepSize, uTemporary, kTemporary);
@@ -327,7 +348,7 @@ void CashKarp::CashKarpStepAVX2(
 
 	// u + stepSize * (a31 * dudt + a32 * k2)
 	_aux = _mm256_add_pd(_aux, _u);
-	_mm256_store_pd(aux, _aux);
+	_mm256_storeu_pd(aux, _aux);
 	uTemporary.assign(aux, aux + uSize);
 
 	dynFun(t + c3 * stepSize, uTemporary, kTemporary);
@@ -364,7 +385,7 @@ void CashKarp::CashKarpStepAVX2(
 
 	// u + stepSize * (a41 * dudt + a42* k2 + a43 * k3);
 	_aux = _mm256_add_pd(_aux, _u);
-	_mm256_store_pd(aux, _aux);
+	_mm256_storeu_pd(aux, _aux);
 	uTemporary.assign(aux, aux + uSize);
 
 	dynFun(t + c4 * stepSize, uTemporary, kTemporary);
@@ -409,7 +430,7 @@ void CashKarp::CashKarpStepAVX2(
 
 	// u + stepSize * (a51 * dudt + a52 * k2 + a53 * k3 + a54 * k4)
 	_aux = _mm256_add_pd(_u, _aux);
-	_mm256_store_pd(aux, _aux);
+	_mm256_storeu_pd(aux, _aux);
 	uTemporary.assign(aux, aux + uSize);
 
 	dynFun(t + c5 * stepSize, uTemporary, kTemporary);
@@ -462,7 +483,7 @@ void CashKarp::CashKarpStepAVX2(
 
 	// u + stepSize * (a61 * dudt + a62 * k2 + a63 * k3 + a64 * k4 + a65 * k5)
 	_aux = _mm256_add_pd(_aux, _u);
-	_mm256_store_pd(aux, _aux);
+	_mm256_storeu_pd(aux, _aux);
 	uTemporary.assign(aux, aux + uSize);
 
 	dynFun(t + c6 * stepSize, uTemporary, kTemporary);
@@ -508,7 +529,7 @@ void CashKarp::CashKarpStepAVX2(
 
 	// u + stepSize * (b1 * dudt + b3 * k3 + b4 * k4 + b6 * k6)
 	_aux = _mm256_add_pd(_aux, _u);
-	_mm256_store_pd(aux, _aux);
+	_mm256_storeu_pd(aux, _aux);
 	uOutput.assign(aux, aux + uSize);
 
 	/*
@@ -553,13 +574,14 @@ void CashKarp::CashKarpStepAVX2(
 	// stepSize * (d1 * dudt + d3 * k3 + d4 * k4 + d5 * k5 + d6 * k6)
 	_aux2 = _mm256_broadcast_sd(&stepSize);
 	_aux = _mm256_mul_pd(_aux, _aux2);
-	_mm256_store_pd(aux, _aux);
+	_mm256_storeu_pd(aux, _aux);
 	uError.assign(aux, aux + uSize);
 
 	/*
 		Fim do mtodo
 		End of the function
 	*/
+#endif
 }
 
 void CashKarp::CashKarpQualityStep(
@@ -576,14 +598,15 @@ void CashKarp::CashKarpQualityStep(
 		double,
 		std::vector<double>&,
 		std::vector<double>&)>
-	& dynFun)
+	& dynFun,
+	IntegrationStatistics* statistics,
+	StepTrace* trace)
 {
-	std::size_t i;
 	std::size_t uSize = u.size();
 	std::vector<double> uTemporary(uSize);
 	std::vector<double> uError(uSize);
-	double maximumError, stepSize, temporaryStepSize, tNew;
-	static double errorComparingValue = std::pow(5.0 / 0.9, 1.0 / -0.2);
+	double maximumError, stepSize, tNew;
+	static const StepControl<double> stepControl(4);
 
 	/*
 		* Verificando se  possivel utilizar funo que faz uso dos
@@ -600,11 +623,26 @@ void CashKarp::CashKarpQualityStep(
 	stepSize = stepSizeTry;
 	while (true)
 	{
+		std::uint64_t attemptStart = 0, rhsStart = 0;
+		if (trace != nullptr) {
+			attemptStart = trace->Now();
+			rhsStart = trace->RhsNanoseconds();
+		}
+
 		if (useAVX)
 			CashKarpStepAVX2(u, dudt, t, stepSize, uTemporary, uError, dynFun);
 		else
 			CashKarpStep(u, dudt, t, stepSize, uTemporary, uError, dynFun);
 
+#if CASHKARP_STATISTICS
+		/*
+			Cada tentativa realiza exatamente 5 chamadas a dynFun, logo no
+			 necessrio envolver a funo para cont-las.
+		*/
+		if (statistics != nullptr)
+			statistics->rhsEvaluations += 5;
+#endif
+
 		/*
 			Identificando maior erro no sistema de equaes.
 			Aqui o erro  definido como o mdulo do erro estimado na
@@ -616,14 +654,8 @@ void CashKarp::CashKarpQualityStep(
 			 utilizado o vetor de valores uScaled, que leva a ordem de
 			grandeza destes valores em conta para apresentar suas tolerncias.
 		*/
-		maximumError = 0.0;
-		for (i = 0; i < uSize; i++) {
-			double newError = std::abs(uError[i] / uScaled[i]);
-			if (newError > 1.0e16) {
-				newError = std::abs(uError[i] / uTemporary[i]);
-			}
-			maximumError = std::max<double>(maximumError, newError);
-		}
+		maximumError = stepControl.MaximumError(
+			uError.data(), uScaled.data(), uTemporary.data(), uSize);
 
 		/*
 			Comparando esse erro com a tolerncia especificada.
@@ -635,17 +667,26 @@ void CashKarp::CashKarpQualityStep(
 		*/
 		maximumError /= tolerance;
 
+		if (trace != nullptr) {
+			std::uint64_t attemptEnd = trace->Now();
+			trace->Record({
+				t, stepSize, maximumError, maximumError <= 1.0,
+				attemptStart, attemptEnd - attemptStart,
+				trace->RhsNanoseconds() - rhsStart });
+		}
+
 		if (maximumError <= 1.0)
 			break;
 
+#if CASHKARP_STATISTICS
+		if (statistics != nullptr)
+			statistics->rejectedSteps++;
+#endif
+
 		/*
 			Caso contrrio,  necessrio calcular um novo stepSize.
 		*/
-		temporaryStepSize = 0.9 * stepSize * std::pow(maximumError, -0.25);
-		stepSize =
-			(stepSize >= 0.0)
-			? std::max(temporaryStepSize, 0.1 * stepSize)
-			: std::min(temporaryStepSize, 0.1 * stepSize);
+		stepSize = stepControl.RejectedStepSize(stepSize, maximumError);
 		/*
 			Avaliando qual ser o prximo valor de t com base no
 			novo stepSize. Se esse novo valor for igual ao antigo,
@@ -664,10 +705,7 @@ void CashKarp::CashKarpQualityStep(
 		para o prximo passo adaptativo. Caso contrrio, ser
 		novamente diminuído.
 	*/
-	nextStepSize =
-		(maximumError > errorComparingValue)
-		? 0.9 * stepSize * std::pow(maximumError, -0.2)
-		: 5.0 * stepSize;
+	nextStepSize = stepControl.NextStepSize(stepSize, maximumError);
 
 	/*
 		Armazenando valor do stepSize utilizado e
@@ -676,13 +714,18 @@ void CashKarp::CashKarpQualityStep(
 	previousStepSize = stepSize;
 	t += previousStepSize;
 
+#if CASHKARP_STATISTICS
+	if (statistics != nullptr)
+		statistics->AcceptStep(stepSize);
+#endif
+
 	/*
 		Salvando valores de u e encerrando o mtodo.
 	*/
 	u = uTemporary;
 }
 
-void CashKarp::CashKarpRange(
+CashKarp::IntegrationStatistics CashKarp::CashKarpRange(
 	std::vector<double>& uInitial,
 	std::pair<double, double>& tSpan,
 	double tolerance,
@@ -697,59 +740,197 @@ void CashKarp::CashKarpRange(
 	std::vector<double>& tValues,
 	std::vector<
 	std::vector<double>
-	>& uValues)
+	>& uValues,
+	StepTrace* trace)
 {
-	std::size_t i, numberOfSteps, uSize = uInitial.size();
-	std::vector<double> uScaled(uSize);
-	std::vector<double> u(uSize);
-	std::vector<double> dudt(uSize);
-
-	double t, previousStepSize, stepSize, nextStepSize;
-
 	tValues.clear();
 	uValues.clear();
 
-	t = tSpan.first;
-	tValues.push_back(t);
+	/*
+		Armazena cada passo aceito na memria.
+	*/
+	std::function<
+	void(double,
+		std::vector<double>&)
+	> stepObserver = [&tValues, &uValues](
+		double t,
+		std::vector<double>& u)
+	{
+		tValues.push_back(t);
+		uValues.push_back(u);
+	};
+
+	return CashKarpRange(
+		uInitial, tSpan, tolerance, initialStep, minimumStep,
+		maximumNumberOfSteps, dynFun, stepObserver, trace);
+}
 
-	u = uInitial;
-	uValues.push_back(uInitial);
+CashKarp::IntegrationStatistics CashKarp::CashKarpRange(
+	std::vector<double>& uInitial,
+	std::pair<double, double>& tSpan,
+	double tolerance,
+	double initialStep,
+	double minimumStep,
+	std::size_t maximumNumberOfSteps,
+	std::function<
+	void(double,
+		std::vector<double>&,
+		std::vector<double>&)
+	>& dynFun,
+	std::function<
+	void(double,
+		std::vector<double>&)
+	>& stepObserver,
+	StepTrace* trace)
+{
+	IntegratorState state = CashKarpInitialState(uInitial, tSpan, initialStep);
+	return CashKarpRange(
+		state, tSpan, tolerance, minimumStep, maximumNumberOfSteps,
+		dynFun, stepObserver, nullptr, trace);
+}
 
-	stepSize =
+CashKarp::IntegratorState CashKarp::CashKarpInitialState(
+	std::vector<double>& uInitial,
+	std::pair<double, double>& tSpan,
+	double initialStep)
+{
+	IntegratorState state;
+	state.t = tSpan.first;
+	state.u = uInitial;
+	state.stepSize =
 		(tSpan.second - tSpan.first >= 0.0)
 		? fabs(initialStep)
 		: -fabs(initialStep);
+	return state;
+}
 
-	for (
-		numberOfSteps = 0;
-		numberOfSteps <= maximumNumberOfSteps;
-		numberOfSteps++)
+CashKarp::IntegrationStatistics CashKarp::CashKarpRange(
+	IntegratorState& state,
+	std::pair<double, double>& tSpan,
+	double tolerance,
+	double minimumStep,
+	std::size_t maximumNumberOfSteps,
+	std::function<
+	void(double,
+		std::vector<double>&,
+		std::vector<double>&)
+	>& dynFun,
+	std::function<
+	void(double,
+		std::vector<double>&)
+	>& stepObserver,
+	const CheckpointOptions* checkpoint,
+	StepTrace* trace)
+{
+	std::size_t i, uSize = state.u.size();
+	std::vector<double> uScaled(uSize);
+	std::vector<double> dudt(uSize);
+
+	double nextStepSize;
+	IntegrationStatistics& statistics = state.statistics;
+
+#if CASHKARP_STATISTICS >= 2
+	/*
+		Envolve dynFun para medir o tempo gasto nas chamadas. O tempo
+		restante  atribudo ao prprio integrador.
+	*/
+	std::uint64_t startCycles = ReadCycleCounter();
+	std::uint64_t startRhsCycles = statistics.rhsCycles;
+	std::function<
+	void(double,
+		std::vector<double>&,
+		std::vector<double>&)
+	> instrumentedFun = [&dynFun, &statistics](
+		double tStage,
+		std::vector<double>& uStage,
+		std::vector<double>& dudtStage)
+	{
+		std::uint64_t rhsStart = ReadCycleCounter();
+		dynFun(tStage, uStage, dudtStage);
+		statistics.rhsCycles += ReadCycleCounter() - rhsStart;
+	};
+#else
+	auto& instrumentedFun = dynFun;
+#endif
+
+	/*
+		Com o histrico ativado, dynFun  envolvida novamente para que o
+		tempo gasto nela seja registrado em cada tentativa.
+	*/
+	std::function<
+	void(double,
+		std::vector<double>&,
+		std::vector<double>&)
+	> tracedFun;
+	if (trace != nullptr)
+		tracedFun = trace->Wrap(instrumentedFun);
+	auto& rhs = (trace != nullptr) ? tracedFun : instrumentedFun;
+
+#if CASHKARP_STATISTICS
+	IntegrationStatistics* statisticsPointer = &statistics;
+#else
+	IntegrationStatistics* statisticsPointer = nullptr;
+#endif
+
+	/*
+		Integrao nova: o ponto inicial faz parte da trajetria.
+		Integrao retomada j concluda: no h nada a fazer.
+	*/
+	if (state.numberOfSteps == 0)
+		stepObserver(state.t, state.u);
+	else if ((state.t - tSpan.second) * (tSpan.second - tSpan.first) >= 0.0)
+		return statistics;
+
+	while (state.numberOfSteps <= maximumNumberOfSteps)
 	{
-		dynFun(t, u, dudt);
+		rhs(state.t, state.u, dudt);
+#if CASHKARP_STATISTICS
+		statistics.rhsEvaluations++;
+#endif
 
 		for (i = 0; i < uSize; i++)
 		{
 			uScaled[i] =
-				std::abs(u[i]) +
-				std::abs(dudt[i] * stepSize) +
+				std::abs(state.u[i]) +
+				std::abs(dudt[i] * state.stepSize) +
 				1.0e-30;
 		}
 
-		double tNext = t + stepSize;
+		double tNext = state.t + state.stepSize;
 		if ((tNext - tSpan.second) * (tNext - tSpan.first) > 0.0)
-			stepSize = tSpan.second - t;
+			state.stepSize = tSpan.second - state.t;
 
 		CashKarpQualityStep(
-			u, dudt, uScaled, t, stepSize,
-			tolerance, previousStepSize,
-			nextStepSize, dynFun);
+			state.u, dudt, uScaled, state.t, state.stepSize,
+			tolerance, state.previousStepSize,
+			nextStepSize, rhs,
+			statisticsPointer, trace);
 
-		tValues.push_back(t);
-		uValues.push_back(u);
+		stepObserver(state.t, state.u);
+
+		if ((state.t - tSpan.second) * (tSpan.second - tSpan.first) >= 0.0)
+			break;
 
-		if ((t - tSpan.second) * (tSpan.second - tSpan.first) >= 0.0)
-			return; 
+		state.stepSize = nextStepSize;
+		state.numberOfSteps++;
 
-		stepSize = nextStepSize;
+		/*
+			O checkpoint  gravado entre dois passos, quando o estado est
+			completo: retomar a partir dele repete exatamente as mesmas
+			operaes.
+		*/
+		if (checkpoint != nullptr &&
+			checkpoint->interval > 0 &&
+			state.numberOfSteps % checkpoint->interval == 0)
+		{
+			SaveCheckpoint(checkpoint->path, state);
+		}
 	}
+
+#if CASHKARP_STATISTICS >= 2
+	statistics.integratorCycles +=
+		ReadCycleCounter() - startCycles - (statistics.rhsCycles - startRhsCycles);
+#endif
+
+	return statistics;
 }
\ No newline at end of file
@@ -17,14 +17,119 @@
 	* Arquivo de cabeçalho, não contém implementações.
 */
 
+#pragma once
+
+#include <algorithm>
+#include <cmath>
 #include <vector>
 #include <functional>
+#include <cstdint>
+#include <string>
+#include <utility>
 
 #ifndef __AVX2__
 #define __AVX2__ 0
 #endif
 
+/*
+	* Nível de coleta de estatísticas de integração (ver IntegrationStatistics).
+	Definido pelo CMake através das opções USE_STATISTICS e
+	USE_STATISTICS_CYCLES:
+	-> 0: toda a instrumentação é removida em tempo de compilação e as
+	rotinas retornam estatísticas zeradas.
+	-> 1: contadores de chamadas, passos e tamanhos de passo (custo
+	desprezível, nenhuma chamada extra no caminho crítico).
+	-> 2: além dos contadores, mede ciclos gastos em dynFun e no integrador.
+*/
+#ifndef CASHKARP_STATISTICS
+#define CASHKARP_STATISTICS 0
+#endif
+
 namespace CashKarp {
+	// Histórico de passos, declarado em CashKarpTrace.hpp
+	class StepTrace;
+
+	/**
+	* @brief Estatísticas de uma integração, equivalentes aos campos fevals e
+	* telapsed retornados pelas implementações em Octave.
+	* Os tempos são medidos em ciclos (contador de ciclos do processador), de
+	* forma que rhsCycles + integratorCycles corresponde ao tempo total.
+	* Somente são preenchidos se CASHKARP_STATISTICS for 2.
+	*/
+	struct IntegrationStatistics {
+		// Quantidade de chamadas à função dynFun
+		std::size_t rhsEvaluations = 0;
+		// Passos aceitos (dentro da tolerância)
+		std::size_t acceptedSteps = 0;
+		// Tentativas rejeitadas, que exigiram refinamento do passo
+		std::size_t rejectedSteps = 0;
+		// Menor e maior passo aceito (em módulo)
+		double minimumStep = 0.0;
+		double maximumStep = 0.0;
+		// Soma dos passos aceitos (em módulo), utilizada por MeanStep()
+		double stepSum = 0.0;
+		// Ciclos gastos dentro de dynFun
+		std::uint64_t rhsCycles = 0;
+		// Ciclos gastos no próprio integrador (aritmética e controle de passo)
+		std::uint64_t integratorCycles = 0;
+
+		/**
+		* @brief Passo médio aceito (em módulo).
+		*/
+		double MeanStep() const {
+			return (acceptedSteps > 0) ? stepSum / acceptedSteps : 0.0;
+		}
+
+		/**
+		* @brief Contabiliza um passo aceito: quantidade, passos mínimo e
+		* máximo e soma dos passos.
+		* @param[in] stepSize Passo aceito, de qualquer sinal (entrada)
+		*/
+		void AcceptStep(double stepSize) {
+			double stepMagnitude = std::abs(stepSize);
+			if (acceptedSteps == 0) {
+				minimumStep = stepMagnitude;
+				maximumStep = stepMagnitude;
+			}
+			else {
+				minimumStep = std::min(minimumStep, stepMagnitude);
+				maximumStep = std::max(maximumStep, stepMagnitude);
+			}
+			acceptedSteps++;
+			stepSum += stepMagnitude;
+		}
+	};
+
+	/**
+	* @brief Estado completo de uma integração entre dois passos.
+	* A partir dele CashKarpRange continua a integração exatamente como se
+	* não tivesse sido interrompida (ver CashKarpCheckpoint.hpp).
+	*/
+	struct IntegratorState {
+		// Valor atual da variável independente t
+		double t = 0.0;
+		// Valores atuais de u
+		std::vector<double> u;
+		// Passo a ser tentado na próxima iteração
+		double stepSize = 0.0;
+		// Último passo aceito
+		double previousStepSize = 0.0;
+		// Quantidade de passos aceitos até o momento
+		std::size_t numberOfSteps = 0;
+		// Estatísticas acumuladas desde o início da integração
+		IntegrationStatistics statistics;
+	};
+
+	/**
+	* @brief Configuração dos checkpoints gravados por CashKarpRange.
+	*/
+	struct CheckpointOptions {
+		// Arquivo onde o checkpoint é gravado (sobrescrito a cada gravação)
+		std::string path;
+		// Quantidade de passos aceitos entre duas gravações
+		std::size_t interval = 1000;
+	};
+
 	/**
 	* @brief Rotina utilizada para calcular um passo utilizando o Runge-Kutta de
 	* Cash-Karp.
@@ -100,6 +205,11 @@ namespace CashKarp {
 	* @param[in] previousStepSize Valor do passo na iteração anterior (entrada)
 	* @param[out] nextStepSize Valor do passo na próxima iteração (saída)
 	* @param[in] dynFun Função que calcula as derivadas de primeira ordem (entrada)
+	* @param[in, out] statistics Estatísticas atualizadas com os passos aceitos e
+	* rejeitados, ignorado se nulo (entrada e saída)
+	* @param[in, out] trace Histórico onde cada tentativa é registrada, ignorado
+	* se nulo. dynFun deve ter sido envolvida por StepTrace::Wrap para que o
+	* tempo gasto nela seja registrado (entrada e saída)
 	*/
 	void CashKarpQualityStep(
 		std::vector<double>& u,
@@ -115,7 +225,9 @@ namespace CashKarp {
 			double,
 			std::vector<double>&,
 			std::vector<double>&)>
-		& dynFun);
+		& dynFun,
+		IntegrationStatistics* statistics = nullptr,
+		StepTrace* trace = nullptr);
 
 	/**
 	* @brief Rotina que aplica o método de Cash-Karp para realizar a integração
@@ -129,8 +241,11 @@ namespace CashKarp {
 	* @param[in] dynFun Função que computa os valores do sistema de EDO`s (entrada)
 	* @param[in, out] tValues Valores de t (variável independente) (entrada e saída)
 	* @param[in, out] uValues Valores de u (variável dependente) (entrada e saída)
+	* @param[in, out] trace Histórico onde cada tentativa de passo é registrada,
+	* ignorado se nulo (entrada e saída)
+	* @return Estatísticas da integração (zeradas se CASHKARP_STATISTICS for 0)
 	*/
-	void CashKarpRange(
+	IntegrationStatistics CashKarpRange(
 		std::vector<double>& uInitial,
 		std::pair<double, double>& tSpan,
 		double tolerance,
@@ -145,5 +260,97 @@ namespace CashKarp {
 		std::vector<double>& tValues,
 		std::vector<
 		std::vector<double>
-		>& uValues);
+		>& uValues,
+		StepTrace* trace = nullptr);
+
+	/**
+	* @brief Rotina que aplica o método de Cash-Karp para realizar a integração
+	* de um determinado sistema de EDO`s em um intervalo específico, entregando
+	* cada passo aceito a uma função em vez de armazená-los na memória.
+	* Permite gravar trajetórias maiores que a memória disponível (ver
+	* Trajectory::MappedTrajectoryWriter).
+	* @param[in] uInitial Valores iniciais do sistema de EDO`s (entrada)
+	* @param[in] tSpan Intervalo de integração, com início e fim (entrada)
+	* @param[in] tolerance Tolerância aceita pelo algoritmo (entrada)
+	* @param[in] initialStep Passo inicial (entrada)
+	* @param[in] minimumStep Passo mínimo, atualmente não implementado (entrada)
+	* @param[in] maximumNumberOfSteps Quantidade máxima de iterações (entrada)
+	* @param[in] dynFun Função que computa os valores do sistema de EDO`s (entrada)
+	* @param[in] stepObserver Função chamada com t e u no ponto inicial e após
+	* cada passo aceito (entrada)
+	* @param[in, out] trace Histórico onde cada tentativa de passo é registrada,
+	* ignorado se nulo (entrada e saída)
+	* @return Estatísticas da integração (zeradas se CASHKARP_STATISTICS for 0)
+	*/
+	IntegrationStatistics CashKarpRange(
+		std::vector<double>& uInitial,
+		std::pair<double, double>& tSpan,
+		double tolerance,
+		double initialStep,
+		double minimumStep,
+		std::size_t maximumNumberOfSteps,
+		std::function<
+		void(double,
+			std::vector<double>&,
+			std::vector<double>&)
+		>& dynFun,
+		std::function<
+		void(double,
+			std::vector<double>&)
+		>& stepObserver,
+		StepTrace* trace = nullptr);
+
+	/**
+	* @brief Estado inicial de uma integração, equivalente ao utilizado
+	* internamente por CashKarpRange.
+	* @param[in] uInitial Valores iniciais do sistema de EDO`s (entrada)
+	* @param[in] tSpan Intervalo de integração, com início e fim (entrada)
+	* @param[in] initialStep Passo inicial (entrada)
+	*/
+	IntegratorState CashKarpInitialState(
+		std::vector<double>& uInitial,
+		std::pair<double, double>& tSpan,
+		double initialStep);
+
+	/**
+	* @brief Rotina que aplica o método de Cash-Karp a partir de um estado,
+	* inicial (CashKarpInitialState) ou restaurado de um checkpoint
+	* (LoadCheckpoint), gravando checkpoints periodicamente.
+	* O resultado é idêntico, bit a bit, ao de uma integração sem interrupções.
+	* O ponto inicial só é entregue a stepObserver se nenhum passo tiver sido
+	* dado; ao retomar, os passos posteriores ao checkpoint são entregues
+	* novamente.
+	* @param[in, out] state Estado da integração, atualizado a cada passo
+	* (entrada e saída)
+	* @param[in] tSpan Intervalo de integração, com início e fim (entrada)
+	* @param[in] tolerance Tolerância aceita pelo algoritmo (entrada)
+	* @param[in] minimumStep Passo mínimo, atualmente não implementado (entrada)
+	* @param[in] maximumNumberOfSteps Quantidade máxima de iterações, contadas
+	* desde o início da integração (entrada)
+	* @param[in] dynFun Função que computa os valores do sistema de EDO`s (entrada)
+	* @param[in] stepObserver Função chamada com t e u após cada passo aceito
+	* (entrada)
+	* @param[in] checkpoint Configuração dos checkpoints, nenhum é gravado se
+	* nulo (entrada)
+	* @param[in, out] trace Histórico onde cada tentativa de passo é registrada,
+	* ignorado se nulo (entrada e saída)
+	* @return Estatísticas acumuladas desde o início da integração
+	*/
+	IntegrationStatistics CashKarpRange(
+		IntegratorState& state,
+		std::pair<double, double>& tSpan,
+		double tolerance,
+		double minimumStep,
+		std::size_t maximumNumberOfSteps,
+		std::function<
+		void(double,
+			std::vector<double>&,
+			std::vector<double>&)
+		>& dynFun,
+		std::function<
+		void(double,
+			std::vector<double>&)
+		>& stepObserver,
+		const CheckpointOptions* checkpoint = nullptr,
+		StepTrace* trace = nullptr);
 }
\ No newline at end of file
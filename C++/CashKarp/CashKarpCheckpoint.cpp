@@ -0,0 +1,170 @@
+/**
+* @file CashKarpCheckpoint.cpp
+* @brief Checkpoints binários do estado de integração do método de Cash-Karp
+*/
+
+#include "CashKarpCheckpoint.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+namespace {
+	const char checkpointMagic[8] = { 'C', 'K', 'C', 'H', 'K', 'P', 'T', 0 };
+	const std::uint32_t checkpointVersion = 1;
+
+	/*
+		Soma de verificação FNV-1a de 64 bits.
+	*/
+	std::uint64_t Checksum(const unsigned char* data, std::size_t size) {
+		std::uint64_t hash = 14695981039346656037ULL;
+		for (std::size_t i = 0; i < size; i++) {
+			hash ^= data[i];
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+
+	/*
+		Acrescenta a representação binária de um valor ao buffer.
+	*/
+	template <typename T>
+	void Put(std::vector<unsigned char>& buffer, const T& value) {
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+		buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+	}
+
+	/*
+		Lê um valor do buffer, avançando a posição de leitura.
+	*/
+	template <typename T>
+	T Get(const std::vector<unsigned char>& buffer, std::size_t& position) {
+		if (position + sizeof(T) > buffer.size())
+			throw "Checkpoint inválido: arquivo incompleto.";
+		T value;
+		std::memcpy(&value, buffer.data() + position, sizeof(T));
+		position += sizeof(T);
+		return value;
+	}
+
+	/*
+		Substitui o arquivo destination por source.
+		std::rename não substitui arquivos existentes no Windows.
+	*/
+	bool ReplaceCheckpointFile(const std::string& source, const std::string& destination) {
+#ifdef _WIN32
+		return MoveFileExA(
+			source.c_str(), destination.c_str(),
+			MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+		return std::rename(source.c_str(), destination.c_str()) == 0;
+#endif
+	}
+}
+
+void CashKarp::SaveCheckpoint(const std::string& path, const IntegratorState& state)
+{
+	std::vector<unsigned char> buffer;
+	buffer.reserve(128 + state.u.size() * sizeof(double));
+
+	buffer.insert(buffer.end(), checkpointMagic, checkpointMagic + sizeof(checkpointMagic));
+	Put(buffer, checkpointVersion);
+	Put(buffer, static_cast<std::uint64_t>(state.u.size()));
+
+	Put(buffer, state.t);
+	Put(buffer, state.stepSize);
+	Put(buffer, state.previousStepSize);
+	Put(buffer, static_cast<std::uint64_t>(state.numberOfSteps));
+
+	const IntegrationStatistics& statistics = state.statistics;
+	Put(buffer, static_cast<std::uint64_t>(statistics.rhsEvaluations));
+	Put(buffer, static_cast<std::uint64_t>(statistics.acceptedSteps));
+	Put(buffer, static_cast<std::uint64_t>(statistics.rejectedSteps));
+	Put(buffer, statistics.minimumStep);
+	Put(buffer, statistics.maximumStep);
+	Put(buffer, statistics.stepSum);
+	Put(buffer, statistics.rhsCycles);
+	Put(buffer, statistics.integratorCycles);
+
+	for (double value : state.u)
+		Put(buffer, value);
+
+	Put(buffer, Checksum(buffer.data(), buffer.size()));
+
+	std::string temporaryPath = path + ".tmp";
+	{
+		std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!out)
+			throw "Não foi possível criar o arquivo de checkpoint.";
+		out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+		out.flush();
+		if (!out)
+			throw "Não foi possível gravar o arquivo de checkpoint.";
+	}
+
+	if (!ReplaceCheckpointFile(temporaryPath, path))
+		throw "Não foi possível substituir o arquivo de checkpoint.";
+}
+
+CashKarp::IntegratorState CashKarp::LoadCheckpoint(const std::string& path)
+{
+	std::ifstream in(path, std::ios::binary);
+	if (!in)
+		throw "Não foi possível abrir o arquivo de checkpoint.";
+	std::vector<unsigned char> buffer(
+		(std::istreambuf_iterator<char>(in)),
+		std::istreambuf_iterator<char>());
+
+	if (buffer.size() < sizeof(checkpointMagic) + sizeof(std::uint64_t))
+		throw "Checkpoint inválido: arquivo incompleto.";
+
+	/*
+		A soma de verificação ocupa os últimos 8 bytes do arquivo.
+	*/
+	std::size_t contentSize = buffer.size() - sizeof(std::uint64_t);
+	std::uint64_t storedChecksum;
+	std::memcpy(&storedChecksum, buffer.data() + contentSize, sizeof(storedChecksum));
+	if (Checksum(buffer.data(), contentSize) != storedChecksum)
+		throw "Checkpoint inválido: soma de verificação não confere.";
+	buffer.resize(contentSize);
+
+	if (std::memcmp(buffer.data(), checkpointMagic, sizeof(checkpointMagic)) != 0)
+		throw "Checkpoint inválido: identificador incorreto.";
+	std::size_t position = sizeof(checkpointMagic);
+	if (Get<std::uint32_t>(buffer, position) != checkpointVersion)
+		throw "Checkpoint inválido: versão não suportada.";
+
+	IntegratorState state;
+	std::size_t uSize = static_cast<std::size_t>(Get<std::uint64_t>(buffer, position));
+
+	state.t = Get<double>(buffer, position);
+	state.stepSize = Get<double>(buffer, position);
+	state.previousStepSize = Get<double>(buffer, position);
+	state.numberOfSteps = static_cast<std::size_t>(Get<std::uint64_t>(buffer, position));
+
+	IntegrationStatistics& statistics = state.statistics;
+	statistics.rhsEvaluations = static_cast<std::size_t>(Get<std::uint64_t>(buffer, position));
+	statistics.acceptedSteps = static_cast<std::size_t>(Get<std::uint64_t>(buffer, position));
+	statistics.rejectedSteps = static_cast<std::size_t>(Get<std::uint64_t>(buffer, position));
+	statistics.minimumStep = Get<double>(buffer, position);
+	statistics.maximumStep = Get<double>(buffer, position);
+	statistics.stepSum = Get<double>(buffer, position);
+	statistics.rhsCycles = Get<std::uint64_t>(buffer, position);
+	statistics.integratorCycles = Get<std::uint64_t>(buffer, position);
+
+	if (buffer.size() - position != uSize * sizeof(double))
+		throw "Checkpoint inválido: tamanho do sistema inconsistente.";
+	state.u.resize(uSize);
+	for (std::size_t i = 0; i < uSize; i++)
+		state.u[i] = Get<double>(buffer, position);
+
+	return state;
+}
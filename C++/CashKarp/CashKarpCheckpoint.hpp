@@ -0,0 +1,49 @@
+/**
+* @file CashKarpCheckpoint.hpp
+* @brief Checkpoints binários do estado de integração do método de Cash-Karp
+*/
+
+/*
+	* Um checkpoint armazena o IntegratorState completo (t, u, passos,
+	contador de passos e estatísticas) em um arquivo binário compacto.
+	Os valores de ponto flutuante são gravados com sua representação exata,
+	portanto uma integração retomada produz resultados idênticos, bit a bit,
+	aos de uma integração sem interrupções.
+
+	* Formato (ordem de bytes nativa da máquina):
+	-> Identificador "CKCHKPT" seguido de um zero, versão (32 bits) e
+	tamanho do sistema (64 bits)
+	-> t, stepSize, previousStepSize, numberOfSteps
+	-> Campos de IntegrationStatistics
+	-> u[0], ..., u[n-1]
+	-> Soma de verificação FNV-1a (64 bits) de todos os bytes anteriores
+
+	* A gravação é feita em um arquivo temporário, que então substitui o
+	checkpoint anterior. Assim, interromper o processo durante a gravação
+	nunca deixa um checkpoint corrompido no lugar do anterior.
+
+	* Arquivo de cabeçalho, não contém implementações.
+*/
+
+#pragma once
+
+#include "CashKarp.hpp"
+#include <string>
+
+namespace CashKarp {
+	/**
+	* @brief Grava o estado de uma integração em um checkpoint.
+	* @param[in] path Caminho do arquivo (entrada)
+	* @param[in] state Estado a ser gravado (entrada)
+	*/
+	void SaveCheckpoint(const std::string& path, const IntegratorState& state);
+
+	/**
+	* @brief Lê um checkpoint gravado por SaveCheckpoint.
+	* Lança uma exceção caso o arquivo não exista, esteja incompleto ou a
+	* soma de verificação não confira.
+	* @param[in] path Caminho do arquivo (entrada)
+	* @return Estado restaurado, pronto para ser passado a CashKarpRange
+	*/
+	IntegratorState LoadCheckpoint(const std::string& path);
+}
@@ -0,0 +1,46 @@
+/**
+* @file CashKarpCycleCounter.hpp
+* @brief Contador de ciclos das estatísticas de nível 2 (CASHKARP_STATISTICS)
+*/
+
+/*
+	* Compartilhado por CashKarpRange e por Stepper, que medem rhsCycles e
+	integratorCycles da mesma forma.
+
+	* Arquivo de uso interno da biblioteca; toda a implementação está neste
+	arquivo.
+*/
+
+#pragma once
+
+#include "CashKarp.hpp"
+#include <cstdint>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+
+#if CASHKARP_STATISTICS >= 2 && !defined(_M_X64) && !defined(_M_IX86) && \
+	!defined(__x86_64__) && !defined(__i386__)
+#include <chrono>
+#endif
+
+namespace CashKarp {
+	/*
+		Leitura do contador de ciclos do processador (instrução RDTSC).
+		Em arquiteturas que não a possuem, utiliza um relógio monotônico
+		em nanossegundos, que preserva a proporção entre os tempos medidos.
+	*/
+	inline std::uint64_t ReadCycleCounter() {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#elif CASHKARP_STATISTICS >= 2
+		return static_cast<std::uint64_t>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count());
+#else
+		return 0;
+#endif
+	}
+}
@@ -0,0 +1,396 @@
+/**
+* @file CashKarpGeneric.hpp
+* @brief Algoritmo de Cash-Karp genérico no tipo de ponto flutuante
+*/
+
+/*
+	* Versão em templates de CashKarpStep, CashKarpQualityStep e
+	CashKarpRange, com dois parâmetros de tipo:
+	-> Scalar: tipo dos valores de u e dos estágios k1, ..., k6
+	-> Precision: tipo de t, do passo, da estimativa de erro e da tolerância
+	Com Scalar = Precision = double o método e o controle de passo são os de
+	CashKarp.hpp, mas os resultados podem diferir nos últimos bits, pois os
+	coeficientes são multiplicados pelo passo antes dos laços (ver abaixo),
+	em outra ordem de arredondamento. Com Scalar = Precision = float, cada
+	registrador AVX2 comporta 8 valores em vez de 4, e a memória percorrida
+	por passo cai pela metade, o que favorece sistemas grandes (conjuntos de
+	trajetórias) com tolerâncias da ordem de 1e-4. Com Scalar = float e
+	Precision = double (precisão mista), os estágios são calculados em
+	float, mas t e o erro estimado (diferença entre as soluções de quarta e
+	quinta ordem, sujeita a cancelamento) permanecem em double.
+
+	* Os coeficientes são multiplicados pelo passo uma única vez, em
+	Precision, e convertidos para Scalar: os laços sobre as equações do sistema
+	são feitos inteiramente em Scalar e vetorizados pelo compilador.
+
+	* Diferente das rotinas de CashKarp.hpp, os vetores intermediários ficam
+	em um Workspace, alocado uma única vez por CashKarpRange ou fornecido por
+	quem chama, que pode reutilizá-lo entre integrações (Batch::Workspace
+	faz isso em cada thread). A função dynFun é um parâmetro de template
+	(lambda, objeto ou std::function) com protótipo
+	void(Precision t, std::vector<Scalar>& u, std::vector<Scalar>& dudt).
+
+	* Por se tratar de templates, toda a implementação está neste arquivo.
+*/
+
+#pragma once
+
+#include "CashKarp.hpp"
+#include "CashKarpStepControl.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace CashKarp {
+	namespace Generic {
+		/*
+			Impede que um parâmetro participe da dedução de tipos, para que
+			tolerance e initialStep aceitem literais double quando Precision
+			for float.
+		*/
+		template <typename T>
+		struct NonDeduced {
+			using type = T;
+		};
+
+		/**
+		* @brief Vetores intermediários de um passo, alocados uma única vez.
+		* Podem ser reutilizados entre integrações (ver CashKarpRange).
+		*/
+		template <typename Scalar, typename Precision = Scalar>
+		struct Workspace {
+			/**
+			* @brief Construtor
+			* @param[in] systemSize Quantidade de equações do sistema (entrada)
+			*/
+			explicit Workspace(std::size_t systemSize = 0)
+			{
+				Resize(systemSize);
+			}
+
+			/**
+			* @brief Ajusta os vetores a outro tamanho de sistema. Sem
+			* alocações se o tamanho não passar do maior já utilizado.
+			* @param[in] systemSize Quantidade de equações do sistema (entrada)
+			*/
+			void Resize(std::size_t systemSize)
+			{
+				for (std::vector<Scalar>* vector : { &k2, &k3, &k4, &k5, &k6,
+					&uTemporary, &uOutput, &dudt, &u })
+				{
+					vector->resize(systemSize);
+				}
+				uError.resize(systemSize);
+				uScaled.resize(systemSize);
+			}
+
+			std::vector<Scalar> k2, k3, k4, k5, k6;
+			std::vector<Scalar> uTemporary;
+			std::vector<Scalar> uOutput;
+			std::vector<Scalar> dudt;
+			std::vector<Precision> uError;
+			std::vector<Precision> uScaled;
+			// Estado da integração em CashKarpRange
+			std::vector<Scalar> u;
+		};
+
+		/**
+		* @brief Passo de Cash-Karp genérico (ver CashKarp::CashKarpStep).
+		* @param[in] u Valores de u no início do passo (entrada)
+		* @param[in] dudt Derivadas em t (entrada)
+		* @param[in] t Valor de t no início do passo (entrada)
+		* @param[in] stepSize Tamanho do passo (entrada)
+		* @param[out] uOutput Valores de u ao final do passo (saída)
+		* @param[out] uError Erro estimado, em Precision (saída)
+		* @param[in] dynFun Função que calcula as derivadas (entrada)
+		* @param[in, out] workspace Vetores intermediários (entrada e saída)
+		*/
+		template <typename Scalar, typename Precision, typename DynamicFunction>
+		void CashKarpStep(
+			std::vector<Scalar>& u,
+			std::vector<Scalar>& dudt,
+			Precision t,
+			Precision stepSize,
+			std::vector<Scalar>& uOutput,
+			std::vector<Precision>& uError,
+			DynamicFunction& dynFun,
+			Workspace<Scalar, Precision>& workspace)
+		{
+			/*
+				Mesmos coeficientes de CashKarp::CashKarpStep.
+			*/
+			const Precision c2 = 1.0 / 5.0, c3 = 3.0 / 10.0, c4 = 3.0 / 5.0,
+				c5 = 1.0, c6 = 7.0 / 8.0;
+
+			/*
+				Coeficientes 'a', 'b' e 'd' já multiplicados pelo passo.
+			*/
+			const Scalar a21 = static_cast<Scalar>(stepSize * (1.0 / 5.0)),
+				a31 = static_cast<Scalar>(stepSize * (3.0 / 40.0)),
+				a32 = static_cast<Scalar>(stepSize * (9.0 / 40.0)),
+				a41 = static_cast<Scalar>(stepSize * (3.0 / 10.0)),
+				a42 = static_cast<Scalar>(stepSize * (-9.0 / 10.0)),
+				a43 = static_cast<Scalar>(stepSize * (6.0 / 5.0)),
+				a51 = static_cast<Scalar>(stepSize * (-11.0 / 54.0)),
+				a52 = static_cast<Scalar>(stepSize * (5.0 / 2.0)),
+				a53 = static_cast<Scalar>(stepSize * (-70.0 / 27.0)),
+				a54 = static_cast<Scalar>(stepSize * (35.0 / 27.0)),
+				a61 = static_cast<Scalar>(stepSize * (1631.0 / 55296.0)),
+				a62 = static_cast<Scalar>(stepSize * (175.0 / 512.0)),
+				a63 = static_cast<Scalar>(stepSize * (575.0 / 13824.0)),
+				a64 = static_cast<Scalar>(stepSize * (44275.0 / 110592.0)),
+				a65 = static_cast<Scalar>(stepSize * (253.0 / 4096.0));
+
+			const Scalar b1 = static_cast<Scalar>(stepSize * (37.0 / 378.0)),
+				b3 = static_cast<Scalar>(stepSize * (250.0 / 621.0)),
+				b4 = static_cast<Scalar>(stepSize * (125.0 / 594.0)),
+				b6 = static_cast<Scalar>(stepSize * (512.0 / 1771.0));
+
+			const Precision d1 = stepSize * -0.0042937748015873,
+				d3 = stepSize * 0.0186685860938579,
+				d4 = stepSize * -0.0341550268308081,
+				d5 = stepSize * -0.0193219866071429,
+				d6 = stepSize * 0.0391022021456804;
+
+			std::size_t uSize = u.size();
+			std::size_t i;
+			std::vector<Scalar>& k2 = workspace.k2;
+			std::vector<Scalar>& k3 = workspace.k3;
+			std::vector<Scalar>& k4 = workspace.k4;
+			std::vector<Scalar>& k5 = workspace.k5;
+			std::vector<Scalar>& k6 = workspace.k6;
+			std::vector<Scalar>& uTemporary = workspace.uTemporary;
+
+			for (i = 0; i < uSize; i++)
+				uTemporary[i] = u[i] + a21 * dudt[i];
+			dynFun(t + c2 * stepSize, uTemporary, k2);
+
+			for (i = 0; i < uSize; i++)
+				uTemporary[i] = u[i] + a31 * dudt[i] + a32 * k2[i];
+			dynFun(t + c3 * stepSize, uTemporary, k3);
+
+			for (i = 0; i < uSize; i++)
+				uTemporary[i] = u[i] + a41 * dudt[i] + a42 * k2[i] + a43 * k3[i];
+			dynFun(t + c4 * stepSize, uTemporary, k4);
+
+			for (i = 0; i < uSize; i++) {
+				uTemporary[i] =
+					u[i] + a51 * dudt[i] + a52 * k2[i] + a53 * k3[i] + a54 * k4[i];
+			}
+			dynFun(t + c5 * stepSize, uTemporary, k5);
+
+			for (i = 0; i < uSize; i++) {
+				uTemporary[i] =
+					u[i] + a61 * dudt[i] + a62 * k2[i] + a63 * k3[i] +
+					a64 * k4[i] + a65 * k5[i];
+			}
+			dynFun(t + c6 * stepSize, uTemporary, k6);
+
+			for (i = 0; i < uSize; i++)
+				uOutput[i] = u[i] + b1 * dudt[i] + b3 * k3[i] + b4 * k4[i] + b6 * k6[i];
+
+			/*
+				Estimativa de erro em Precision: em precisão mista, a soma
+				(com cancelamento) é feita em double.
+			*/
+			for (i = 0; i < uSize; i++) {
+				uError[i] =
+					d1 * static_cast<Precision>(dudt[i]) +
+					d3 * static_cast<Precision>(k3[i]) +
+					d4 * static_cast<Precision>(k4[i]) +
+					d5 * static_cast<Precision>(k5[i]) +
+					d6 * static_cast<Precision>(k6[i]);
+			}
+		}
+
+		/**
+		* @brief Passo adaptativo genérico (ver CashKarp::CashKarpQualityStep).
+		* @param[in, out] u Valores de u (entrada e saída)
+		* @param[in] dudt Derivadas em t (entrada)
+		* @param[in] uScaled Escala do erro de cada equação (entrada)
+		* @param[in, out] t Valor de t (entrada e saída)
+		* @param[in] stepSizeTry Primeira tentativa de passo (entrada)
+		* @param[in] tolerance Tolerância (entrada)
+		* @param[out] previousStepSize Passo realizado (saída)
+		* @param[out] nextStepSize Passo sugerido para a próxima chamada (saída)
+		* @param[in] dynFun Função que calcula as derivadas (entrada)
+		* @param[in, out] workspace Vetores intermediários (entrada e saída)
+		* @param[in, out] statistics Estatísticas, ou nullptr (entrada e saída)
+		*/
+		template <typename Scalar, typename Precision, typename DynamicFunction>
+		void CashKarpQualityStep(
+			std::vector<Scalar>& u,
+			std::vector<Scalar>& dudt,
+			std::vector<Precision>& uScaled,
+			Precision& t,
+			Precision stepSizeTry,
+			Precision tolerance,
+			Precision& previousStepSize,
+			Precision& nextStepSize,
+			DynamicFunction& dynFun,
+			Workspace<Scalar, Precision>& workspace,
+			IntegrationStatistics* statistics = nullptr)
+		{
+			std::size_t uSize = u.size();
+			std::vector<Scalar>& uOutput = workspace.uOutput;
+			std::vector<Precision>& uError = workspace.uError;
+			Precision maximumError, stepSize;
+			const StepControl<Precision> stepControl(4);
+
+			stepSize = stepSizeTry;
+			while (true)
+			{
+				CashKarpStep(u, dudt, t, stepSize, uOutput, uError, dynFun, workspace);
+
+#if CASHKARP_STATISTICS
+				if (statistics != nullptr)
+					statistics->rhsEvaluations += 5;
+#endif
+
+				maximumError = stepControl.MaximumError(
+					uError.data(), uScaled.data(), uOutput.data(), uSize);
+				maximumError /= tolerance;
+
+				if (maximumError <= 1.0)
+					break;
+
+#if CASHKARP_STATISTICS
+				if (statistics != nullptr)
+					statistics->rejectedSteps++;
+#endif
+
+				stepSize = stepControl.RejectedStepSize(stepSize, maximumError);
+
+				if (t + stepSize == t)
+					throw "Mathematical error: step size is equal to zero.";
+			}
+
+			nextStepSize = stepControl.NextStepSize(stepSize, maximumError);
+
+			previousStepSize = stepSize;
+			t += previousStepSize;
+
+#if CASHKARP_STATISTICS
+			if (statistics != nullptr)
+				statistics->AcceptStep(static_cast<double>(stepSize));
+#endif
+
+			/*
+				Cópia, e não troca: u pode ser um vetor de quem chama, cuja
+				memória não deve mudar.
+			*/
+			std::copy(uOutput.begin(), uOutput.end(), u.begin());
+		}
+
+		/**
+		* @brief Integração genérica em tSpan (ver CashKarp::CashKarpRange).
+		* Scalar é deduzido de uInitial e Precision de tSpan; por exemplo,
+		* std::vector<float> com std::pair<double, double> resulta em precisão
+		* mista.
+		* @param[in] uInitial Valores iniciais (entrada)
+		* @param[in] tSpan Intervalo de integração, com início e fim (entrada)
+		* @param[in] tolerance Tolerância (entrada)
+		* @param[in] initialStep Passo inicial (entrada)
+		* @param[in] minimumStep Passo mínimo (entrada)
+		* @param[in] maximumNumberOfSteps Quantidade máxima de passos (entrada)
+		* @param[in] dynFun Função que calcula as derivadas (entrada)
+		* @param[in] stepObserver Função chamada com o ponto inicial e cada
+		* passo aceito, com protótipo void(Precision t, std::vector<Scalar>& u)
+		* (entrada)
+		* @param[in, out] workspace Vetores intermediários, ajustados ao tamanho
+		* de uInitial; reutilizá-los entre integrações evita alocações
+		* (entrada e saída)
+		* @return Estatísticas da integração (ver IntegrationStatistics)
+		*/
+		template <typename Scalar, typename Precision, typename DynamicFunction, typename Observer>
+		IntegrationStatistics CashKarpRange(
+			std::vector<Scalar>& uInitial,
+			std::pair<Precision, Precision>& tSpan,
+			typename NonDeduced<Precision>::type tolerance,
+			typename NonDeduced<Precision>::type initialStep,
+			typename NonDeduced<Precision>::type minimumStep,
+			std::size_t maximumNumberOfSteps,
+			DynamicFunction& dynFun,
+			Observer& stepObserver,
+			Workspace<Scalar, Precision>& workspace)
+		{
+			std::size_t i, uSize = uInitial.size();
+			workspace.Resize(uSize);
+			std::vector<Scalar>& dudt = workspace.dudt;
+			std::vector<Precision>& uScaled = workspace.uScaled;
+			std::vector<Scalar>& u = workspace.u;
+			std::copy(uInitial.begin(), uInitial.end(), u.begin());
+			IntegrationStatistics statistics;
+#if CASHKARP_STATISTICS
+			IntegrationStatistics* statisticsPointer = &statistics;
+#else
+			IntegrationStatistics* statisticsPointer = nullptr;
+#endif
+
+			Precision t = tSpan.first;
+			Precision stepSize =
+				(tSpan.second - tSpan.first >= 0.0)
+				? std::abs(initialStep)
+				: -std::abs(initialStep);
+			Precision previousStepSize = 0.0, nextStepSize;
+
+			stepObserver(t, u);
+
+			for (std::size_t step = 0; step <= maximumNumberOfSteps; step++)
+			{
+				dynFun(t, u, dudt);
+#if CASHKARP_STATISTICS
+				statistics.rhsEvaluations++;
+#endif
+
+				for (i = 0; i < uSize; i++) {
+					uScaled[i] =
+						std::abs(static_cast<Precision>(u[i])) +
+						std::abs(static_cast<Precision>(dudt[i]) * stepSize) +
+						static_cast<Precision>(1.0e-30);
+				}
+
+				Precision tNext = t + stepSize;
+				if ((tNext - tSpan.second) * (tNext - tSpan.first) > 0.0)
+					stepSize = tSpan.second - t;
+
+				CashKarpQualityStep(
+					u, dudt, uScaled, t, stepSize, tolerance,
+					previousStepSize, nextStepSize, dynFun,
+					workspace, statisticsPointer);
+
+				stepObserver(t, u);
+
+				if ((t - tSpan.second) * (tSpan.second - tSpan.first) >= 0.0)
+					break;
+
+				stepSize = nextStepSize;
+			}
+
+			return statistics;
+		}
+
+		/**
+		* @brief Integração genérica em tSpan, com vetores intermediários
+		* alocados para esta integração (ver a versão com Workspace).
+		*/
+		template <typename Scalar, typename Precision, typename DynamicFunction, typename Observer>
+		IntegrationStatistics CashKarpRange(
+			std::vector<Scalar>& uInitial,
+			std::pair<Precision, Precision>& tSpan,
+			typename NonDeduced<Precision>::type tolerance,
+			typename NonDeduced<Precision>::type initialStep,
+			typename NonDeduced<Precision>::type minimumStep,
+			std::size_t maximumNumberOfSteps,
+			DynamicFunction& dynFun,
+			Observer& stepObserver)
+		{
+			Workspace<Scalar, Precision> workspace(uInitial.size());
+			return CashKarpRange(
+				uInitial, tSpan, tolerance, initialStep, minimumStep,
+				maximumNumberOfSteps, dynFun, stepObserver, workspace);
+		}
+	}
+}
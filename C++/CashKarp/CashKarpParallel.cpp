@@ -0,0 +1,273 @@
+/**
+* @file CashKarpParallel.cpp
+* @brief Algoritmo de Cash-Karp para sistemas muito grandes, em várias threads
+*/
+
+#include "CashKarpParallel.hpp"
+#include "CashKarpStepControl.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	/*
+		Mesmos coeficientes de CashKarp::CashKarpStep.
+	*/
+	const double c2 = 1.0 / 5.0, c3 = 3.0 / 10.0, c4 = 3.0 / 5.0,
+		c5 = 1.0, c6 = 7.0 / 8.0;
+
+	const double a21 = 1.0 / 5.0,
+		a31 = 3.0 / 40.0, a32 = 9.0 / 40.0,
+		a41 = 3.0 / 10.0, a42 = -9.0 / 10.0, a43 = 6.0 / 5.0,
+		a51 = -11.0 / 54.0, a52 = 5.0 / 2.0, a53 = -70.0 / 27.0,
+		a54 = 35.0 / 27.0,
+		a61 = 1631.0 / 55296.0, a62 = 175.0 / 512.0,
+		a63 = 575.0 / 13824.0, a64 = 44275.0 / 110592.0,
+		a65 = 253.0 / 4096.0;
+
+	const double b1 = 37.0 / 378.0,
+		b3 = 250.0 / 621.0,
+		b4 = 125.0 / 594.0,
+		b6 = 512.0 / 1771.0;
+
+	const double d1 = -0.0042937748015873,
+		d3 = 0.0186685860938579,
+		d4 = -0.0341550268308081,
+		d5 = -0.0193219866071429,
+		d6 = 0.0391022021456804;
+
+	/*
+		Maior erro de cada parte, em linhas de cache separadas para que as
+		threads não disputem a mesma linha.
+	*/
+	struct alignas(64) PartialError {
+		double value;
+	};
+
+	/*
+		Vetores de um passo.
+	*/
+	struct Workspace {
+		ThreadPool::Vector u, dudt, k2, k3, k4, k5, k6;
+		ThreadPool::Vector stageA, stageB, uOutput;
+		std::vector<PartialError> partialErrors;
+
+		Workspace(std::size_t uSize, ThreadPool::ThreadPool& pool) :
+			partialErrors(pool.Size())
+		{
+			ThreadPool::Vector* vectors[] = {
+				&u, &dudt, &k2, &k3, &k4, &k5, &k6, &stageA, &stageB, &uOutput };
+			for (ThreadPool::Vector* vector : vectors)
+				vector->resize(uSize);
+
+			/*
+				Primeiro toque: cada thread zera a parte que utilizará.
+			*/
+			auto firstTouch = [&vectors](std::size_t, std::size_t begin, std::size_t end) {
+				for (ThreadPool::Vector* vector : vectors)
+					std::fill(vector->begin() + begin, vector->begin() + end, 0.0);
+			};
+			pool.Run(uSize, firstTouch);
+		}
+	};
+}
+
+CashKarp::IntegrationStatistics CashKarp::Parallel::CashKarpRange(
+	std::vector<double>& uInitial,
+	std::pair<double, double>& tSpan,
+	double tolerance,
+	double initialStep,
+	double minimumStep,
+	std::size_t maximumNumberOfSteps,
+	PartitionedFunction& dynFun,
+	std::function<
+	void(double,
+		ThreadPool::Vector&)
+	>& stepObserver,
+	ThreadPool::ThreadPool& pool)
+{
+	std::size_t uSize = uInitial.size();
+	Workspace workspace(uSize, pool);
+	ThreadPool::Vector& u = workspace.u;
+	ThreadPool::Vector& dudt = workspace.dudt;
+	ThreadPool::Vector& k2 = workspace.k2;
+	ThreadPool::Vector& k3 = workspace.k3;
+	ThreadPool::Vector& k4 = workspace.k4;
+	ThreadPool::Vector& k5 = workspace.k5;
+	ThreadPool::Vector& k6 = workspace.k6;
+	ThreadPool::Vector& stageA = workspace.stageA;
+	ThreadPool::Vector& stageB = workspace.stageB;
+	ThreadPool::Vector& uOutput = workspace.uOutput;
+	std::vector<PartialError>& partialErrors = workspace.partialErrors;
+	IntegrationStatistics statistics;
+
+	auto copyInitial = [&](std::size_t, std::size_t begin, std::size_t end) {
+		std::copy(uInitial.begin() + begin, uInitial.begin() + end, u.begin() + begin);
+	};
+	pool.Run(uSize, copyInitial);
+
+	double t = tSpan.first;
+	double stepSize =
+		(tSpan.second - tSpan.first >= 0.0)
+		? std::abs(initialStep)
+		: -std::abs(initialStep);
+	double scaleStep = stepSize;
+	double tStage = t;
+	static const StepControl<double> stepControl(4);
+
+	/*
+		Tarefas de cada estágio. Cada uma calcula as derivadas de sua parte e
+		combina o próximo estágio nessa mesma parte. O passo é copiado para
+		uma variável local (h): como é capturado por referência, o compilador
+		não poderia assumir que as escritas nos vetores não o alteram, e não
+		vetorizaria os laços.
+	*/
+	auto stage1 = [&](std::size_t, std::size_t begin, std::size_t end) {
+		const double h = stepSize;
+		dynFun(t, u, dudt, begin, end);
+		for (std::size_t i = begin; i < end; i++)
+			stageA[i] = u[i] + a21 * h * dudt[i];
+	};
+	auto stage2Only = [&](std::size_t, std::size_t begin, std::size_t end) {
+		const double h = stepSize;
+		for (std::size_t i = begin; i < end; i++)
+			stageA[i] = u[i] + a21 * h * dudt[i];
+	};
+	auto stage2 = [&](std::size_t, std::size_t begin, std::size_t end) {
+		const double h = stepSize;
+		dynFun(tStage, stageA, k2, begin, end);
+		for (std::size_t i = begin; i < end; i++)
+			stageB[i] = u[i] + h * (a31 * dudt[i] + a32 * k2[i]);
+	};
+	auto stage3 = [&](std::size_t, std::size_t begin, std::size_t end) {
+		const double h = stepSize;
+		dynFun(tStage, stageB, k3, begin, end);
+		for (std::size_t i = begin; i < end; i++)
+			stageA[i] = u[i] + h * (a41 * dudt[i] + a42 * k2[i] + a43 * k3[i]);
+	};
+	auto stage4 = [&](std::size_t, std::size_t begin, std::size_t end) {
+		const double h = stepSize;
+		dynFun(tStage, stageA, k4, begin, end);
+		for (std::size_t i = begin; i < end; i++) {
+			stageB[i] =
+				u[i] + h * (a51 * dudt[i] + a52 * k2[i] +
+					a53 * k3[i] + a54 * k4[i]);
+		}
+	};
+	auto stage5 = [&](std::size_t, std::size_t begin, std::size_t end) {
+		const double h = stepSize;
+		dynFun(tStage, stageB, k5, begin, end);
+		for (std::size_t i = begin; i < end; i++) {
+			stageA[i] =
+				u[i] + h * (a61 * dudt[i] + a62 * k2[i] +
+					a63 * k3[i] + a64 * k4[i] + a65 * k5[i]);
+		}
+	};
+
+	/*
+		Último estágio, valor de quarta ordem e maior erro em uma única
+		passagem. uScaled é recalculado aqui em vez de armazenado.
+	*/
+	auto stage6 = [&](std::size_t part, std::size_t begin, std::size_t end) {
+		const double h = stepSize, hScale = scaleStep;
+		dynFun(tStage, stageA, k6, begin, end);
+		double maximumError = 0.0;
+		for (std::size_t i = begin; i < end; i++) {
+			uOutput[i] =
+				u[i] + h * (b1 * dudt[i] + b3 * k3[i] +
+					b4 * k4[i] + b6 * k6[i]);
+			double uError =
+				h * (d1 * dudt[i] + d3 * k3[i] + d4 * k4[i] +
+					d5 * k5[i] + d6 * k6[i]);
+			double uScaled = std::abs(u[i]) + std::abs(dudt[i] * hScale) + 1.0e-30;
+			double newError = std::abs(uError / uScaled);
+			if (newError > 1.0e16)
+				newError = std::abs(uError / uOutput[i]);
+			maximumError = std::max<double>(maximumError, newError);
+		}
+		partialErrors[part].value = maximumError;
+	};
+
+	stepObserver(t, u);
+
+	for (std::size_t step = 0; step <= maximumNumberOfSteps; step++)
+	{
+		/*
+			A escala do erro utiliza o passo antes do ajuste ao final de
+			tSpan, como em CashKarpRange.
+		*/
+		scaleStep = stepSize;
+		double tNext = t + stepSize;
+		if ((tNext - tSpan.second) * (tNext - tSpan.first) > 0.0)
+			stepSize = tSpan.second - t;
+
+		pool.Run(uSize, stage1);
+#if CASHKARP_STATISTICS
+		statistics.rhsEvaluations++;
+#endif
+
+		double maximumError;
+		bool firstAttempt = true;
+		while (true)
+		{
+			if (!firstAttempt)
+				pool.Run(uSize, stage2Only);
+			firstAttempt = false;
+
+			for (PartialError& partialError : partialErrors)
+				partialError.value = 0.0;
+
+			tStage = t + c2 * stepSize;
+			pool.Run(uSize, stage2);
+			tStage = t + c3 * stepSize;
+			pool.Run(uSize, stage3);
+			tStage = t + c4 * stepSize;
+			pool.Run(uSize, stage4);
+			tStage = t + c5 * stepSize;
+			pool.Run(uSize, stage5);
+			tStage = t + c6 * stepSize;
+			pool.Run(uSize, stage6);
+
+#if CASHKARP_STATISTICS
+			statistics.rhsEvaluations += 5;
+#endif
+
+			maximumError = 0.0;
+			for (PartialError& partialError : partialErrors)
+				maximumError = std::max<double>(maximumError, partialError.value);
+			maximumError /= tolerance;
+
+			if (maximumError <= 1.0)
+				break;
+
+#if CASHKARP_STATISTICS
+			statistics.rejectedSteps++;
+#endif
+
+			stepSize = stepControl.RejectedStepSize(stepSize, maximumError);
+
+			if (t + stepSize == t)
+				throw "Mathematical error: step size is equal to zero.";
+		}
+
+		double nextStepSize = stepControl.NextStepSize(stepSize, maximumError);
+		t += stepSize;
+
+#if CASHKARP_STATISTICS
+		statistics.AcceptStep(stepSize);
+#endif
+
+		/*
+			Troca em vez de cópia; as partes de cada vetor continuam com as
+			mesmas threads.
+		*/
+		u.swap(uOutput);
+		stepObserver(t, u);
+
+		if ((t - tSpan.second) * (tSpan.second - tSpan.first) >= 0.0)
+			break;
+
+		stepSize = nextStepSize;
+	}
+
+	return statistics;
+}
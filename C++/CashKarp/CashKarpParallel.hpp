@@ -0,0 +1,90 @@
+/**
+* @file CashKarpParallel.hpp
+* @brief Algoritmo de Cash-Karp para sistemas muito grandes, em várias threads
+*/
+
+/*
+	* Em sistemas com milhões de equações (método das linhas), os laços de
+	CashKarpStep e a busca do maior erro em CashKarpQualityStep são limitados
+	pela largura de banda da memória: cada laço percorre vários vetores que
+	não cabem na cache. Esta versão reduz a quantidade de passagens pela
+	memória e as divide entre as threads de um ThreadPool:
+	-> dynFun é chamada por parte: cada thread calcula dudt[begin, end) e, em
+	seguida, combina os estágios dessa mesma parte, enquanto ainda estão na
+	cache (u[i] + passo * (a1 * k1[i] + ...)).
+	-> O último estágio, o valor de quarta ordem, a estimativa de erro, a
+	escala do erro (uScaled) e a redução do maior erro são feitos em uma única
+	passagem, sem armazenar uError e uScaled.
+	-> Os estágios intermediários alternam entre dois vetores, pois uma
+	thread não pode sobrescrever valores que outras ainda leem em dynFun.
+	-> Todos os vetores são alocados sem inicialização e zerados pela thread
+	que os utiliza (primeiro toque), ver ThreadPool.hpp.
+
+	* A aritmética é a mesma da versão escalar de CashKarpStep, e o controle
+	de passo o mesmo de CashKarpQualityStep e CashKarpRange: para sistemas
+	com mais de 4 equações, o resultado é idêntico, bit a bit, ao de
+	CashKarpRange, com qualquer quantidade de threads. Com 4 equações ou
+	menos, CashKarpRange utiliza a versão AVX2 de CashKarpStep (quando
+	disponível), e os resultados podem diferir nos últimos bits.
+
+	* Compensa apenas para sistemas grandes (da ordem de 10^5 equações ou
+	mais): em sistemas pequenos a sincronização entre estágios domina.
+
+	* Arquivo de cabeçalho, não contém implementações.
+*/
+
+#pragma once
+
+#include "CashKarp.hpp"
+#include "ThreadPool.hpp"
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace CashKarp {
+	namespace Parallel {
+		/**
+		* @brief Função que calcula as derivadas de uma parte do sistema.
+		* Deve escrever apenas dudt[begin, end), podendo ler qualquer posição
+		* de u. É chamada simultaneamente por todas as threads do ThreadPool.
+		*/
+		using PartitionedFunction = std::function<
+			void(
+				double,
+				ThreadPool::Vector&,
+				ThreadPool::Vector&,
+				std::size_t,
+				std::size_t)>;
+
+		/**
+		* @brief Rotina que aplica o método de Cash-Karp a um sistema grande,
+		* dividindo as equações entre as threads de pool.
+		* @param[in] uInitial Valores iniciais do sistema de EDO`s (entrada)
+		* @param[in] tSpan Intervalo de integração, com início e fim (entrada)
+		* @param[in] tolerance Tolerância aceita pelo algoritmo (entrada)
+		* @param[in] initialStep Passo inicial (entrada)
+		* @param[in] minimumStep Passo mínimo, atualmente não implementado (entrada)
+		* @param[in] maximumNumberOfSteps Quantidade máxima de iterações (entrada)
+		* @param[in] dynFun Função que calcula as derivadas de uma parte do
+		* sistema (entrada)
+		* @param[in] stepObserver Função chamada com t e u no ponto inicial e
+		* após cada passo aceito, na thread que chamou a rotina (entrada)
+		* @param[in] pool Threads utilizadas (entrada)
+		* @return Estatísticas da integração (zeradas se CASHKARP_STATISTICS for 0)
+		*/
+		IntegrationStatistics CashKarpRange(
+			std::vector<double>& uInitial,
+			std::pair<double, double>& tSpan,
+			double tolerance,
+			double initialStep,
+			double minimumStep,
+			std::size_t maximumNumberOfSteps,
+			PartitionedFunction& dynFun,
+			std::function<
+			void(double,
+				ThreadPool::Vector&)
+			>& stepObserver,
+			ThreadPool::ThreadPool& pool);
+	}
+}
@@ -0,0 +1,105 @@
+/**
+* @file CashKarpStepControl.hpp
+* @brief Controle de passo de CashKarpQualityStep, para qualquer par embutido
+*/
+
+/*
+	* Numerical Recipes, seção 16.2 (rotina rkqs). Com err o maior erro
+	estimado dividido pela tolerância e q a ordem da solução embutida:
+		passo rejeitado: h <- max(0.9 h err^(-1/q), 0.1 h)
+		passo aceito: próximo h = 0.9 h err^(-1/(q + 1)), limitado a 5 h
+	Em Cash-Karp q = 4, o que resulta nos expoentes -0.25 e -0.2 do livro.
+	Os mesmos cálculos são usados por CashKarpQualityStep, por
+	CashKarpGeneric, por CashKarpParallel e pelos pares de Runge-Kutta-Nyström
+	(Nystrom.hpp), cuja solução embutida também tem ordem 4.
+
+	* Assim como CashKarpGeneric, toda a implementação está neste arquivo.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace CashKarp {
+	/**
+	* @brief Fatores de passo para um par embutido cuja solução de menor
+	* ordem tem ordem embeddedOrder.
+	*/
+	template <typename Precision = double>
+	class StepControl {
+	public:
+		/**
+		* @brief Construtor
+		* @param[in] embeddedOrder Ordem da solução embutida (entrada)
+		*/
+		explicit StepControl(int embeddedOrder = 4) :
+			shrinkExponent(static_cast<Precision>(-1.0 / embeddedOrder)),
+			growExponent(static_cast<Precision>(-1.0 / (embeddedOrder + 1))),
+			errorComparingValue(static_cast<Precision>(std::pow(5.0 / 0.9, -(embeddedOrder + 1.0))))
+		{
+		}
+
+		/**
+		* @brief Maior erro relativo a uScaled, ainda não dividido pela
+		* tolerância. Se uScaled for muito pequeno em relação ao erro, este é
+		* medido em relação a uOutput.
+		* @param[in] uError Erros estimados (entrada)
+		* @param[in] uScaled Escalas de cada equação (entrada)
+		* @param[in] uOutput Solução do passo (entrada)
+		* @param[in] size Tamanho dos vetores (entrada)
+		*/
+		template <typename Scalar>
+		Precision MaximumError(
+			const Precision* uError,
+			const Precision* uScaled,
+			const Scalar* uOutput,
+			std::size_t size) const
+		{
+			Precision maximumError = 0.0;
+			for (std::size_t i = 0; i < size; i++) {
+				Precision newError = std::abs(uError[i] / uScaled[i]);
+				if (newError > static_cast<Precision>(1.0e16))
+					newError = std::abs(uError[i] / static_cast<Precision>(uOutput[i]));
+				maximumError = std::max(maximumError, newError);
+			}
+			return maximumError;
+		}
+
+		/**
+		* @brief Passo da nova tentativa após uma rejeição, no máximo dez
+		* vezes menor.
+		* @param[in] stepSize Passo rejeitado (entrada)
+		* @param[in] maximumError Erro dividido pela tolerância, maior que 1
+		* (entrada)
+		*/
+		Precision RejectedStepSize(Precision stepSize, Precision maximumError) const {
+			Precision temporaryStepSize =
+				static_cast<Precision>(0.9) * stepSize * std::pow(maximumError, shrinkExponent);
+			return
+				(stepSize >= 0.0)
+				? std::max(temporaryStepSize, static_cast<Precision>(0.1) * stepSize)
+				: std::min(temporaryStepSize, static_cast<Precision>(0.1) * stepSize);
+		}
+
+		/**
+		* @brief Passo sugerido após um passo aceito, no máximo cinco vezes
+		* maior.
+		* @param[in] stepSize Passo aceito (entrada)
+		* @param[in] maximumError Erro dividido pela tolerância (entrada)
+		*/
+		Precision NextStepSize(Precision stepSize, Precision maximumError) const {
+			return
+				(maximumError > errorComparingValue)
+				? static_cast<Precision>(0.9) * stepSize * std::pow(maximumError, growExponent)
+				: static_cast<Precision>(5.0) * stepSize;
+		}
+
+	private:
+		Precision shrinkExponent;
+		Precision growExponent;
+		// Erro abaixo do qual o passo cresce 5 vezes: (5 / 0.9)^-(q + 1)
+		Precision errorComparingValue;
+	};
+}
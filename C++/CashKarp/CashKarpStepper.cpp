@@ -0,0 +1,177 @@
+/**
+* @file CashKarpStepper.cpp
+* @brief Integração de Cash-Karp sob demanda, um passo aceito por vez
+*/
+
+#include "CashKarpStepper.hpp"
+#include "CashKarpCycleCounter.hpp"
+#include <cmath>
+
+CashKarp::Stepper::Stepper(
+	std::vector<double>& uInitial,
+	std::pair<double, double>& tSpan,
+	double tolerance,
+	double initialStep,
+	std::size_t maximumNumberOfSteps,
+	std::function<
+	void(double,
+		std::vector<double>&,
+		std::vector<double>&)
+	>& dynFun) :
+	Stepper(CashKarpInitialState(uInitial, tSpan, initialStep),
+		tSpan, tolerance, maximumNumberOfSteps, dynFun)
+{
+}
+
+CashKarp::Stepper::Stepper(
+	const IntegratorState& state,
+	std::pair<double, double>& tSpan,
+	double tolerance,
+	std::size_t maximumNumberOfSteps,
+	std::function<
+	void(double,
+		std::vector<double>&,
+		std::vector<double>&)
+	>& dynFun) :
+	state(state),
+	tSpan(tSpan),
+	tolerance(tolerance),
+	maximumNumberOfSteps(maximumNumberOfSteps),
+	dynFun(&dynFun),
+	phase(Phase::Initial),
+	dudt(state.u.size()),
+	uScaled(state.u.size())
+{
+	/*
+		Mesmas regras de CashKarpRange ao retomar: sem ponto inicial, e nada
+		a fazer se a integração já tiver terminado ou atingido o limite de
+		passos.
+	*/
+	if (state.numberOfSteps > maximumNumberOfSteps)
+		phase = Phase::Finished;
+	else if (state.numberOfSteps > 0) {
+		phase =
+			((state.t - tSpan.second) * (tSpan.second - tSpan.first) >= 0.0)
+			? Phase::Finished
+			: Phase::Stepping;
+	}
+}
+
+bool CashKarp::Stepper::Next()
+{
+	if (phase == Phase::Initial) {
+		phase = Phase::Stepping;
+		return true;
+	}
+	if (phase == Phase::Finished)
+		return false;
+
+	/*
+		Uma iteração do laço de CashKarpRange.
+	*/
+	std::size_t i, uSize = state.u.size();
+	double nextStepSize;
+
+#if CASHKARP_STATISTICS >= 2
+	/*
+		Mesma medição de CashKarpRange, restrita a este passo: ciclos em
+		dynFun e, no restante, no próprio integrador.
+	*/
+	IntegrationStatistics& statistics = state.statistics;
+	std::uint64_t startCycles = ReadCycleCounter();
+	std::uint64_t startRhsCycles = statistics.rhsCycles;
+	std::function<
+	void(double,
+		std::vector<double>&,
+		std::vector<double>&)
+	> instrumentedFun = [this, &statistics](
+		double tStage,
+		std::vector<double>& uStage,
+		std::vector<double>& dudtStage)
+	{
+		std::uint64_t rhsStart = ReadCycleCounter();
+		(*dynFun)(tStage, uStage, dudtStage);
+		statistics.rhsCycles += ReadCycleCounter() - rhsStart;
+	};
+#else
+	auto& instrumentedFun = *dynFun;
+#endif
+
+	instrumentedFun(state.t, state.u, dudt);
+#if CASHKARP_STATISTICS
+	state.statistics.rhsEvaluations++;
+	IntegrationStatistics* statisticsPointer = &state.statistics;
+#else
+	IntegrationStatistics* statisticsPointer = nullptr;
+#endif
+
+	for (i = 0; i < uSize; i++)
+	{
+		uScaled[i] =
+			std::abs(state.u[i]) +
+			std::abs(dudt[i] * state.stepSize) +
+			1.0e-30;
+	}
+
+	double tNext = state.t + state.stepSize;
+	if ((tNext - tSpan.second) * (tNext - tSpan.first) > 0.0)
+		state.stepSize = tSpan.second - state.t;
+
+	CashKarpQualityStep(
+		state.u, dudt, uScaled, state.t, state.stepSize,
+		tolerance, state.previousStepSize,
+		nextStepSize, instrumentedFun,
+		statisticsPointer);
+
+	if ((state.t - tSpan.second) * (tSpan.second - tSpan.first) >= 0.0)
+		phase = Phase::Finished;
+	else {
+		state.stepSize = nextStepSize;
+		state.numberOfSteps++;
+		// Limite atingido: Finished() já indica o fim, sem outra chamada
+		if (state.numberOfSteps > maximumNumberOfSteps)
+			phase = Phase::Finished;
+	}
+
+#if CASHKARP_STATISTICS >= 2
+	statistics.integratorCycles +=
+		ReadCycleCounter() - startCycles - (statistics.rhsCycles - startRhsCycles);
+#endif
+	return true;
+}
+
+std::size_t CashKarp::RoundRobin(
+	std::vector<Stepper>& steppers,
+	std::function<
+	void(std::size_t,
+		double,
+		const std::vector<double>&)
+	>& consumer)
+{
+	std::size_t delivered = 0;
+	std::vector<std::size_t> active;
+	active.reserve(steppers.size());
+	for (std::size_t i = 0; i < steppers.size(); i++) {
+		if (!steppers[i].Finished())
+			active.push_back(i);
+	}
+
+	/*
+		As integrações terminadas saem da lista ativa na própria rodada,
+		mantendo a ordem das demais.
+	*/
+	while (!active.empty()) {
+		std::size_t remaining = 0;
+		for (std::size_t index : active) {
+			Stepper& stepper = steppers[index];
+			if (stepper.Next()) {
+				consumer(index, stepper.T(), stepper.U());
+				delivered++;
+			}
+			if (!stepper.Finished())
+				active[remaining++] = index;
+		}
+		active.resize(remaining);
+	}
+	return delivered;
+}
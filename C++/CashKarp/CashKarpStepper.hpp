@@ -0,0 +1,152 @@
+/**
+* @file CashKarpStepper.hpp
+* @brief Integração de Cash-Karp sob demanda, um passo aceito por vez
+*/
+
+/*
+	* CashKarpRange executa a integração inteira antes de retornar, e cada
+	passo é entregue a stepObserver dentro do laço. Stepper faz o mesmo
+	laço na forma de uma máquina de estados: cada chamada a Next() dá um
+	único passo aceito e retorna, e quem consome os passos decide quando
+	pedir o próximo. Entre duas chamadas, o estado é apenas um
+	IntegratorState e dois vetores de trabalho; não há pilha nem thread
+	próprias, logo alternar entre integrações custa uma chamada de função.
+
+	* Os passos são idênticos, bit a bit, aos de CashKarpRange com os mesmos
+	parâmetros. As estatísticas seguem CASHKARP_STATISTICS; no nível 2, os
+	ciclos são medidos dentro de cada Next(), e o tempo gasto por quem
+	consome os passos não entra em integratorCycles.
+
+	* RoundRobin intercala várias integrações em uma única thread, entregando
+	cada passo assim que ele é calculado, sem armazenar trajetórias.
+
+	* Arquivo de cabeçalho, não contém implementações.
+*/
+
+#pragma once
+
+#include "CashKarp.hpp"
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace CashKarp {
+	/**
+	* @brief Integração de Cash-Karp que avança um passo aceito por chamada.
+	* dynFun é guardada por referência e deve existir enquanto o Stepper for
+	* utilizado; várias integrações podem compartilhar a mesma função.
+	*/
+	class Stepper {
+	public:
+		/**
+		* @brief Construtor, com os parâmetros de CashKarpRange.
+		* @param[in] uInitial Valores iniciais do sistema de EDO`s (entrada)
+		* @param[in] tSpan Intervalo de integração, com início e fim (entrada)
+		* @param[in] tolerance Tolerância aceita pelo algoritmo (entrada)
+		* @param[in] initialStep Passo inicial (entrada)
+		* @param[in] maximumNumberOfSteps Quantidade máxima de iterações (entrada)
+		* @param[in] dynFun Função que computa os valores do sistema de EDO`s (entrada)
+		*/
+		Stepper(
+			std::vector<double>& uInitial,
+			std::pair<double, double>& tSpan,
+			double tolerance,
+			double initialStep,
+			std::size_t maximumNumberOfSteps,
+			std::function<
+			void(double,
+				std::vector<double>&,
+				std::vector<double>&)
+			>& dynFun);
+
+		/**
+		* @brief Construtor a partir de um estado, inicial ou restaurado de um
+		* checkpoint (LoadCheckpoint), como na versão de CashKarpRange que
+		* recebe IntegratorState. O ponto inicial só é entregue se nenhum
+		* passo tiver sido dado.
+		* @param[in] state Estado da integração (entrada)
+		* @param[in] tSpan Intervalo de integração, com início e fim (entrada)
+		* @param[in] tolerance Tolerância aceita pelo algoritmo (entrada)
+		* @param[in] maximumNumberOfSteps Quantidade máxima de iterações, contadas
+		* desde o início da integração (entrada)
+		* @param[in] dynFun Função que computa os valores do sistema de EDO`s (entrada)
+		*/
+		Stepper(
+			const IntegratorState& state,
+			std::pair<double, double>& tSpan,
+			double tolerance,
+			std::size_t maximumNumberOfSteps,
+			std::function<
+			void(double,
+				std::vector<double>&,
+				std::vector<double>&)
+			>& dynFun);
+
+		/**
+		* @brief Avança até o próximo ponto da trajetória: na primeira chamada,
+		* o ponto inicial; nas seguintes, um passo aceito.
+		* @return false se a integração já terminou (nenhum ponto novo)
+		*/
+		bool Next();
+
+		/**
+		* @brief Indica que não há mais pontos: Next() retornará false.
+		*/
+		bool Finished() const { return phase == Phase::Finished; }
+
+		/**
+		* @brief Valor de t do último ponto entregue por Next().
+		*/
+		double T() const { return state.t; }
+
+		/**
+		* @brief Valores de u do último ponto entregue por Next().
+		*/
+		const std::vector<double>& U() const { return state.u; }
+
+		/**
+		* @brief Estado completo, que pode ser gravado por SaveCheckpoint.
+		*/
+		const IntegratorState& State() const { return state; }
+
+	private:
+		enum class Phase {
+			// O ponto inicial ainda não foi entregue
+			Initial,
+			// Próxima chamada a Next() dá um passo
+			Stepping,
+			// Fim do intervalo ou do limite de passos
+			Finished
+		};
+
+		IntegratorState state;
+		std::pair<double, double> tSpan;
+		double tolerance;
+		std::size_t maximumNumberOfSteps;
+		std::function<
+			void(double,
+				std::vector<double>&,
+				std::vector<double>&)
+			>* dynFun;
+		Phase phase;
+		std::vector<double> dudt, uScaled;
+	};
+
+	/**
+	* @brief Intercala integrações em uma única thread: a cada rodada, cada
+	* Stepper não terminado avança um ponto, entregue imediatamente a
+	* consumer, até que todos terminem.
+	* @param[in, out] steppers Integrações em andamento (entrada e saída)
+	* @param[in] consumer Função chamada com o índice da integração, t e u
+	* (entrada)
+	* @return Quantidade de pontos entregues
+	*/
+	std::size_t RoundRobin(
+		std::vector<Stepper>& steppers,
+		std::function<
+		void(std::size_t,
+			double,
+			const std::vector<double>&)
+		>& consumer);
+}
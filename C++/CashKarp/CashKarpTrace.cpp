@@ -0,0 +1,148 @@
+/**
+* @file CashKarpTrace.cpp
+* @brief Registro (trace) do histórico de passos do método de Cash-Karp
+*/
+
+#include "CashKarpTrace.hpp"
+#include <cmath>
+#include <iomanip>
+
+namespace {
+	/*
+		Valores não finitos (um erro que divergiu, por exemplo) não são
+		aceitos em JSON, sendo substituídos por null.
+	*/
+	struct JSONNumber {
+		double value;
+	};
+
+	std::ostream& operator<<(std::ostream& out, JSONNumber number) {
+		if (std::isfinite(number.value))
+			return out << number.value;
+		return out << "null";
+	}
+}
+
+CashKarp::StepTrace::StepTrace(std::size_t capacity) :
+	records(capacity > 0 ? capacity : 1),
+	next(0),
+	count(0),
+	dropped(0),
+	rhsNanoseconds(0),
+	origin(std::chrono::steady_clock::now())
+{
+}
+
+void CashKarp::StepTrace::Record(const TraceRecord& record)
+{
+	records[next] = record;
+	next = (next + 1 == records.size()) ? 0 : next + 1;
+	if (count < records.size())
+		count++;
+	else
+		dropped++;
+}
+
+void CashKarp::StepTrace::Clear()
+{
+	next = 0;
+	count = 0;
+	dropped = 0;
+	rhsNanoseconds = 0;
+	origin = std::chrono::steady_clock::now();
+}
+
+const CashKarp::TraceRecord& CashKarp::StepTrace::operator[](std::size_t index) const
+{
+	/*
+		Com o buffer cheio, o registro mais antigo é justamente o próximo
+		a ser sobrescrito.
+	*/
+	std::size_t oldest = (count < records.size()) ? 0 : next;
+	std::size_t position = oldest + index;
+	if (position >= records.size())
+		position -= records.size();
+	return records[position];
+}
+
+std::uint64_t CashKarp::StepTrace::Now() const
+{
+	return static_cast<std::uint64_t>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - origin).count());
+}
+
+std::function<
+	void(
+		double,
+		std::vector<double>&,
+		std::vector<double>&)>
+	CashKarp::StepTrace::Wrap(
+		std::function<
+		void(
+			double,
+			std::vector<double>&,
+			std::vector<double>&)>& dynFun)
+{
+	return [this, &dynFun](
+		double t,
+		std::vector<double>& u,
+		std::vector<double>& dudt)
+	{
+		std::uint64_t start = Now();
+		dynFun(t, u, dudt);
+		rhsNanoseconds += Now() - start;
+	};
+}
+
+void CashKarp::StepTrace::WriteCSV(std::ostream& out) const
+{
+	std::streamsize precision = out.precision();
+	out << std::setprecision(17);
+	out << "t,step_size,error_norm,accepted,start_ns,duration_ns,rhs_ns\n";
+	for (std::size_t i = 0; i < count; i++) {
+		const TraceRecord& record = (*this)[i];
+		out << record.t << ','
+			<< record.stepSize << ','
+			<< record.errorNorm << ','
+			<< (record.accepted ? 1 : 0) << ','
+			<< record.startNanoseconds << ','
+			<< record.durationNanoseconds << ','
+			<< record.rhsNanoseconds << '\n';
+	}
+	out.precision(precision);
+}
+
+void CashKarp::StepTrace::WriteChromeTrace(std::ostream& out) const
+{
+	/*
+		O formato utiliza microssegundos (valores fracionários são aceitos).
+		Eventos "X" são intervalos completos e eventos "C" são contadores,
+		exibidos como gráficos na mesma linha do tempo.
+	*/
+	std::streamsize precision = out.precision();
+	out << std::setprecision(17);
+	out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	out << "\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+		<< "\"args\":{\"name\":\"CashKarp\"}}";
+	for (std::size_t i = 0; i < count; i++) {
+		const TraceRecord& record = (*this)[i];
+		double start = record.startNanoseconds * 1.0e-3;
+		out << ",\n{\"name\":\"" << (record.accepted ? "accepted" : "rejected")
+			<< "\",\"cat\":\"step\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+			<< ",\"ts\":" << start
+			<< ",\"dur\":" << record.durationNanoseconds * 1.0e-3
+			<< ",\"args\":{\"t\":" << JSONNumber{ record.t }
+			<< ",\"step_size\":" << JSONNumber{ record.stepSize }
+			<< ",\"error_norm\":" << JSONNumber{ record.errorNorm }
+			<< ",\"rhs_us\":" << record.rhsNanoseconds * 1.0e-3 << "}}";
+		out << ",\n{\"name\":\"step_size\",\"ph\":\"C\",\"pid\":1"
+			<< ",\"ts\":" << start
+			<< ",\"args\":{\"h\":" << JSONNumber{ record.stepSize } << "}}";
+		out << ",\n{\"name\":\"error_norm\",\"ph\":\"C\",\"pid\":1"
+			<< ",\"ts\":" << start
+			<< ",\"args\":{\"error\":" << JSONNumber{ record.errorNorm } << "}}";
+	}
+	out << "\n]}\n";
+	out.precision(precision);
+}
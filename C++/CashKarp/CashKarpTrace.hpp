@@ -0,0 +1,138 @@
+/**
+* @file CashKarpTrace.hpp
+* @brief Registro (trace) do histórico de passos do método de Cash-Karp
+*/
+
+/*
+	* Cada tentativa de passo realizada por CashKarpQualityStep (aceita ou
+	rejeitada) é armazenada em um buffer circular pré-alocado, de forma que
+	a memória utilizada é limitada independentemente da duração da
+	integração: ao atingir a capacidade, os registros mais antigos são
+	sobrescritos.
+
+	* O histórico pode ser exportado em CSV ou no formato JSON do Chrome
+	Trace (chrome://tracing), que também é aceito pelo Perfetto
+	(ui.perfetto.dev), permitindo visualizar a integração sem um depurador.
+
+	* Arquivo de cabeçalho, não contém implementações.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <vector>
+
+namespace CashKarp {
+	/**
+	* @brief Registro de uma tentativa de passo.
+	*/
+	struct TraceRecord {
+		// Valor de t no início da tentativa
+		double t;
+		// Passo utilizado na tentativa
+		double stepSize;
+		// Maior erro estimado, normalizado pela tolerância (aceito se <= 1)
+		double errorNorm;
+		// Indica se o passo foi aceito
+		bool accepted;
+		// Instante de início, em nanossegundos desde a criação do trace
+		std::uint64_t startNanoseconds;
+		// Duração total da tentativa, em nanossegundos
+		std::uint64_t durationNanoseconds;
+		// Tempo gasto dentro de dynFun durante a tentativa, em nanossegundos
+		std::uint64_t rhsNanoseconds;
+	};
+
+	/**
+	* @brief Buffer circular com o histórico de passos de uma integração.
+	*/
+	class StepTrace {
+	public:
+		/**
+		* @brief Construtor. Toda a memória é alocada aqui.
+		* @param[in] capacity Quantidade máxima de registros mantidos (entrada)
+		*/
+		explicit StepTrace(std::size_t capacity);
+
+		/**
+		* @brief Armazena um registro, sobrescrevendo o mais antigo caso o
+		* buffer esteja cheio. Não realiza alocações.
+		* @param[in] record Registro a ser armazenado (entrada)
+		*/
+		void Record(const TraceRecord& record);
+
+		/**
+		* @brief Remove todos os registros e reinicia o relógio.
+		*/
+		void Clear();
+
+		/**
+		* @brief Quantidade de registros armazenados.
+		*/
+		std::size_t Size() const { return count; }
+
+		/**
+		* @brief Quantidade de registros descartados por falta de espaço.
+		*/
+		std::size_t Dropped() const { return dropped; }
+
+		/**
+		* @brief Acessa um registro, do mais antigo (0) ao mais recente.
+		* @param[in] index Índice do registro (entrada)
+		*/
+		const TraceRecord& operator[](std::size_t index) const;
+
+		/**
+		* @brief Nanossegundos desde a criação (ou último Clear) do trace.
+		*/
+		std::uint64_t Now() const;
+
+		/**
+		* @brief Tempo total acumulado dentro de funções envolvidas por Wrap.
+		*/
+		std::uint64_t RhsNanoseconds() const { return rhsNanoseconds; }
+
+		/**
+		* @brief Envolve dynFun, acumulando o tempo gasto em suas chamadas.
+		* CashKarpRange faz isso automaticamente; é necessário apenas ao
+		* utilizar CashKarpQualityStep diretamente.
+		* @param[in] dynFun Função que calcula as derivadas (entrada)
+		* @return Função equivalente, instrumentada
+		*/
+		std::function<
+			void(
+				double,
+				std::vector<double>&,
+				std::vector<double>&)>
+			Wrap(
+				std::function<
+				void(
+					double,
+					std::vector<double>&,
+					std::vector<double>&)>& dynFun);
+
+		/**
+		* @brief Exporta os registros em CSV, um por linha, com cabeçalho.
+		* @param[in, out] out Fluxo de saída (entrada e saída)
+		*/
+		void WriteCSV(std::ostream& out) const;
+
+		/**
+		* @brief Exporta os registros no formato JSON do Chrome Trace/Perfetto.
+		* Cada tentativa é um evento de duração ("accepted" ou "rejected"), e o
+		* passo e o erro são exportados também como contadores.
+		* @param[in, out] out Fluxo de saída (entrada e saída)
+		*/
+		void WriteChromeTrace(std::ostream& out) const;
+
+	private:
+		std::vector<TraceRecord> records;
+		std::size_t next, count, dropped;
+		std::uint64_t rhsNanoseconds;
+		std::chrono::steady_clock::time_point origin;
+	};
+}
@@ -0,0 +1,166 @@
+/**
+* @file Delay.cpp
+* @brief Equações diferenciais com atrasos constantes, via Cash-Karp
+*/
+
+#include "Delay.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+std::vector<double> Delay::Breakpoints(
+	double tInitial,
+	double tFinal,
+	const std::vector<double>& delays,
+	std::size_t levels)
+{
+	/*
+		Somas em ordens diferentes (tau_1 + tau_2 e tau_2 + tau_1) podem
+		diferir no último bit; valores próximos são unificados.
+	*/
+	auto close = [](double a, double b) {
+		return std::abs(b - a) <= 16.0 * DBL_EPSILON * std::max(1.0, std::abs(b));
+	};
+
+	std::vector<double> breakpoints;
+	std::vector<double> level = { tInitial }, nextLevel;
+
+	for (std::size_t l = 0; l < levels; l++) {
+		nextLevel.clear();
+		for (double point : level) {
+			for (double delay : delays) {
+				if (point + delay <= tFinal)
+					nextLevel.push_back(point + delay);
+			}
+		}
+		std::sort(nextLevel.begin(), nextLevel.end());
+		nextLevel.erase(std::unique(nextLevel.begin(), nextLevel.end(), close), nextLevel.end());
+		breakpoints.insert(breakpoints.end(), nextLevel.begin(), nextLevel.end());
+		level.swap(nextLevel);
+	}
+
+	std::sort(breakpoints.begin(), breakpoints.end());
+	breakpoints.erase(std::unique(breakpoints.begin(), breakpoints.end(), close), breakpoints.end());
+	return breakpoints;
+}
+
+CashKarp::IntegrationStatistics Delay::DelayRange(
+	std::vector<double>& uInitial,
+	InitialHistory& initialHistory,
+	std::vector<double>& delays,
+	std::pair<double, double>& tSpan,
+	double tolerance,
+	double initialStep,
+	double minimumStep,
+	std::size_t maximumNumberOfSteps,
+	DelayFunction& dynFun,
+	std::function<
+	void(double,
+		std::vector<double>&)
+	>& stepObserver,
+	HistoryStatistics* historyStatistics)
+{
+	if (!(tSpan.second > tSpan.first))
+		throw "Delay: o intervalo de integração deve ser crescente.";
+	if (delays.empty())
+		throw "Delay: nenhum atraso informado.";
+
+	double minimumDelay = delays[0], maximumDelay = delays[0];
+	for (double delay : delays) {
+		if (!(delay > 0.0))
+			throw "Delay: os atrasos devem ser positivos.";
+		minimumDelay = std::min(minimumDelay, delay);
+		maximumDelay = std::max(maximumDelay, delay);
+	}
+
+	std::size_t i, uSize = uInitial.size(), delaySize = delays.size();
+	History history(uSize, maximumDelay, tSpan.first, initialHistory);
+	std::vector<double> uDelayed(delaySize * uSize);
+	// Um cursor por atraso: cada um percorre o histórico em ordem crescente
+	std::vector<std::uint64_t> cursors(delaySize, 0);
+
+	std::function<void(double, std::vector<double>&, std::vector<double>&)> delayedFun =
+		[&](double t, std::vector<double>& u, std::vector<double>& dudt) {
+			for (std::size_t k = 0; k < delaySize; k++)
+				history.Evaluate(t - delays[k], uDelayed.data() + k * uSize, cursors[k]);
+			dynFun(t, u, uDelayed, dudt);
+		};
+
+	std::vector<double> breakpoints = Breakpoints(tSpan.first, tSpan.second, delays);
+	std::size_t nextBreakpoint = 0;
+
+	std::vector<double> u = uInitial, dudt(uSize), uScaled(uSize);
+	CashKarp::IntegrationStatistics statistics;
+#if CASHKARP_STATISTICS
+	CashKarp::IntegrationStatistics* statisticsPointer = &statistics;
+#else
+	CashKarp::IntegrationStatistics* statisticsPointer = nullptr;
+#endif
+	std::size_t largestHistory = 0;
+
+	double t = tSpan.first;
+	double stepSize = std::abs(initialStep);
+	double previousStepSize = 0.0, nextStepSize;
+
+	stepObserver(t, u);
+
+	for (std::size_t step = 0; step <= maximumNumberOfSteps; step++)
+	{
+		delayedFun(t, u, dudt);
+#if CASHKARP_STATISTICS
+		statistics.rhsEvaluations++;
+#endif
+
+		/*
+			Os passos terminam exatamente nas descontinuidades, que são
+			marcadas no histórico para que a interpolação não as atravesse.
+		*/
+		bool discontinuity = false;
+		while (nextBreakpoint < breakpoints.size() && breakpoints[nextBreakpoint] <= t) {
+			discontinuity = true;
+			nextBreakpoint++;
+		}
+		history.Push(t, u, dudt, discontinuity);
+		largestHistory = std::max(largestHistory, history.Size());
+
+		for (i = 0; i < uSize; i++)
+			uScaled[i] = std::abs(u[i]) + std::abs(dudt[i] * stepSize) + 1.0e-30;
+
+		/*
+			O passo não ultrapassa o menor atraso (os estágios consultam
+			apenas o histórico já aceito), a próxima descontinuidade e o fim
+			do intervalo.
+		*/
+		double tStop =
+			(nextBreakpoint < breakpoints.size())
+			? breakpoints[nextBreakpoint]
+			: tSpan.second;
+		stepSize = std::min(stepSize, minimumDelay);
+		if (t + stepSize > tStop)
+			stepSize = tStop - t;
+
+		CashKarp::CashKarpQualityStep(
+			u, dudt, uScaled, t, stepSize, tolerance,
+			previousStepSize, nextStepSize, delayedFun, statisticsPointer);
+
+		/*
+			t + (tStop - t) pode diferir de tStop no último bit.
+		*/
+		if (std::abs(t - tStop) <= 16.0 * DBL_EPSILON * std::max(1.0, std::abs(tStop)))
+			t = tStop;
+
+		stepObserver(t, u);
+
+		if (t >= tSpan.second)
+			break;
+
+		stepSize = nextStepSize;
+	}
+
+	if (historyStatistics != nullptr) {
+		historyStatistics->largestSize = largestHistory;
+		historyStatistics->lookups = history.Lookups();
+		historyStatistics->searches = history.Searches();
+	}
+	return statistics;
+}
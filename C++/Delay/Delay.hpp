@@ -0,0 +1,95 @@
+/**
+* @file Delay.hpp
+* @brief Equações diferenciais com atrasos constantes, via Cash-Karp
+*/
+
+/*
+	* Resolve du/dt = f(t, u(t), u(t - tau_1), ..., u(t - tau_K)), com
+	u(t) = phi(t) para t < t_0, na forma de dde23 (MATLAB): dynFun recebe os
+	valores atrasados em uDelayed, com uDelayed[k * N + i] = u_i(t - tau_k).
+
+	* Os passos são os de CashKarpQualityStep, limitados ao menor atraso: os
+	estágios de um passo de t a t + h consultam instantes anteriores a t,
+	já presentes no histórico (History), sem extrapolação nem iterações.
+	Cada consulta interpola o polinômio de Hermite de grau 5 de três nós
+	vizinhos do histórico.
+
+	* Descontinuidades: em geral phi'(t_0) difere de f(t_0), e a
+	descontinuidade se propaga para t_0 + tau_k (na derivada segunda), para
+	t_0 + tau_k + tau_j (na terceira) e assim por diante. Os passos terminam
+	exatamente nesses instantes, até o nível em que a descontinuidade deixa
+	de ser vista pelo método de ordem 5 (Breakpoints), de modo que nenhum
+	passo (nem interpolante) atravessa uma descontinuidade.
+
+	* Arquivo de cabeçalho, não contém implementações.
+*/
+
+#pragma once
+
+#include "CashKarp.hpp"
+#include "History.hpp"
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace Delay {
+	/**
+	* @brief Sistema com atrasos: void(t, u, uDelayed, dudt), com
+	* uDelayed[k * N + i] = u_i(t - delays[k]).
+	*/
+	using DelayFunction = std::function<
+		void(double,
+			std::vector<double>&,
+			std::vector<double>&,
+			std::vector<double>&)>;
+
+	/**
+	* @brief Instantes de descontinuidade t_0 + soma de até levels atrasos,
+	* em ordem crescente, dentro de (tInitial, tFinal].
+	* @param[in] tInitial Instante inicial (entrada)
+	* @param[in] tFinal Instante final (entrada)
+	* @param[in] delays Atrasos (entrada)
+	* @param[in] levels Quantidade de propagações acompanhadas (entrada)
+	*/
+	std::vector<double> Breakpoints(
+		double tInitial,
+		double tFinal,
+		const std::vector<double>& delays,
+		std::size_t levels = 5);
+
+	/**
+	* @brief Rotina que aplica o método de Cash-Karp a um sistema com atrasos
+	* constantes, entregando cada passo aceito a uma função.
+	* @param[in] uInitial Valores iniciais u(t_0) (entrada)
+	* @param[in] initialHistory Valores de u antes de t_0 (entrada)
+	* @param[in] delays Atrasos, positivos (entrada)
+	* @param[in] tSpan Intervalo de integração, com início e fim crescentes
+	* (entrada)
+	* @param[in] tolerance Tolerância aceita pelo algoritmo (entrada)
+	* @param[in] initialStep Passo inicial (entrada)
+	* @param[in] minimumStep Passo mínimo, atualmente não implementado (entrada)
+	* @param[in] maximumNumberOfSteps Quantidade máxima de iterações (entrada)
+	* @param[in] dynFun Função que computa os valores do sistema (entrada)
+	* @param[in] stepObserver Função chamada com t e u no ponto inicial e após
+	* cada passo aceito (entrada)
+	* @param[out] historyStatistics Se não for nulo, recebe os contadores do
+	* histórico (saída)
+	* @return Estatísticas da integração (zeradas se CASHKARP_STATISTICS for 0)
+	*/
+	CashKarp::IntegrationStatistics DelayRange(
+		std::vector<double>& uInitial,
+		InitialHistory& initialHistory,
+		std::vector<double>& delays,
+		std::pair<double, double>& tSpan,
+		double tolerance,
+		double initialStep,
+		double minimumStep,
+		std::size_t maximumNumberOfSteps,
+		DelayFunction& dynFun,
+		std::function<
+		void(double,
+			std::vector<double>&)
+		>& stepObserver,
+		HistoryStatistics* historyStatistics = nullptr);
+}
@@ -0,0 +1,209 @@
+/**
+* @file History.cpp
+* @brief Histórico de passos aceitos, com interpolação, para equações com atraso
+*/
+
+#include "History.hpp"
+
+Delay::History::History(
+	std::size_t systemSize,
+	double maximumDelay,
+	double tInitial,
+	InitialHistory initialHistory,
+	std::size_t initialCapacity) :
+	systemSize(systemSize),
+	maximumDelay(maximumDelay),
+	tInitial(tInitial),
+	initialHistory(initialHistory),
+	initialValues(systemSize)
+{
+	std::size_t capacity = 2;
+	while (capacity < initialCapacity)
+		capacity *= 2;
+	mask = capacity - 1;
+	times.resize(capacity);
+	discontinuities.resize(capacity);
+	states.resize(capacity * systemSize);
+	derivatives.resize(capacity * systemSize);
+}
+
+void Delay::History::Grow()
+{
+	std::size_t capacity = 2 * (mask + 1);
+	std::size_t newMask = capacity - 1;
+	std::vector<double> newTimes(capacity);
+	std::vector<char> newDiscontinuities(capacity);
+	std::vector<double> newStates(capacity * systemSize);
+	std::vector<double> newDerivatives(capacity * systemSize);
+
+	for (std::uint64_t sequence = begin; sequence < end; sequence++) {
+		std::size_t from = sequence & mask, to = sequence & newMask;
+		newTimes[to] = times[from];
+		newDiscontinuities[to] = discontinuities[from];
+		for (std::size_t i = 0; i < systemSize; i++) {
+			newStates[to * systemSize + i] = states[from * systemSize + i];
+			newDerivatives[to * systemSize + i] = derivatives[from * systemSize + i];
+		}
+	}
+
+	times.swap(newTimes);
+	discontinuities.swap(newDiscontinuities);
+	states.swap(newStates);
+	derivatives.swap(newDerivatives);
+	mask = newMask;
+}
+
+void Delay::History::Push(
+	double t,
+	const std::vector<double>& u,
+	const std::vector<double>& dudt,
+	bool discontinuity)
+{
+	if (Size() == Capacity())
+		Grow();
+
+	std::size_t position = end & mask;
+	times[position] = t;
+	discontinuities[position] = discontinuity;
+	for (std::size_t i = 0; i < systemSize; i++) {
+		states[position * systemSize + i] = u[i];
+		derivatives[position * systemSize + i] = dudt[i];
+	}
+	end++;
+
+	/*
+		Mantém o nó mais recente anterior a t - maximumDelay, início do
+		intervalo que contém esse instante.
+	*/
+	double oldestNeeded = t - maximumDelay;
+	while (end - begin >= 2 && times[(begin + 1) & mask] <= oldestNeeded)
+		begin++;
+}
+
+std::uint64_t Delay::History::Find(double t, std::uint64_t hint)
+{
+	/*
+		O intervalo k vai do nó k ao nó k + 1, com k entre begin e end - 2.
+	*/
+	std::uint64_t last = end - 2;
+	if (hint >= begin && hint <= last) {
+		if (times[hint & mask] <= t) {
+			if (hint == last || t <= times[(hint + 1) & mask])
+				return hint;
+			if (hint + 1 == last || t <= times[(hint + 2) & mask])
+				return hint + 1;
+		}
+		// Os estágios de Cash-Karp não são crescentes (c5 = 1, c6 = 7/8)
+		else if (hint > begin && times[(hint - 1) & mask] <= t) {
+			return hint - 1;
+		}
+	}
+
+	searches++;
+	std::uint64_t low = begin, high = last;
+	while (low < high) {
+		std::uint64_t middle = low + (high - low + 1) / 2;
+		if (times[middle & mask] <= t)
+			low = middle;
+		else
+			high = middle - 1;
+	}
+	return low;
+}
+
+void Delay::History::Evaluate(double t, double* output, std::uint64_t& cursor)
+{
+	if (t < tInitial) {
+		initialHistory(t, initialValues);
+		for (std::size_t i = 0; i < systemSize; i++)
+			output[i] = initialValues[i];
+		return;
+	}
+	if (end == begin || t < times[begin & mask])
+		throw "Delay: instante consultado fora do histórico armazenado.";
+
+	if (end - begin == 1) {
+		std::size_t position = begin & mask;
+		double dt = t - times[position];
+		for (std::size_t i = 0; i < systemSize; i++) {
+			output[i] =
+				states[position * systemSize + i] +
+				dt * derivatives[position * systemSize + i];
+		}
+		return;
+	}
+
+	lookups++;
+	std::uint64_t segment = Find(t, cursor);
+	cursor = segment;
+
+	/*
+		Três nós consecutivos, sem descontinuidade no nó do meio: o anterior
+		ao intervalo, se houver, ou o seguinte.
+	*/
+	bool previous = segment > begin && !discontinuities[segment & mask];
+	bool next = segment + 2 < end && !discontinuities[(segment + 1) & mask];
+
+	if (!previous && !next) {
+		/*
+			Polinômio cúbico de Hermite no intervalo [t0, t1].
+		*/
+		std::size_t position0 = segment & mask, position1 = (segment + 1) & mask;
+		double t0 = times[position0];
+		double h = times[position1] - t0;
+		double s = (t - t0) / h;
+		double s1 = s - 1.0;
+		double h00 = (1.0 + 2.0 * s) * s1 * s1;
+		double h10 = h * s * s1 * s1;
+		double h01 = s * s * (3.0 - 2.0 * s);
+		double h11 = h * s * s * s1;
+
+		const double* u0 = states.data() + position0 * systemSize;
+		const double* u1 = states.data() + position1 * systemSize;
+		const double* f0 = derivatives.data() + position0 * systemSize;
+		const double* f1 = derivatives.data() + position1 * systemSize;
+		for (std::size_t i = 0; i < systemSize; i++)
+			output[i] = h00 * u0[i] + h10 * f0[i] + h01 * u1[i] + h11 * f1[i];
+		return;
+	}
+
+	/*
+		Polinômio de Hermite de grau 5 nos nós t0, t1 e t2, na forma de
+		Newton com nós repetidos (t0, t0, t1, t1, t2, t2):
+		p(t) = u0 + w1 f0 + w2 d2 + w3 d3 + w4 d4 + w5 d5, com
+		w1 = t - t0, w2 = w1^2, w3 = w2 (t - t1), w4 = w3 (t - t1) e
+		w5 = w4 (t - t2), onde dk são as diferenças divididas de ordem k.
+	*/
+	std::uint64_t first = previous ? segment - 1 : segment;
+	std::size_t position0 = first & mask, position1 = (first + 1) & mask,
+		position2 = (first + 2) & mask;
+	double t0 = times[position0], t1 = times[position1], t2 = times[position2];
+	double r01 = 1.0 / (t1 - t0), r12 = 1.0 / (t2 - t1), r02 = 1.0 / (t2 - t0);
+	double w1 = t - t0;
+	double w2 = w1 * w1;
+	double w3 = w2 * (t - t1);
+	double w4 = w3 * (t - t1);
+	double w5 = w4 * (t - t2);
+
+	const double* u0 = states.data() + position0 * systemSize;
+	const double* u1 = states.data() + position1 * systemSize;
+	const double* u2 = states.data() + position2 * systemSize;
+	const double* f0 = derivatives.data() + position0 * systemSize;
+	const double* f1 = derivatives.data() + position1 * systemSize;
+	const double* f2 = derivatives.data() + position2 * systemSize;
+	for (std::size_t i = 0; i < systemSize; i++) {
+		double d01 = (u1[i] - u0[i]) * r01;
+		double d12 = (u2[i] - u1[i]) * r12;
+		double d001 = (d01 - f0[i]) * r01;
+		double d011 = (f1[i] - d01) * r01;
+		double d112 = (d12 - f1[i]) * r12;
+		double d122 = (f2[i] - d12) * r12;
+		double d0011 = (d011 - d001) * r01;
+		double d0112 = (d112 - d011) * r02;
+		double d1122 = (d122 - d112) * r12;
+		double d00112 = (d0112 - d0011) * r02;
+		double d01122 = (d1122 - d0112) * r02;
+		double d001122 = (d01122 - d00112) * r02;
+		output[i] = u0[i] + w1 * f0[i] + w2 * d001 + w3 * d0011 + w4 * d00112 + w5 * d001122;
+	}
+}
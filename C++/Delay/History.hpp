@@ -0,0 +1,170 @@
+/**
+* @file History.hpp
+* @brief Histórico de passos aceitos, com interpolação, para equações com atraso
+*/
+
+/*
+	* Um instante no passo aceito de t_k a t_k+1 é interpolado pelo
+	polinômio de Hermite de grau 5 que coincide com u e du/dt em três nós
+	consecutivos: t_k-1, t_k e t_k+1 ou, se não houver t_k-1, t_k, t_k+1 e
+	t_k+2. O erro é O(h^6), abaixo do erro local O(h^5) de Cash-Karp. O
+	polinômio cúbico de Hermite dos extremos do passo (erro O(h^4)) faria
+	o erro da interpolação dominar o da integração sempre que os valores
+	atrasados viessem do histórico: em u' = -u(t - 1) com u = cos(t) antes
+	de t_0 = 0, o erro em t = 2 era cerca de 100 vezes a tolerância.
+
+	* Os três nós não atravessam uma descontinuidade da solução (nós
+	marcados em Push): em um passo entre duas descontinuidades, sem outro
+	nó disponível, a interpolação é a cúbica de Hermite do passo. Os nós
+	(t, u, du/dt) ficam em um buffer circular cuja capacidade é uma
+	potência de 2; antes de t_0 os valores vêm da função de histórico
+	inicial.
+
+	* Localização do intervalo que contém um instante:
+	-> O(1) com um cursor: atrasos constantes consultam instantes crescentes,
+	portanto o intervalo procurado é, quase sempre, o mesmo da consulta
+	anterior ou o seguinte.
+	-> O(log n) por busca binária quando o cursor não acerta.
+	Os cursores guardam o número de sequência do nó (e não sua posição no
+	buffer), permanecendo válidos quando nós antigos são descartados.
+
+	* Nós mais antigos que t - maximumDelay deixam de ser necessários e são
+	descartados a cada Push: a memória é proporcional à quantidade de
+	passos dentro de um atraso, e não à duração da integração.
+
+	* Arquivo de cabeçalho, não contém implementações.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace Delay {
+	/**
+	* @brief Histórico inicial: void(t, u), atribui a u os valores da
+	* solução em t < t_0.
+	*/
+	using InitialHistory = std::function<
+		void(double,
+			std::vector<double>&)>;
+
+	/**
+	* @brief Contadores do histórico durante uma integração.
+	*/
+	struct HistoryStatistics {
+		// Maior quantidade de nós armazenados ao mesmo tempo
+		std::size_t largestSize = 0;
+		// Consultas a instantes posteriores a t_0
+		std::uint64_t lookups = 0;
+		// Consultas que não acertaram o cursor e exigiram busca binária
+		std::uint64_t searches = 0;
+	};
+
+	/**
+	* @brief Histórico de passos aceitos em um buffer circular.
+	*/
+	class History {
+	public:
+		/**
+		* @brief Construtor
+		* @param[in] systemSize Quantidade de equações do sistema (entrada)
+		* @param[in] maximumDelay Maior atraso consultado; nós anteriores a
+		* t - maximumDelay são descartados (entrada)
+		* @param[in] tInitial Instante inicial t_0 (entrada)
+		* @param[in] initialHistory Valores antes de t_0 (entrada)
+		* @param[in] initialCapacity Capacidade inicial, em nós, arredondada
+		* para uma potência de 2 (entrada)
+		*/
+		History(
+			std::size_t systemSize,
+			double maximumDelay,
+			double tInitial,
+			InitialHistory initialHistory,
+			std::size_t initialCapacity = 256);
+
+		/**
+		* @brief Acrescenta um nó aceito, com t crescente, e descarta os nós
+		* que deixaram de ser necessários.
+		* @param[in] t Valor de t (entrada)
+		* @param[in] u Valores de u (entrada)
+		* @param[in] dudt Valores de du/dt (entrada)
+		* @param[in] discontinuity Indica que alguma derivada da solução é
+		* descontínua em t: a interpolação não usa nós dos dois lados (entrada)
+		*/
+		void Push(
+			double t,
+			const std::vector<double>& u,
+			const std::vector<double>& dudt,
+			bool discontinuity = false);
+
+		/**
+		* @brief Valores de u em t, interpolados.
+		* @param[in] t Instante consultado, anterior ao último nó ou pouco
+		* posterior a ele (extrapolação do último intervalo) (entrada)
+		* @param[out] output systemSize valores de u(t) (saída)
+		* @param[in, out] cursor Número de sequência do intervalo da consulta
+		* anterior, atualizado com o desta (entrada e saída)
+		*/
+		void Evaluate(double t, double* output, std::uint64_t& cursor);
+
+		/**
+		* @brief Valores de u em t, com o cursor interno.
+		* @param[in] t Instante consultado (entrada)
+		* @param[out] output systemSize valores de u(t) (saída)
+		*/
+		void Evaluate(double t, double* output) { Evaluate(t, output, cursor); }
+
+		/**
+		* @brief Quantidade de nós armazenados.
+		*/
+		std::size_t Size() const { return static_cast<std::size_t>(end - begin); }
+
+		/**
+		* @brief Capacidade atual do buffer, em nós.
+		*/
+		std::size_t Capacity() const { return mask + 1; }
+
+		/**
+		* @brief Instante do nó mais antigo ainda armazenado.
+		*/
+		double OldestTime() const { return times[begin & mask]; }
+
+		/**
+		* @brief Quantidade de consultas a instantes posteriores a t_0.
+		*/
+		std::uint64_t Lookups() const { return lookups; }
+
+		/**
+		* @brief Quantidade de consultas que não acertaram o cursor e exigiram
+		* busca binária.
+		*/
+		std::uint64_t Searches() const { return searches; }
+
+	private:
+		void Grow();
+		std::uint64_t Find(double t, std::uint64_t hint);
+
+		std::size_t systemSize;
+		double maximumDelay;
+		double tInitial;
+		InitialHistory initialHistory;
+		std::vector<double> initialValues;
+
+		// Nós: t, u, du/dt e descontinuidade, na posição (sequência & mask)
+		std::vector<double> times;
+		std::vector<char> discontinuities;
+		std::vector<double> states;
+		std::vector<double> derivatives;
+		std::size_t mask;
+		// Números de sequência do nó mais antigo e do seguinte ao último
+		std::uint64_t begin = 0;
+		std::uint64_t end = 0;
+
+		std::uint64_t cursor = 0;
+		std::uint64_t lookups = 0;
+		std::uint64_t searches = 0;
+	};
+}
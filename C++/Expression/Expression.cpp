@@ -0,0 +1,775 @@
+/**
+* @file Expression.cpp
+* @brief Sistemas de EDO`s definidos em texto, compilados para bytecode
+*/
+
+#include "Expression.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <tuple>
+
+using Expression::Instruction;
+using Expression::Operation;
+
+namespace {
+	/*
+		Mensagem do último erro de compilação. A exceção aponta para este
+		texto, que permanece válido até o próximo erro na mesma thread.
+	*/
+	thread_local std::string errorMessage;
+
+	[[noreturn]] void Fail(std::size_t line, const std::string& message) {
+		errorMessage = "Expression: linha " + std::to_string(line) + ": " + message;
+		throw errorMessage.c_str();
+	}
+
+	bool IsPrologue(Operation operation) {
+		return operation == Operation::Constant ||
+			operation == Operation::Parameter ||
+			operation == Operation::Time;
+	}
+
+	/*
+		Apenas soma e produto: std::min e std::max devolvem o primeiro
+		operando em empates (0 e -0) e dependem da ordem com NaN.
+	*/
+	bool IsCommutative(Operation operation) {
+		return operation == Operation::Add || operation == Operation::Multiply;
+	}
+
+	bool IsUnary(Operation operation) {
+		return operation == Operation::Negate || operation >= Operation::Sqrt;
+	}
+
+	/*
+		Mesmas operações do interpretador, utilizadas no dobramento de
+		constantes.
+	*/
+	double Apply(Operation operation, double a, double b) {
+		switch (operation) {
+		case Operation::Add: return a + b;
+		case Operation::Subtract: return a - b;
+		case Operation::Multiply: return a * b;
+		case Operation::Divide: return a / b;
+		case Operation::Negate: return -a;
+		case Operation::Power: return std::pow(a, b);
+		case Operation::Minimum: return std::min(a, b);
+		case Operation::Maximum: return std::max(a, b);
+		case Operation::Sqrt: return std::sqrt(a);
+		case Operation::Exp: return std::exp(a);
+		case Operation::Log: return std::log(a);
+		case Operation::Sin: return std::sin(a);
+		case Operation::Cos: return std::cos(a);
+		case Operation::Tan: return std::tan(a);
+		case Operation::Tanh: return std::tanh(a);
+		case Operation::Atan: return std::atan(a);
+		case Operation::Abs: return std::abs(a);
+		default: return 0.0;
+		}
+	}
+
+	const char* OperationName(Operation operation) {
+		static const char* names[] = {
+			"const", "param", "time", "state", "store",
+			"add", "sub", "mul", "div", "neg", "pow", "min", "max",
+			"sqrt", "exp", "log", "sin", "cos", "tan", "tanh", "atan", "abs" };
+		return names[static_cast<int>(operation)];
+	}
+
+	/*
+		Nó do grafo de valores (cada valor é calculado uma única vez).
+	*/
+	struct Node {
+		Operation operation;
+		int first = -1;
+		int second = -1;
+		std::uint32_t index = 0;
+		double constant = 0.0;
+	};
+
+	/*
+		Grafo de valores com numeração de valores (eliminação de
+		subexpressões comuns) e dobramento de constantes.
+	*/
+	class Graph {
+	public:
+		std::vector<Node> nodes;
+
+		int Insert(Node node) {
+			if (IsCommutative(node.operation) && node.first > node.second)
+				std::swap(node.first, node.second);
+			std::uint64_t bits;
+			std::memcpy(&bits, &node.constant, sizeof(bits));
+			auto key = std::make_tuple(
+				static_cast<int>(node.operation), node.first, node.second, node.index, bits);
+			auto found = table.find(key);
+			if (found != table.end())
+				return found->second;
+			nodes.push_back(node);
+			int id = static_cast<int>(nodes.size()) - 1;
+			table[key] = id;
+			return id;
+		}
+
+		int Constant(double value) {
+			Node node;
+			node.operation = Operation::Constant;
+			node.constant = value;
+			return Insert(node);
+		}
+
+		int Load(Operation operation, std::uint32_t index) {
+			Node node;
+			node.operation = operation;
+			node.index = index;
+			return Insert(node);
+		}
+
+		bool IsConstant(int id) const {
+			return nodes[id].operation == Operation::Constant;
+		}
+
+		bool IsConstant(int id, double value) const {
+			return IsConstant(id) && nodes[id].constant == value;
+		}
+
+		int Unary(Operation operation, int a) {
+			if (IsConstant(a))
+				return Constant(Apply(operation, nodes[a].constant, 0.0));
+			if (operation == Operation::Negate && nodes[a].operation == Operation::Negate)
+				return nodes[a].first;
+			Node node;
+			node.operation = operation;
+			node.first = a;
+			return Insert(node);
+		}
+
+		int Binary(Operation operation, int a, int b) {
+			if (IsConstant(a) && IsConstant(b))
+				return Constant(Apply(operation, nodes[a].constant, nodes[b].constant));
+
+			/*
+				Apenas identidades exatas em ponto flutuante, para que o
+				resultado não dependa da simplificação. x + 0 e 0 - x não
+				entram (diferem em x = -0), nem potências além de 0, 1 e 2
+				(std::pow e os produtos arredondam de maneiras diferentes).
+			*/
+			switch (operation) {
+			case Operation::Subtract:
+				if (IsConstant(b, 0.0)) return a;
+				break;
+			case Operation::Multiply:
+				if (IsConstant(a, 1.0)) return b;
+				if (IsConstant(b, 1.0)) return a;
+				if (IsConstant(a, -1.0)) return Unary(Operation::Negate, b);
+				if (IsConstant(b, -1.0)) return Unary(Operation::Negate, a);
+				break;
+			case Operation::Divide:
+				if (IsConstant(b, 1.0)) return a;
+				if (IsConstant(b)) {
+					/*
+						Divisão por potência de 2 é trocada por multiplicação,
+						que tem o mesmo resultado quando o inverso também é
+						representável.
+					*/
+					int exponent;
+					double mantissa = std::frexp(nodes[b].constant, &exponent);
+					double inverse = 1.0 / nodes[b].constant;
+					if (std::abs(mantissa) == 0.5 && std::isfinite(inverse))
+						return Binary(Operation::Multiply, a, Constant(inverse));
+				}
+				break;
+			case Operation::Power:
+				if (IsConstant(b)) {
+					double exponent = nodes[b].constant;
+					if (exponent == 0.0) return Constant(1.0);
+					if (exponent == 1.0) return a;
+					if (exponent == 2.0) return Binary(Operation::Multiply, a, a);
+				}
+				break;
+			default:
+				break;
+			}
+
+			Node node;
+			node.operation = operation;
+			node.first = a;
+			node.second = b;
+			return Insert(node);
+		}
+
+	private:
+		std::map<std::tuple<int, int, int, std::uint32_t, std::uint64_t>, int> table;
+	};
+
+	/*
+		Analisador descendente recursivo, uma linha por vez.
+	*/
+	class Parser {
+	public:
+		Graph graph;
+		std::vector<std::string> stateNames;
+		std::vector<std::string> parameterNames;
+		std::vector<double> parameterValues;
+		std::vector<int> outputs;
+
+		void ParseSource(const std::string& source) {
+			std::istringstream stream(source);
+			std::string text;
+			lineNumber = 0;
+			while (std::getline(stream, text)) {
+				lineNumber++;
+				std::size_t comment = text.find('#');
+				if (comment != std::string::npos)
+					text.erase(comment);
+				line = text;
+				position = 0;
+				ParseLine();
+			}
+
+			if (stateNames.empty())
+				Fail(lineNumber, "nenhuma variável de estado declarada (state).");
+			for (std::size_t i = 0; i < stateNames.size(); i++) {
+				if (outputs[i] < 0)
+					Fail(lineNumber, "falta a equação de " + stateNames[i] + "'.");
+			}
+		}
+
+	private:
+		std::string line;
+		std::size_t position = 0;
+		std::size_t lineNumber = 0;
+		// Nomes visíveis nas expressões: estados, parâmetros e let
+		std::map<std::string, int> names;
+
+		void SkipSpaces() {
+			while (position < line.size() && std::isspace(static_cast<unsigned char>(line[position])))
+				position++;
+		}
+
+		bool AtEnd() {
+			SkipSpaces();
+			return position >= line.size();
+		}
+
+		bool Accept(char symbol) {
+			SkipSpaces();
+			if (position < line.size() && line[position] == symbol) {
+				position++;
+				return true;
+			}
+			return false;
+		}
+
+		void Expect(char symbol) {
+			if (!Accept(symbol))
+				Fail(lineNumber, std::string("esperado '") + symbol + "'.");
+		}
+
+		bool PeekIdentifier() {
+			SkipSpaces();
+			return position < line.size() &&
+				(std::isalpha(static_cast<unsigned char>(line[position])) || line[position] == '_');
+		}
+
+		std::string Identifier() {
+			if (!PeekIdentifier())
+				Fail(lineNumber, "esperado um nome.");
+			std::size_t start = position;
+			while (position < line.size() &&
+				(std::isalnum(static_cast<unsigned char>(line[position])) || line[position] == '_'))
+				position++;
+			return line.substr(start, position - start);
+		}
+
+		void Declare(const std::string& name, int id) {
+			static const char* reserved[] = {
+				"t", "pi", "state", "parameter", "let", "sqrt", "exp", "log", "sin",
+				"cos", "tan", "tanh", "atan", "abs", "pow", "min", "max" };
+			for (const char* word : reserved) {
+				if (name == word)
+					Fail(lineNumber, "nome reservado: " + name + ".");
+			}
+			if (names.count(name) > 0)
+				Fail(lineNumber, "nome repetido: " + name + ".");
+			names[name] = id;
+		}
+
+		void ParseLine() {
+			if (AtEnd())
+				return;
+
+			std::size_t start = position;
+			std::string word = Identifier();
+
+			if (word == "state") {
+				do {
+					std::string name = Identifier();
+					Declare(name, graph.Load(Operation::State,
+						static_cast<std::uint32_t>(stateNames.size())));
+					stateNames.push_back(name);
+					outputs.push_back(-1);
+					Accept(',');
+				} while (!AtEnd());
+			}
+			else if (word == "parameter") {
+				do {
+					std::string name = Identifier();
+					Expect('=');
+					int value = ParseExpression();
+					if (!graph.IsConstant(value))
+						Fail(lineNumber, "o valor de " + name + " deve ser constante.");
+					Declare(name, graph.Load(Operation::Parameter,
+						static_cast<std::uint32_t>(parameterNames.size())));
+					parameterNames.push_back(name);
+					parameterValues.push_back(graph.nodes[value].constant);
+				} while (Accept(','));
+			}
+			else if (word == "let") {
+				std::string name = Identifier();
+				Expect('=');
+				Declare(name, ParseExpression());
+			}
+			else {
+				auto state = std::find(stateNames.begin(), stateNames.end(), word);
+				if (state == stateNames.end() || !Accept('\'')) {
+					position = start;
+					Fail(lineNumber, "esperado state, parameter, let ou uma equação x' = ...");
+				}
+				std::size_t index = state - stateNames.begin();
+				if (outputs[index] >= 0)
+					Fail(lineNumber, "equação de " + word + "' repetida.");
+				Expect('=');
+				outputs[index] = ParseExpression();
+			}
+
+			if (!AtEnd())
+				Fail(lineNumber, "texto inesperado: " + line.substr(position) + ".");
+		}
+
+		/*
+			expressão := termo (('+' | '-') termo)*
+		*/
+		int ParseExpression() {
+			int value = ParseTerm();
+			while (true) {
+				if (Accept('+'))
+					value = graph.Binary(Operation::Add, value, ParseTerm());
+				else if (Accept('-'))
+					value = graph.Binary(Operation::Subtract, value, ParseTerm());
+				else
+					return value;
+			}
+		}
+
+		/*
+			termo := unário (('*' | '/') unário)*
+		*/
+		int ParseTerm() {
+			int value = ParseUnary();
+			while (true) {
+				if (Accept('*'))
+					value = graph.Binary(Operation::Multiply, value, ParseUnary());
+				else if (Accept('/'))
+					value = graph.Binary(Operation::Divide, value, ParseUnary());
+				else
+					return value;
+			}
+		}
+
+		/*
+			unário := ('-' | '+') unário | potência
+		*/
+		int ParseUnary() {
+			if (Accept('-'))
+				return graph.Unary(Operation::Negate, ParseUnary());
+			if (Accept('+'))
+				return ParseUnary();
+			return ParsePower();
+		}
+
+		/*
+			potência := primário ('^' unário)?, associativa à direita
+		*/
+		int ParsePower() {
+			int base = ParsePrimary();
+			if (Accept('^'))
+				return graph.Binary(Operation::Power, base, ParseUnary());
+			return base;
+		}
+
+		int ParsePrimary() {
+			SkipSpaces();
+			if (Accept('(')) {
+				int value = ParseExpression();
+				Expect(')');
+				return value;
+			}
+
+			if (position < line.size() &&
+				(std::isdigit(static_cast<unsigned char>(line[position])) || line[position] == '.'))
+			{
+				const char* begin = line.c_str() + position;
+				char* end;
+				double value = std::strtod(begin, &end);
+				position += end - begin;
+				return graph.Constant(value);
+			}
+
+			std::string name = Identifier();
+			if (Accept('('))
+				return ParseCall(name);
+			if (name == "t")
+				return graph.Load(Operation::Time, 0);
+			if (name == "pi")
+				return graph.Constant(3.14159265358979323846);
+			auto found = names.find(name);
+			if (found == names.end())
+				Fail(lineNumber, "nome desconhecido: " + name + ".");
+			return found->second;
+		}
+
+		int ParseCall(const std::string& name) {
+			static const std::map<std::string, Operation> unary = {
+				{ "sqrt", Operation::Sqrt }, { "exp", Operation::Exp },
+				{ "log", Operation::Log }, { "sin", Operation::Sin },
+				{ "cos", Operation::Cos }, { "tan", Operation::Tan },
+				{ "tanh", Operation::Tanh }, { "atan", Operation::Atan },
+				{ "abs", Operation::Abs } };
+			static const std::map<std::string, Operation> binary = {
+				{ "pow", Operation::Power }, { "min", Operation::Minimum },
+				{ "max", Operation::Maximum } };
+
+			auto found = unary.find(name);
+			if (found != unary.end()) {
+				int argument = ParseExpression();
+				Expect(')');
+				return graph.Unary(found->second, argument);
+			}
+			found = binary.find(name);
+			if (found != binary.end()) {
+				int first = ParseExpression();
+				Expect(',');
+				int second = ParseExpression();
+				Expect(')');
+				return graph.Binary(found->second, first, second);
+			}
+			Fail(lineNumber, "função desconhecida: " + name + ".");
+		}
+	};
+
+	/*
+		Operações elemento a elemento sobre Width sistemas. Os operandos são
+		lidos para vetores locais, pois o destino pode ser o mesmo registrador
+		de um dos operandos.
+	*/
+	template <std::size_t Width, typename Function>
+	inline void Unary(double* destination, const double* a, Function function) {
+		double result[Width];
+		for (std::size_t k = 0; k < Width; k++)
+			result[k] = function(a[k]);
+		for (std::size_t k = 0; k < Width; k++)
+			destination[k] = result[k];
+	}
+
+	template <std::size_t Width, typename Function>
+	inline void Binary(double* destination, const double* a, const double* b, Function function) {
+		double result[Width];
+		for (std::size_t k = 0; k < Width; k++)
+			result[k] = function(a[k], b[k]);
+		for (std::size_t k = 0; k < Width; k++)
+			destination[k] = result[k];
+	}
+}
+
+Expression::System::System(const std::string& source)
+{
+	Parser parser;
+	parser.ParseSource(source);
+	Graph& graph = parser.graph;
+	std::vector<Node>& nodes = graph.nodes;
+	stateNames = parser.stateNames;
+	parameterNames = parser.parameterNames;
+	parameters = parser.parameterValues;
+
+	/*
+		Valores utilizados pelas equações (os demais são descartados).
+	*/
+	std::vector<bool> live(nodes.size(), false);
+	std::vector<int> pending(parser.outputs.begin(), parser.outputs.end());
+	while (!pending.empty()) {
+		int id = pending.back();
+		pending.pop_back();
+		if (id < 0 || live[id])
+			continue;
+		live[id] = true;
+		pending.push_back(nodes[id].first);
+		pending.push_back(nodes[id].second);
+	}
+
+	/*
+		Ordem de execução: cada nó (já em ordem topológica, pois operandos
+		são criados antes) seguido da escrita das derivadas que o utilizam.
+		Derivadas iguais a constantes ou parâmetros são escritas no início.
+	*/
+	struct Step {
+		int node;
+		int store;
+	};
+	std::vector<Step> steps;
+	for (std::size_t i = 0; i < parser.outputs.size(); i++) {
+		if (IsPrologue(nodes[parser.outputs[i]].operation))
+			steps.push_back({ parser.outputs[i], static_cast<int>(i) });
+	}
+	for (std::size_t id = 0; id < nodes.size(); id++) {
+		if (!live[id] || IsPrologue(nodes[id].operation))
+			continue;
+		steps.push_back({ static_cast<int>(id), -1 });
+		for (std::size_t i = 0; i < parser.outputs.size(); i++) {
+			if (parser.outputs[i] == static_cast<int>(id))
+				steps.push_back({ static_cast<int>(id), static_cast<int>(i) });
+		}
+	}
+
+	/*
+		Última leitura de cada valor, para liberar seu registrador.
+	*/
+	std::vector<std::size_t> lastUse(nodes.size(), 0);
+	for (std::size_t s = 0; s < steps.size(); s++) {
+		if (steps[s].store >= 0) {
+			lastUse[steps[s].node] = s;
+		}
+		else {
+			const Node& node = nodes[steps[s].node];
+			if (node.first >= 0) lastUse[node.first] = s;
+			if (node.second >= 0) lastUse[node.second] = s;
+		}
+	}
+
+	/*
+		Registradores: os do prólogo são fixos, os demais são reutilizados.
+	*/
+	std::vector<std::uint32_t> registerOf(nodes.size(), 0);
+	std::vector<std::uint32_t> freeRegisters;
+	std::uint32_t nextRegister = 0;
+	for (std::size_t id = 0; id < nodes.size(); id++) {
+		if (!live[id] || !IsPrologue(nodes[id].operation))
+			continue;
+		registerOf[id] = nextRegister++;
+		Instruction instruction = { nodes[id].operation, registerOf[id], 0, 0, nodes[id].index, nodes[id].constant };
+		prologue.push_back(instruction);
+	}
+
+	auto release = [&](int id, std::size_t s) {
+		if (id >= 0 && !IsPrologue(nodes[id].operation) && lastUse[id] == s)
+			freeRegisters.push_back(registerOf[id]);
+	};
+
+	for (std::size_t s = 0; s < steps.size(); s++) {
+		int id = steps[s].node;
+		const Node& node = nodes[id];
+		if (steps[s].store >= 0) {
+			Instruction instruction = {
+				Operation::Store, 0, registerOf[id], 0,
+				static_cast<std::uint32_t>(steps[s].store), 0.0 };
+			body.push_back(instruction);
+			release(id, s);
+			continue;
+		}
+
+		Instruction instruction = {
+			node.operation, 0,
+			(node.first >= 0) ? registerOf[node.first] : 0,
+			(node.second >= 0) ? registerOf[node.second] : 0,
+			node.index, node.constant };
+		release(node.first, s);
+		if (node.second != node.first)
+			release(node.second, s);
+
+		if (freeRegisters.empty()) {
+			registerOf[id] = nextRegister++;
+		}
+		else {
+			registerOf[id] = freeRegisters.back();
+			freeRegisters.pop_back();
+		}
+		instruction.destination = registerOf[id];
+		body.push_back(instruction);
+	}
+
+	registerCount = std::max<std::uint32_t>(nextRegister, 1);
+	scalarRegisters.assign(registerCount, 0.0);
+	batchRegisters.assign(registerCount * BatchWidth, 0.0);
+}
+
+void Expression::System::SetParameter(const std::string& name, double value)
+{
+	auto found = std::find(parameterNames.begin(), parameterNames.end(), name);
+	if (found == parameterNames.end())
+		throw "Expression: parâmetro inexistente.";
+	parameters[found - parameterNames.begin()] = value;
+}
+
+std::string Expression::System::Disassemble() const
+{
+	std::ostringstream text;
+	auto write = [&](const Instruction& instruction) {
+		Operation operation = instruction.operation;
+		if (operation == Operation::Store) {
+			text << "store   dudt[" << instruction.index << "], r" << instruction.first << "\n";
+			return;
+		}
+		text << "r" << instruction.destination << " = " << OperationName(operation);
+		if (operation == Operation::Constant)
+			text << " " << instruction.constant;
+		else if (operation == Operation::Parameter)
+			text << " " << parameterNames[instruction.index];
+		else if (operation == Operation::State)
+			text << " " << stateNames[instruction.index];
+		else if (IsUnary(operation))
+			text << " r" << instruction.first;
+		else if (operation != Operation::Time)
+			text << " r" << instruction.first << ", r" << instruction.second;
+		text << "\n";
+	};
+	for (const Instruction& instruction : prologue)
+		write(instruction);
+	text << "----\n";
+	for (const Instruction& instruction : body)
+		write(instruction);
+	return text.str();
+}
+
+template <std::size_t Width>
+void Expression::System::RunPrologue(double t, std::vector<double>& registers) const
+{
+	for (const Instruction& instruction : prologue) {
+		double value =
+			(instruction.operation == Operation::Constant) ? instruction.constant :
+			(instruction.operation == Operation::Parameter) ? parameters[instruction.index] :
+			t;
+		double* destination = registers.data() + instruction.destination * Width;
+		for (std::size_t k = 0; k < Width; k++)
+			destination[k] = value;
+	}
+}
+
+template <std::size_t Width>
+void Expression::System::RunBody(
+	const double* u,
+	double* dudt,
+	std::size_t stride,
+	std::vector<double>& registers) const
+{
+	double* r = registers.data();
+	for (const Instruction& instruction : body) {
+		double* d = r + instruction.destination * Width;
+		const double* a = r + instruction.first * Width;
+		const double* b = r + instruction.second * Width;
+
+		switch (instruction.operation) {
+		case Operation::State: {
+			const double* source = u + instruction.index * stride;
+			for (std::size_t k = 0; k < Width; k++)
+				d[k] = source[k];
+			break;
+		}
+		case Operation::Store: {
+			double* target = dudt + instruction.index * stride;
+			for (std::size_t k = 0; k < Width; k++)
+				target[k] = a[k];
+			break;
+		}
+		case Operation::Add:
+			Binary<Width>(d, a, b, [](double x, double y) { return x + y; });
+			break;
+		case Operation::Subtract:
+			Binary<Width>(d, a, b, [](double x, double y) { return x - y; });
+			break;
+		case Operation::Multiply:
+			Binary<Width>(d, a, b, [](double x, double y) { return x * y; });
+			break;
+		case Operation::Divide:
+			Binary<Width>(d, a, b, [](double x, double y) { return x / y; });
+			break;
+		case Operation::Minimum:
+			Binary<Width>(d, a, b, [](double x, double y) { return std::min(x, y); });
+			break;
+		case Operation::Maximum:
+			Binary<Width>(d, a, b, [](double x, double y) { return std::max(x, y); });
+			break;
+		case Operation::Power:
+			Binary<Width>(d, a, b, [](double x, double y) { return std::pow(x, y); });
+			break;
+		case Operation::Negate:
+			Unary<Width>(d, a, [](double x) { return -x; });
+			break;
+		case Operation::Sqrt:
+			Unary<Width>(d, a, [](double x) { return std::sqrt(x); });
+			break;
+		case Operation::Abs:
+			Unary<Width>(d, a, [](double x) { return std::abs(x); });
+			break;
+		default:
+			Unary<Width>(d, a, [&instruction](double x) {
+				return Apply(instruction.operation, x, 0.0);
+			});
+			break;
+		}
+	}
+}
+
+void Expression::System::Evaluate(double t, const std::vector<double>& u, std::vector<double>& dudt)
+{
+	if (u.size() != StateSize() || dudt.size() != StateSize())
+		throw "Expression: tamanho de u ou dudt difere do sistema.";
+	RunPrologue<1>(t, scalarRegisters);
+	RunBody<1>(u.data(), dudt.data(), 1, scalarRegisters);
+}
+
+void Expression::System::EvaluateBatch(double t, const double* u, double* dudt, std::size_t count)
+{
+	std::size_t k = 0;
+	if (count >= BatchWidth) {
+		RunPrologue<BatchWidth>(t, batchRegisters);
+		for (; k + BatchWidth <= count; k += BatchWidth)
+			RunBody<BatchWidth>(u + k, dudt + k, count, batchRegisters);
+	}
+	if (k < count) {
+		RunPrologue<1>(t, scalarRegisters);
+		for (; k < count; k++)
+			RunBody<1>(u + k, dudt + k, count, scalarRegisters);
+	}
+}
+
+std::function<
+	void(double,
+		std::vector<double>&,
+		std::vector<double>&)
+> Expression::System::ToFunction() const
+{
+	std::shared_ptr<System> system = std::make_shared<System>(*this);
+	return [system](double t, std::vector<double>& u, std::vector<double>& dudt) {
+		system->Evaluate(t, u, dudt);
+	};
+}
+
+std::function<
+	void(double,
+		std::vector<double>&,
+		std::vector<double>&)
+> Expression::System::ToEnsembleFunction(std::size_t count) const
+{
+	std::shared_ptr<System> system = std::make_shared<System>(*this);
+	return [system, count](double t, std::vector<double>& u, std::vector<double>& dudt) {
+		if (u.size() != system->StateSize() * count || dudt.size() != u.size())
+			throw "Expression: tamanho de u ou dudt difere do conjunto de sistemas.";
+		system->EvaluateBatch(t, u.data(), dudt.data(), count);
+	};
+}
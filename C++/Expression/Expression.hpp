@@ -0,0 +1,201 @@
+/**
+* @file Expression.hpp
+* @brief Sistemas de EDO`s definidos em texto, compilados para bytecode
+*/
+
+/*
+	* Permite definir o lado direito de um sistema sem escrever (e compilar)
+	uma função em C++. Exemplo, equivalente ao sistema de Blasius de main.cpp:
+
+		# Comentários começam com '#'
+		state f, fp, fpp
+		parameter a = -1 / 2
+		f' = fp
+		fp' = fpp
+		fpp' = a * f * fpp
+
+	-> state: nomes das variáveis de estado, na ordem de u
+	-> parameter: parâmetros com valor inicial (alterável com SetParameter)
+	-> let: expressões intermediárias, por exemplo "let r = sqrt(x^2 + y^2)"
+	-> x' = ...: derivada de cada variável de estado (exatamente uma por
+	variável)
+	Expressões aceitam + - * / ^, parênteses, números, t, pi e as funções
+	sqrt, exp, log, sin, cos, tan, tanh, atan, abs, pow, min e max.
+
+	* O texto é compilado uma única vez para instruções sobre registradores
+	(bytecode):
+	-> Dobramento de constantes: operações sobre constantes são calculadas
+	na compilação, e apenas identidades exatas em ponto flutuante são
+	simplificadas: x * 1, x * -1 (-x), x - 0, x / 1, x ^ 0, x ^ 1,
+	x ^ 2 (x * x) e divisão por potência de 2 (multiplicação pelo inverso).
+	-> Eliminação de subexpressões comuns: cada operação com os mesmos
+	operandos é calculada uma única vez (somas e produtos são
+	normalizados quanto à ordem dos operandos), e expressões não utilizadas são descartadas.
+	-> Constantes, parâmetros e t ficam em registradores carregados uma vez
+	por chamada; registradores das demais instruções são reutilizados assim
+	que seus valores deixam de ser necessários.
+
+	* Cada instrução é aplicada a BatchWidth sistemas de uma vez
+	(EvaluateBatch), em laços de tamanho fixo que o compilador vetoriza: o
+	custo de interpretar a instrução é dividido entre os sistemas do lote.
+
+	* Erros de sintaxe lançam uma mensagem (const char*) com o número da
+	linha, válida até o próximo erro na mesma thread.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Expression {
+	/**
+	* @brief Operações do bytecode.
+	*/
+	enum class Operation : std::uint8_t {
+		// Carregamentos (constantes, parâmetros e t ficam no prólogo)
+		Constant, Parameter, Time, State,
+		// Escrita de dudt
+		Store,
+		// Aritmética
+		Add, Subtract, Multiply, Divide, Negate, Power, Minimum, Maximum,
+		// Funções elementares
+		Sqrt, Exp, Log, Sin, Cos, Tan, Tanh, Atan, Abs
+	};
+
+	/**
+	* @brief Instrução: destination = operation(first, second).
+	* index é a posição em u, dudt ou nos parâmetros, conforme a operação.
+	*/
+	struct Instruction {
+		Operation operation;
+		std::uint32_t destination;
+		std::uint32_t first;
+		std::uint32_t second;
+		std::uint32_t index;
+		double constant;
+	};
+
+	/**
+	* @brief Sistema de EDO`s compilado.
+	*/
+	class System {
+	public:
+		// Quantidade de sistemas avaliados por instrução em EvaluateBatch
+		static constexpr std::size_t BatchWidth = 16;
+
+		/**
+		* @brief Compila o sistema descrito em source.
+		* @param[in] source Texto do sistema (entrada)
+		*/
+		explicit System(const std::string& source);
+
+		/**
+		* @brief Quantidade de variáveis de estado.
+		*/
+		std::size_t StateSize() const { return stateNames.size(); }
+
+		/**
+		* @brief Nomes das variáveis de estado, na ordem de u.
+		*/
+		const std::vector<std::string>& StateNames() const { return stateNames; }
+
+		/**
+		* @brief Nomes dos parâmetros, na ordem de Parameters().
+		*/
+		const std::vector<std::string>& ParameterNames() const { return parameterNames; }
+
+		/**
+		* @brief Valores atuais dos parâmetros.
+		*/
+		std::vector<double>& Parameters() { return parameters; }
+		const std::vector<double>& Parameters() const { return parameters; }
+
+		/**
+		* @brief Altera o valor de um parâmetro.
+		* @param[in] name Nome do parâmetro (entrada)
+		* @param[in] value Novo valor (entrada)
+		*/
+		void SetParameter(const std::string& name, double value);
+
+		/**
+		* @brief Quantidade de instruções executadas por avaliação (sem o
+		* prólogo).
+		*/
+		std::size_t InstructionCount() const { return body.size(); }
+
+		/**
+		* @brief Quantidade de registradores utilizados.
+		*/
+		std::size_t RegisterCount() const { return registerCount; }
+
+		/**
+		* @brief Listagem legível do bytecode.
+		*/
+		std::string Disassemble() const;
+
+		/**
+		* @brief Avalia dudt = f(t, u) para um único sistema.
+		* Utiliza registradores internos: não deve ser chamada por várias
+		* threads no mesmo objeto.
+		* @param[in] t Valor de t (entrada)
+		* @param[in] u Valores de u (entrada)
+		* @param[out] dudt Derivadas (saída)
+		*/
+		void Evaluate(double t, const std::vector<double>& u, std::vector<double>& dudt);
+
+		/**
+		* @brief Avalia count sistemas independentes, no formato SoA: a
+		* variável i do sistema k está em u[i * count + k].
+		* @param[in] t Valor de t (entrada)
+		* @param[in] u Valores de u, com StateSize() * count valores (entrada)
+		* @param[out] dudt Derivadas, no mesmo formato (saída)
+		* @param[in] count Quantidade de sistemas (entrada)
+		*/
+		void EvaluateBatch(double t, const double* u, double* dudt, std::size_t count);
+
+		/**
+		* @brief Função no formato aceito por CashKarpRange, com uma cópia
+		* do sistema (alterações posteriores dos parâmetros não a afetam).
+		*/
+		std::function<
+			void(double,
+				std::vector<double>&,
+				std::vector<double>&)
+		> ToFunction() const;
+
+		/**
+		* @brief Função no formato aceito por CashKarpRange para um conjunto
+		* de count cópias independentes do sistema, no formato SoA de
+		* EvaluateBatch.
+		* @param[in] count Quantidade de sistemas (entrada)
+		*/
+		std::function<
+			void(double,
+				std::vector<double>&,
+				std::vector<double>&)
+		> ToEnsembleFunction(std::size_t count) const;
+
+	private:
+		template <std::size_t Width>
+		void RunPrologue(double t, std::vector<double>& registers) const;
+
+		template <std::size_t Width>
+		void RunBody(const double* u, double* dudt, std::size_t stride, std::vector<double>& registers) const;
+
+		std::vector<std::string> stateNames;
+		std::vector<std::string> parameterNames;
+		std::vector<double> parameters;
+		// Constantes, parâmetros e t: executado uma vez por chamada
+		std::vector<Instruction> prologue;
+		// Demais instruções: executado para cada lote
+		std::vector<Instruction> body;
+		std::size_t registerCount = 0;
+		// Registradores para um único sistema e para um lote
+		std::vector<double> scalarRegisters;
+		std::vector<double> batchRegisters;
+	};
+}
@@ -0,0 +1,229 @@
+/**
+* @file FixedStep.hpp
+* @brief Métodos de Runge-Kutta explícitos de passo constante
+*/
+
+/*
+	* Versão em C++ dos métodos de passo simples da pasta PassoConstante
+	(simple_step.m): Euler explícito, Heun, Ponto Médio, RK4 e Runge-Kutta de
+	Ralston. Em Octave o método é escolhido em tempo de execução (switch sobre
+	uma string e ponteiros para funções); aqui o método é um parâmetro de
+	template, de forma que os coeficientes da matriz de Butcher são conhecidos
+	pelo compilador e não há nenhum despacho em tempo de execução.
+
+	* Todos os vetores intermediários são alocados na construção de
+	Integrator. Como a quantidade de passos é conhecida, o custo de cada passo
+	é determinístico (sem rejeições e sem alocações), o que permite utilizar
+	esses métodos em laços de controle em tempo real.
+
+	* Por se tratar de templates, toda a implementação está neste arquivo.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace FixedStep {
+	/*
+		Cada método é descrito por sua matriz de Butcher:
+		-> stages: quantidade de estágios (chamadas à função por passo)
+		-> a: coeficientes dos estágios intermediários (triangular inferior)
+		-> b: pesos de cada estágio no valor final de u
+		-> c: fração do passo em t para cada estágio
+	*/
+
+	/**
+	* @brief Método de Euler explícito (primeira ordem).
+	*/
+	struct ExplicitEuler {
+		static constexpr std::size_t stages = 1;
+		static constexpr std::size_t order = 1;
+		static constexpr double a[stages][stages] = { { 0.0 } };
+		static constexpr double b[stages] = { 1.0 };
+		static constexpr double c[stages] = { 0.0 };
+	};
+
+	/**
+	* @brief Método de Heun (segunda ordem).
+	*/
+	struct HeunMethod {
+		static constexpr std::size_t stages = 2;
+		static constexpr std::size_t order = 2;
+		static constexpr double a[stages][stages] = {
+			{ 0.0, 0.0 },
+			{ 1.0, 0.0 } };
+		static constexpr double b[stages] = { 1.0 / 2.0, 1.0 / 2.0 };
+		static constexpr double c[stages] = { 0.0, 1.0 };
+	};
+
+	/**
+	* @brief Método do Ponto Médio (segunda ordem).
+	*/
+	struct MidpointMethod {
+		static constexpr std::size_t stages = 2;
+		static constexpr std::size_t order = 2;
+		static constexpr double a[stages][stages] = {
+			{ 0.0, 0.0 },
+			{ 1.0 / 2.0, 0.0 } };
+		static constexpr double b[stages] = { 0.0, 1.0 };
+		static constexpr double c[stages] = { 0.0, 1.0 / 2.0 };
+	};
+
+	/**
+	* @brief Método de Runge-Kutta clássico (quarta ordem).
+	*/
+	struct RungeKutta4 {
+		static constexpr std::size_t stages = 4;
+		static constexpr std::size_t order = 4;
+		static constexpr double a[stages][stages] = {
+			{ 0.0, 0.0, 0.0, 0.0 },
+			{ 1.0 / 2.0, 0.0, 0.0, 0.0 },
+			{ 0.0, 1.0 / 2.0, 0.0, 0.0 },
+			{ 0.0, 0.0, 1.0, 0.0 } };
+		static constexpr double b[stages] = {
+			1.0 / 6.0, 1.0 / 3.0, 1.0 / 3.0, 1.0 / 6.0 };
+		static constexpr double c[stages] = { 0.0, 1.0 / 2.0, 1.0 / 2.0, 1.0 };
+	};
+
+	/**
+	* @brief Método de Runge-Kutta de Ralston (quarta ordem, erro mínimo).
+	* Coeficientes exatos do artigo de Ralston (os de RungeKuttaRalstonStep.m
+	* estão truncados em 8 casas decimais).
+	*/
+	struct RungeKuttaRalston {
+		static constexpr std::size_t stages = 4;
+		static constexpr std::size_t order = 4;
+		static constexpr double a[stages][stages] = {
+			{ 0.0, 0.0, 0.0, 0.0 },
+			{ 0.4, 0.0, 0.0, 0.0 },
+			{ 0.29697760924775363, 0.15875964497103584, 0.0, 0.0 },
+			{ 0.21810038822592046, -3.050965148692931, 3.8328647604670105, 0.0 } };
+		static constexpr double b[stages] = {
+			0.17476028226269036, -0.55148066287873299,
+			1.2055355993965235, 0.17118478121951902 };
+		static constexpr double c[stages] = { 0.0, 0.4, 0.45573725421878941, 1.0 };
+	};
+
+	/**
+	* @brief Integrador de passo constante para o método Method.
+	* Todos os vetores intermediários são alocados no construtor.
+	*/
+	template <typename Method>
+	class Integrator {
+	public:
+		/**
+		* @brief Construtor
+		* @param[in] systemSize Quantidade de equações do sistema (entrada)
+		*/
+		explicit Integrator(std::size_t systemSize) :
+			systemSize(systemSize),
+			uStage(systemSize),
+			uCurrent(systemSize)
+		{
+			for (std::vector<double>& k : stageDerivatives)
+				k.resize(systemSize);
+		}
+
+		/**
+		* @brief Realiza um passo do método, atualizando u no próprio vetor.
+		* Não realiza alocações.
+		* @param[in] dynFun Função que calcula as derivadas de primeira ordem,
+		* com protótipo void(double, std::vector<double>&, std::vector<double>&)
+		* (entrada)
+		* @param[in] t Valor de t no início do passo (entrada)
+		* @param[in] stepSize Tamanho do passo (entrada)
+		* @param[in, out] u Valores de u (entrada e saída)
+		*/
+		template <typename DynamicFunction>
+		void Step(
+			DynamicFunction& dynFun,
+			double t,
+			double stepSize,
+			std::vector<double>& u)
+		{
+			std::size_t i, j, s;
+
+			dynFun(t, u, stageDerivatives[0]);
+
+			/*
+				Os laços sobre estágios têm limites constantes, portanto são
+				desenrolados pelo compilador, e os coeficientes nulos da matriz
+				de Butcher são eliminados.
+			*/
+			for (s = 1; s < Method::stages; s++) {
+				for (i = 0; i < systemSize; i++) {
+					double increment = 0.0;
+					for (j = 0; j < s; j++) {
+						if (Method::a[s][j] != 0.0)
+							increment += Method::a[s][j] * stageDerivatives[j][i];
+					}
+					uStage[i] = u[i] + stepSize * increment;
+				}
+				dynFun(t + Method::c[s] * stepSize, uStage, stageDerivatives[s]);
+			}
+
+			for (i = 0; i < systemSize; i++) {
+				double increment = 0.0;
+				for (j = 0; j < Method::stages; j++) {
+					if (Method::b[j] != 0.0)
+						increment += Method::b[j] * stageDerivatives[j][i];
+				}
+				u[i] += stepSize * increment;
+			}
+		}
+
+		/**
+		* @brief Integra o sistema em tSpan com numberOfSteps passos iguais.
+		* A trajetória é gravada em uValues de forma contígua, linha a linha:
+		* uValues[n * systemSize + i] é o valor de u[i] em
+		* t = tSpan.first + n * (tSpan.second - tSpan.first) / numberOfSteps.
+		* Se uValues já tiver o tamanho (numberOfSteps + 1) * systemSize, nenhuma
+		* alocação é realizada.
+		* @param[in] dynFun Função que calcula as derivadas (entrada)
+		* @param[in] uInitial Valores iniciais do sistema de EDO`s (entrada)
+		* @param[in] tSpan Intervalo de integração, com início e fim (entrada)
+		* @param[in] numberOfSteps Quantidade de passos (entrada)
+		* @param[out] uValues Trajetória, com numberOfSteps + 1 linhas (saída)
+		*/
+		template <typename DynamicFunction>
+		void Range(
+			DynamicFunction& dynFun,
+			std::vector<double>& uInitial,
+			std::pair<double, double>& tSpan,
+			std::size_t numberOfSteps,
+			std::vector<double>& uValues)
+		{
+			if (uInitial.size() != systemSize)
+				throw "FixedStep: uInitial difere da quantidade de equações do integrador.";
+			uValues.resize((numberOfSteps + 1) * systemSize);
+			double stepSize = (tSpan.second - tSpan.first) / numberOfSteps;
+
+			std::vector<double>& u = uCurrent;
+			std::copy(uInitial.begin(), uInitial.end(), u.begin());
+			std::copy(u.begin(), u.end(), uValues.begin());
+
+			for (std::size_t n = 0; n < numberOfSteps; n++) {
+				// t calculado a partir de n, evitando acúmulo de erros de soma
+				Step(dynFun, tSpan.first + n * stepSize, stepSize, u);
+				std::copy(u.begin(), u.end(), uValues.begin() + (n + 1) * systemSize);
+			}
+		}
+
+		/**
+		* @brief Quantidade de chamadas à função por passo.
+		*/
+		static constexpr std::size_t RhsEvaluationsPerStep() {
+			return Method::stages;
+		}
+
+	private:
+		std::size_t systemSize;
+		std::array<std::vector<double>, Method::stages> stageDerivatives;
+		std::vector<double> uStage;
+		std::vector<double> uCurrent;
+	};
+}
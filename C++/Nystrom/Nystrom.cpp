@@ -0,0 +1,239 @@
+/**
+* @file Nystrom.cpp
+* @brief Pares embutidos de Runge-Kutta-Nyström para sistemas de segunda ordem
+*/
+
+#include "Nystrom.hpp"
+#include "CashKarpStepControl.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	const std::size_t stages = 6;
+
+	/*
+		Quadro de Butcher de um par de Runge-Kutta-Nyström:
+			U_s = u + c_s h v + h^2 sum_j abar_sj K_j
+			V_s = v + h sum_j a_sj K_j
+			K_s = f(t + c_s h, U_s, V_s)
+			u_n+1 = u + h v + h^2 sum_s bbar_s K_s
+			v_n+1 = v + h sum_s b_s K_s
+		eBar e e são as diferenças entre os pesos das duas soluções, que dão
+		os erros estimados de u e de v.
+	*/
+	struct Tableau {
+		double c[stages];
+		double aBar[stages][stages];
+		double a[stages][stages];
+		double bBar[stages];
+		double b[stages];
+		double eBar[stages];
+		double e[stages];
+		// O último estágio é f(t + h, u_n+1): primeiro estágio do passo seguinte
+		bool firstSameAsLast;
+		// Os estágios dependem de V_s; caso contrário, V_s = v
+		bool usesVelocity;
+	};
+
+	const Tableau nystrom64 = {
+		{ 0.0, 1.0 / 5.0, 1.0 / 2.0, 17.0 / 22.0, 9.0 / 10.0, 1.0 },
+		{
+			{ 0.0 },
+			{ 1.0 / 50.0 },
+			{ -1.0 / 248.0, 4.0 / 31.0 },
+			{ 2006.0 / 14641.0, 5355.0 / 117128.0, 6783.0 / 58564.0 },
+			{ -11313.0 / 85000.0, 427.0 / 900.0, 28.0 / 1875.0, 9317.0 / 191250.0 },
+			{ 19.0 / 306.0, 925.0 / 3969.0, 31.0 / 216.0, 14641.0 / 269892.0, 25.0 / 3528.0 }
+		},
+		{ { 0.0 } },
+		{ 19.0 / 306.0, 925.0 / 3969.0, 31.0 / 216.0, 14641.0 / 269892.0, 25.0 / 3528.0, 0.0 },
+		{ 19.0 / 306.0, 4625.0 / 15876.0, 31.0 / 108.0, 161051.0 / 674730.0, 125.0 / 1764.0, 1.0 / 20.0 },
+		{ -65.0 / 1683.0, 3700.0 / 43659.0, -155.0 / 2376.0, 3245.0 / 269892.0, 25.0 / 3528.0, 0.0 },
+		{ -65.0 / 1683.0, 4625.0 / 43659.0, -155.0 / 1188.0, 7139.0 / 134946.0, 125.0 / 1764.0, -2.0 / 33.0 },
+		true,
+		false
+	};
+
+	const Tableau cashKarp54 = {
+		{ 0.0, 1.0 / 5.0, 3.0 / 10.0, 3.0 / 5.0, 1.0, 7.0 / 8.0 },
+		{
+			{ 0.0 },
+			{ 0.0 },
+			{ 9.0 / 200.0, 0.0 },
+			{ -9.0 / 100.0, 27.0 / 100.0, 0.0 },
+			{ 25.0 / 36.0, -7.0 / 4.0, 14.0 / 9.0, 0.0 },
+			{ 4949.0 / 27648.0, -805.0 / 4096.0, 8855.0 / 27648.0, 8855.0 / 110592.0, 0.0 }
+		},
+		{
+			{ 0.0 },
+			{ 1.0 / 5.0 },
+			{ 3.0 / 40.0, 9.0 / 40.0 },
+			{ 3.0 / 10.0, -9.0 / 10.0, 6.0 / 5.0 },
+			{ -11.0 / 54.0, 5.0 / 2.0, -70.0 / 27.0, 35.0 / 27.0 },
+			{ 1631.0 / 55296.0, 175.0 / 512.0, 575.0 / 13824.0, 44275.0 / 110592.0, 253.0 / 4096.0 }
+		},
+		{ 11.0 / 108.0, 0.0, 50.0 / 189.0, 25.0 / 216.0, 1.0 / 56.0, 0.0 },
+		{ 37.0 / 378.0, 0.0, 250.0 / 621.0, 125.0 / 594.0, 0.0, 512.0 / 1771.0 },
+		{ -277.0 / 73728.0, 0.0, 1385.0 / 129024.0, -1385.0 / 147456.0, 277.0 / 114688.0, 0.0 },
+		{ -277.0 / 64512.0, 0.0, 6925.0 / 370944.0, -6925.0 / 202752.0, -277.0 / 14336.0, 277.0 / 7084.0 },
+		false,
+		true
+	};
+
+	/*
+		Memória de um passo: estágios, ponto intermediário e resultado.
+	*/
+	struct Workspace {
+		std::vector<std::vector<double>> k;
+		std::vector<double> uStage, vStage;
+		std::vector<double> uOutput, vOutput;
+		std::vector<double> uError, vError;
+	};
+
+	/*
+		Uma tentativa de passo a partir de (t, u, v), com k[0] = f(t, u, v)
+		já calculado. stages - 1 chamadas a dynFun.
+	*/
+	void NystromStep(
+		const Tableau& tableau,
+		double t,
+		double h,
+		std::vector<double>& u,
+		std::vector<double>& v,
+		Workspace& work,
+		Nystrom::SecondOrderFunction& dynFun)
+	{
+		std::size_t i, j, s, uSize = u.size();
+		double h2 = h * h;
+
+		for (s = 1; s < stages; s++) {
+			for (i = 0; i < uSize; i++) {
+				double position = 0.0, velocity = 0.0;
+				for (j = 0; j < s; j++) {
+					position += tableau.aBar[s][j] * work.k[j][i];
+					velocity += tableau.a[s][j] * work.k[j][i];
+				}
+				work.uStage[i] = u[i] + tableau.c[s] * h * v[i] + h2 * position;
+				work.vStage[i] = tableau.usesVelocity ? v[i] + h * velocity : v[i];
+			}
+			dynFun(t + tableau.c[s] * h, work.uStage, work.vStage, work.k[s]);
+		}
+
+		for (i = 0; i < uSize; i++) {
+			double position = 0.0, velocity = 0.0;
+			double positionError = 0.0, velocityError = 0.0;
+			for (s = 0; s < stages; s++) {
+				position += tableau.bBar[s] * work.k[s][i];
+				velocity += tableau.b[s] * work.k[s][i];
+				positionError += tableau.eBar[s] * work.k[s][i];
+				velocityError += tableau.e[s] * work.k[s][i];
+			}
+			work.uOutput[i] = u[i] + h * v[i] + h2 * position;
+			work.vOutput[i] = v[i] + h * velocity;
+			work.uError[i] = h2 * positionError;
+			work.vError[i] = h * velocityError;
+		}
+	}
+}
+
+CashKarp::IntegrationStatistics Nystrom::NystromRange(
+	std::vector<double>& uInitial,
+	std::vector<double>& vInitial,
+	std::pair<double, double>& tSpan,
+	double tolerance,
+	double initialStep,
+	double minimumStep,
+	std::size_t maximumNumberOfSteps,
+	SecondOrderFunction& dynFun,
+	StepObserver& stepObserver,
+	Method method)
+{
+	static const CashKarp::StepControl<double> stepControl(4);
+	const Tableau& tableau = (method == Method::Nystrom64) ? nystrom64 : cashKarp54;
+
+	std::size_t i, uSize = uInitial.size();
+	if (vInitial.size() != uSize)
+		throw "NystromRange: u e v devem ter o mesmo tamanho.";
+
+	Workspace work;
+	work.k.assign(stages, std::vector<double>(uSize));
+	work.uStage.resize(uSize);
+	work.vStage.resize(uSize);
+	work.uOutput.resize(uSize);
+	work.vOutput.resize(uSize);
+	work.uError.resize(uSize);
+	work.vError.resize(uSize);
+
+	std::vector<double> u = uInitial, v = vInitial;
+	std::vector<double> uScaled(uSize), vScaled(uSize);
+	CashKarp::IntegrationStatistics statistics;
+
+	double t = tSpan.first;
+	double stepSize =
+		(tSpan.second - tSpan.first >= 0.0)
+		? std::abs(initialStep)
+		: -std::abs(initialStep);
+	bool firstStageReady = false;
+
+	stepObserver(t, u, v);
+
+	for (std::size_t step = 0; step <= maximumNumberOfSteps; step++)
+	{
+		if (!firstStageReady) {
+			dynFun(t, u, v, work.k[0]);
+			statistics.rhsEvaluations++;
+		}
+
+		double tNext = t + stepSize;
+		if ((tNext - tSpan.second) * (tNext - tSpan.first) > 0.0)
+			stepSize = tSpan.second - t;
+
+		/*
+			Tentativas até que o maior erro de u e de v fique abaixo da
+			tolerância.
+		*/
+		double maximumError;
+		while (true)
+		{
+			for (i = 0; i < uSize; i++) {
+				uScaled[i] = std::abs(u[i]) + std::abs(v[i] * stepSize) + 1.0e-30;
+				vScaled[i] = std::abs(v[i]) + std::abs(work.k[0][i] * stepSize) + 1.0e-30;
+			}
+
+			NystromStep(tableau, t, stepSize, u, v, work, dynFun);
+			statistics.rhsEvaluations += stages - 1;
+
+			maximumError = std::max(
+				stepControl.MaximumError(work.uError.data(), uScaled.data(), work.uOutput.data(), uSize),
+				stepControl.MaximumError(work.vError.data(), vScaled.data(), work.vOutput.data(), uSize));
+			maximumError /= tolerance;
+			if (maximumError <= 1.0)
+				break;
+
+			statistics.rejectedSteps++;
+			stepSize = stepControl.RejectedStepSize(stepSize, maximumError);
+			if (t + stepSize == t)
+				throw "Mathematical error: step size is equal to zero.";
+		}
+
+		/*
+			Passo aceito. No par FSAL, o último estágio já é f(t + h, u_n+1).
+		*/
+		statistics.AcceptStep(stepSize);
+		t += stepSize;
+		u.swap(work.uOutput);
+		v.swap(work.vOutput);
+		firstStageReady = tableau.firstSameAsLast;
+		if (firstStageReady)
+			work.k[0].swap(work.k[stages - 1]);
+
+		stepObserver(t, u, v);
+
+		if ((t - tSpan.second) * (tSpan.second - tSpan.first) >= 0.0)
+			break;
+
+		stepSize = stepControl.NextStepSize(stepSize, maximumError);
+	}
+
+	return statistics;
+}
@@ -0,0 +1,102 @@
+/**
+* @file Nystrom.hpp
+* @brief Pares embutidos de Runge-Kutta-Nyström para sistemas de segunda ordem
+*/
+
+/*
+	* Sistemas mecânicos u'' = f(t, u, u') costumam ser reescritos como
+	(u, v)' = (v, f) e integrados por CashKarpRange, com o dobro de
+	variáveis. Os métodos de Runge-Kutta-Nyström integram u e v = u'
+	diretamente: cada estágio avalia apenas f, e a posição é obtida com
+	pesos próprios (termos em h^2), em vez de integrar v como mais uma
+	equação.
+
+	* Nystrom64: par 6(4) para u'' = f(t, u), em que f não depende de u',
+	com 6 estágios, o último em (t + h, u_n+1): é o primeiro estágio do passo
+	seguinte (FSAL), logo cada passo aceito custa 5 chamadas a dynFun, contra
+	6 de Cash-Karp, com ordem 6 em vez de 5. Os coeficientes são racionais,
+	obtidos das condições de ordem para árvores de Nyström com as hipóteses
+	simplificadoras de Dormand, El-Mikkawy e Prince (1987):
+		sum_j abar_ij = c_i^2 / 2,  sum_i b_i abar_ij = b_j (1 - c_j)^2 / 2,
+		bbar_i = b_i (1 - c_i)
+	com c = (0, 1/5, 1/2, 17/22, 9/10, 1). A solução embutida tem ordem 4.
+
+	* CashKarp54: o próprio método de Cash-Karp escrito na forma de Nyström
+	(abar = A^2, bbar = b A), para u'' = f(t, u, u') geral. Produz a mesma
+	solução de CashKarpRange sobre (u, v), com metade das operações
+	vetoriais, e estima o erro de u e de v.
+
+	* O controle de passo é o de CashKarpQualityStep (CashKarpStepControl.hpp),
+	com o erro medido em u e em v, cada um relativo a |valor| + |h * derivada|.
+	As estatísticas são sempre preenchidas, independentemente de
+	CASHKARP_STATISTICS.
+
+	* Arquivo de cabeçalho, não contém implementações.
+*/
+
+#pragma once
+
+#include "CashKarp.hpp"
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace Nystrom {
+	/**
+	* @brief Sistema de segunda ordem: void(t, u, v, d2udt2), com v = du/dt.
+	*/
+	using SecondOrderFunction = std::function<
+		void(double,
+			std::vector<double>&,
+			std::vector<double>&,
+			std::vector<double>&)>;
+
+	/**
+	* @brief Observador de passos: void(t, u, v).
+	*/
+	using StepObserver = std::function<
+		void(double,
+			std::vector<double>&,
+			std::vector<double>&)>;
+
+	/**
+	* @brief Par embutido utilizado.
+	*/
+	enum class Method {
+		// Ordem 6(4), FSAL, apenas para f independente de u'
+		Nystrom64,
+		// Cash-Karp 5(4) na forma de Nyström, para qualquer f(t, u, u')
+		CashKarp54
+	};
+
+	/**
+	* @brief Rotina que integra u'' = f(t, u, u') em um intervalo por um par
+	* de Runge-Kutta-Nyström, entregando cada passo aceito a uma função.
+	* @param[in] uInitial Valores iniciais de u (entrada)
+	* @param[in] vInitial Valores iniciais de du/dt (entrada)
+	* @param[in] tSpan Intervalo de integração, com início e fim (entrada)
+	* @param[in] tolerance Tolerância aceita pelo algoritmo (entrada)
+	* @param[in] initialStep Passo inicial (entrada)
+	* @param[in] minimumStep Passo mínimo, atualmente não implementado (entrada)
+	* @param[in] maximumNumberOfSteps Quantidade máxima de iterações (entrada)
+	* @param[in] dynFun Função que calcula d2u/dt2 (entrada)
+	* @param[in] stepObserver Função chamada com t, u e v no ponto inicial e
+	* após cada passo aceito (entrada)
+	* @param[in] method Par embutido utilizado, sem valor padrão: Nystrom64
+	* ignora a dependência de f em u', e a escolha cabe a quem conhece o
+	* sistema (entrada)
+	* @return Estatísticas da integração
+	*/
+	CashKarp::IntegrationStatistics NystromRange(
+		std::vector<double>& uInitial,
+		std::vector<double>& vInitial,
+		std::pair<double, double>& tSpan,
+		double tolerance,
+		double initialStep,
+		double minimumStep,
+		std::size_t maximumNumberOfSteps,
+		SecondOrderFunction& dynFun,
+		StepObserver& stepObserver,
+		Method method);
+}
@@ -0,0 +1,258 @@
+/**
+* @file Parareal.cpp
+* @brief Algoritmo Parareal (paralelismo no tempo) em torno de CashKarpRange
+*/
+
+#include "Parareal.hpp"
+#include "CashKarp.hpp"
+#include "FixedStep.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <thread>
+
+namespace {
+	using DynamicFunction = std::function<
+		void(
+			double,
+			std::vector<double>&,
+			std::vector<double>&)>;
+
+	double Seconds(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - start).count();
+	}
+
+	bool IsFinite(const std::vector<double>& u) {
+		for (double value : u) {
+			if (!std::isfinite(value))
+				return false;
+		}
+		return true;
+	}
+
+	/*
+		Propagador grosseiro G: leva u de tStart a tEnd. Se u não for finito
+		ou o propagador falhar, o resultado é NaN: uma previsão inútil, que
+		PararealRange descarta, mas não um erro.
+	*/
+	void Coarse(
+		const Parareal::PararealOptions& options,
+		DynamicFunction& dynFun,
+		double tStart,
+		double tEnd,
+		std::vector<double>& u,
+		std::vector<double>& trajectory)
+	{
+		std::pair<double, double> tSpan(tStart, tEnd);
+		if (!IsFinite(u)) {
+			std::fill(u.begin(), u.end(), NAN);
+			return;
+		}
+		if (options.coarse == Parareal::CoarsePropagator::RungeKutta4) {
+			FixedStep::Integrator<FixedStep::RungeKutta4> integrator(u.size());
+			integrator.Range(dynFun, u, tSpan, options.coarseSteps, trajectory);
+			std::copy(trajectory.end() - u.size(), trajectory.end(), u.begin());
+		}
+		else {
+			std::function<void(double, std::vector<double>&)> lastState =
+				[&u](double t, std::vector<double>& uStep) {
+					u = uStep;
+				};
+			std::vector<double> uStart = u;
+			try {
+				CashKarp::CashKarpRange(
+					uStart, tSpan, options.coarseTolerance,
+					(tEnd - tStart) / 10.0, 0.0, 1000000, dynFun, lastState);
+			}
+			catch (const char*) {
+				std::fill(u.begin(), u.end(), NAN);
+			}
+		}
+	}
+
+	/*
+		Maior diferença entre dois estados, relativa ao valor quando este
+		for maior que 1. Valores não finitos (propagador grosseiro instável)
+		resultam em correção infinita, nunca em convergência.
+	*/
+	double Correction(const std::vector<double>& uNew, const std::vector<double>& uOld) {
+		double correction = 0.0;
+		for (std::size_t i = 0; i < uNew.size(); i++) {
+			double scale = std::max(1.0, std::abs(uNew[i]));
+			double difference = std::abs(uNew[i] - uOld[i]) / scale;
+			if (!std::isfinite(difference))
+				return INFINITY;
+			correction = std::max(correction, difference);
+		}
+		return correction;
+	}
+}
+
+Parareal::PararealResult Parareal::PararealRange(
+	std::vector<double>& uInitial,
+	std::pair<double, double>& tSpan,
+	double tolerance,
+	double initialStep,
+	std::size_t maximumNumberOfSteps,
+	std::function<
+	void(
+		double,
+		std::vector<double>&,
+		std::vector<double>&)
+	>& dynFun,
+	const PararealOptions& options)
+{
+	if (options.slices == 0)
+		throw "Parareal: a quantidade de fatias deve ser positiva.";
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::size_t slices = options.slices;
+	std::size_t uSize = uInitial.size();
+	std::size_t threads = options.threads;
+	if (threads == 0)
+		threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+
+	PararealResult result;
+	result.tBoundaries.resize(slices + 1);
+	for (std::size_t n = 0; n <= slices; n++) {
+		result.tBoundaries[n] =
+			tSpan.first + (tSpan.second - tSpan.first) * n / slices;
+	}
+	result.tBoundaries[slices] = tSpan.second;
+	std::vector<double>& tBoundaries = result.tBoundaries;
+	std::vector<std::vector<double>>& U = result.uBoundaries;
+
+	/*
+		G[n] = G(U[n]) e F[n] = F(U[n]), valores propagados até o final
+		da fatia n.
+	*/
+	std::vector<std::vector<double>> G(slices, std::vector<double>(uSize));
+	std::vector<std::vector<double>> F(slices, std::vector<double>(uSize));
+	std::vector<double> sliceSeconds(slices, 0.0);
+	std::vector<std::size_t> sliceSteps(slices, 0);
+	std::vector<double> trajectory;
+
+	/*
+		Iteração zero: propagação grosseira sequencial.
+	*/
+	std::chrono::steady_clock::time_point coarseStart = std::chrono::steady_clock::now();
+	U.assign(slices + 1, uInitial);
+	for (std::size_t n = 0; n < slices; n++) {
+		G[n] = U[n];
+		Coarse(options, dynFun, tBoundaries[n], tBoundaries[n + 1], G[n], trajectory);
+		U[n + 1] = G[n];
+	}
+	result.criticalPathSeconds += Seconds(coarseStart);
+
+	std::size_t maximumIterations = std::min(options.maximumIterations, slices);
+	for (std::size_t k = 0; k < maximumIterations; k++) {
+		/*
+			Propagação fina das fatias k, ..., N-1 em paralelo (as fatias
+			anteriores já são exatas). Cada thread retira a próxima fatia de
+			um contador atômico.
+		*/
+		std::atomic<std::size_t> nextSlice(k);
+		std::atomic<bool> failed(false);
+		std::exception_ptr failure;
+		auto worker = [&]() {
+			std::function<void(double, std::vector<double>&)> observer;
+			std::size_t n;
+			while (!failed && (n = nextSlice++) < slices) {
+				std::chrono::steady_clock::time_point sliceStart =
+					std::chrono::steady_clock::now();
+				std::pair<double, double> sliceSpan(tBoundaries[n], tBoundaries[n + 1]);
+				std::size_t steps = 0;
+				double tLast = sliceSpan.first;
+				observer = [&F, &steps, &tLast, n](double t, std::vector<double>& u) {
+					F[n] = u;
+					tLast = t;
+					steps++;
+				};
+
+				/*
+					Início não finito (previsão grosseira instável): a fatia
+					não é propagada e F[n] fica não finito. A fatia k sempre
+					começa de um valor fino, logo cada iteração avança ao
+					menos uma fatia.
+				*/
+				if (!IsFinite(U[n])) {
+					std::fill(F[n].begin(), F[n].end(), NAN);
+					sliceSteps[n] = 0;
+					sliceSeconds[n] = Seconds(sliceStart);
+					continue;
+				}
+
+				try {
+					CashKarp::CashKarpRange(
+						U[n], sliceSpan, tolerance, initialStep, 0.0,
+						maximumNumberOfSteps, dynFun, observer);
+					if ((tLast - sliceSpan.second) * (sliceSpan.second - sliceSpan.first) < 0.0)
+						throw "Parareal: uma fatia atingiu maximumNumberOfSteps antes do fim.";
+				}
+				catch (...) {
+					/*
+						Só a fatia k parte de um valor fino; nas demais, a falha
+						pode vir de uma previsão grosseira absurda, e F[n] fica
+						não finito, como acima.
+					*/
+					if (n > k)
+						std::fill(F[n].begin(), F[n].end(), NAN);
+					else if (!failed.exchange(true))
+						failure = std::current_exception();
+				}
+				sliceSteps[n] = (steps > 0) ? steps - 1 : 0;
+				sliceSeconds[n] = Seconds(sliceStart);
+			}
+		};
+
+		std::size_t workers = std::min(threads, slices - k);
+		std::vector<std::thread> pool;
+		for (std::size_t w = 1; w < workers; w++)
+			pool.emplace_back(worker);
+		worker();
+		for (std::thread& thread : pool)
+			thread.join();
+		if (failed)
+			std::rethrow_exception(failure);
+
+		for (std::size_t n = k; n < slices; n++)
+			result.fineSteps += sliceSteps[n];
+		result.criticalPathSeconds +=
+			*std::max_element(sliceSeconds.begin() + k, sliceSeconds.end());
+
+		/*
+			Correção sequencial. A fatia k recebe diretamente o valor fino.
+		*/
+		coarseStart = std::chrono::steady_clock::now();
+		double correction = Correction(F[k], U[k + 1]);
+		U[k + 1] = F[k];
+		std::vector<double> uCoarse(uSize);
+		for (std::size_t n = k + 1; n < slices; n++) {
+			uCoarse = U[n];
+			Coarse(options, dynFun, tBoundaries[n], tBoundaries[n + 1], uCoarse, trajectory);
+			std::vector<double> uNew(uSize);
+			for (std::size_t i = 0; i < uSize; i++)
+				uNew[i] = uCoarse[i] + F[n][i] - G[n][i];
+			// Correção não finita: o valor fino da fatia é a melhor estimativa
+			if (!IsFinite(uNew) && IsFinite(F[n]))
+				uNew = F[n];
+			correction = std::max(correction, Correction(uNew, U[n + 1]));
+			G[n] = uCoarse;
+			U[n + 1] = uNew;
+		}
+		result.criticalPathSeconds += Seconds(coarseStart);
+
+		result.iterations = k + 1;
+		result.correction = correction;
+		if (correction <= options.convergenceTolerance || k + 1 == slices) {
+			result.converged = true;
+			break;
+		}
+	}
+
+	result.wallSeconds = Seconds(start);
+	return result;
+}
@@ -0,0 +1,122 @@
+/**
+* @file Parareal.hpp
+* @brief Algoritmo Parareal (paralelismo no tempo) em torno de CashKarpRange
+*/
+
+/*
+	* Uma integração longa é sequencial por natureza: cada passo depende do
+	anterior. O algoritmo Parareal (Lions, Maday e Turinici, 2001) divide
+	tSpan em N fatias e utiliza dois propagadores:
+	-> G (grosseiro): barato e impreciso (RK4 com poucos passos por fatia, ou
+	CashKarpRange com tolerância alta), executado sequencialmente
+	-> F (fino): CashKarpRange com a tolerância desejada, executado em
+	paralelo, uma fatia por thread
+
+	* A cada iteração k, os valores nas fronteiras das fatias são corrigidos:
+		U[n+1] = G(U[n]) + F(U_antigo[n]) - G(U_antigo[n])
+	Após k iterações as k primeiras fatias são exatas (iguais à integração
+	sequencial com F), portanto o algoritmo converge em no máximo N
+	iterações; na prática, para problemas bem comportados, em poucas.
+
+	* O ganho de tempo só existe se houver núcleos disponíveis e se o número
+	de iterações for bem menor que N. O campo criticalPathSeconds do resultado
+	estima o tempo com um núcleo por fatia, mesmo em máquinas com menos
+	núcleos.
+
+	* dynFun é chamada simultaneamente por várias threads, portanto não deve
+	alterar estados compartilhados.
+
+	* Arquivo de cabeçalho, não contém implementações.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace Parareal {
+	/**
+	* @brief Propagador grosseiro utilizado pelo Parareal.
+	*/
+	enum class CoarsePropagator {
+		// RK4 de passo constante (FixedStep), com coarseSteps passos por fatia
+		RungeKutta4,
+		// CashKarpRange com tolerância coarseTolerance
+		CashKarp
+	};
+
+	/**
+	* @brief Parâmetros do algoritmo.
+	*/
+	struct PararealOptions {
+		// Quantidade de fatias de tSpan
+		std::size_t slices = 8;
+		// Quantidade de threads (0: uma por núcleo disponível)
+		std::size_t threads = 0;
+		// Quantidade máxima de iterações (limitada a slices)
+		std::size_t maximumIterations = 10;
+		// Maior correção (relativa) nas fronteiras para considerar convergido
+		double convergenceTolerance = 1e-8;
+		CoarsePropagator coarse = CoarsePropagator::RungeKutta4;
+		// Passos por fatia do propagador RungeKutta4
+		std::size_t coarseSteps = 10;
+		// Tolerância do propagador CashKarp
+		double coarseTolerance = 1e-3;
+	};
+
+	/**
+	* @brief Resultado do algoritmo.
+	*/
+	struct PararealResult {
+		// Valores de t nas fronteiras das fatias (slices + 1 valores)
+		std::vector<double> tBoundaries;
+		// Valores de u nas fronteiras; o último é a solução em tSpan.second
+		std::vector<std::vector<double>> uBoundaries;
+		// Iterações realizadas
+		std::size_t iterations = 0;
+		// Maior correção relativa da última iteração
+		double correction = 0.0;
+		// Indica se a correção ficou abaixo de convergenceTolerance, ou se
+		// foram realizadas slices iterações (solução igual à sequencial)
+		bool converged = false;
+		// Passos aceitos pelo propagador fino, somando todas as fatias e iterações
+		std::size_t fineSteps = 0;
+		// Tempo real total
+		double wallSeconds = 0.0;
+		// Tempo estimado com um núcleo por fatia: soma, em cada iteração, da
+		// fatia fina mais lenta e das propagações grosseiras
+		double criticalPathSeconds = 0.0;
+	};
+
+	/**
+	* @brief Integra o sistema em tSpan pelo algoritmo Parareal.
+	* @param[in] uInitial Valores iniciais do sistema de EDO`s (entrada)
+	* @param[in] tSpan Intervalo de integração, com início e fim (entrada)
+	* @param[in] tolerance Tolerância do propagador fino (entrada)
+	* @param[in] initialStep Passo inicial do propagador fino (entrada)
+	* @param[in] maximumNumberOfSteps Quantidade máxima de passos por fatia;
+	* se a fatia que parte de um valor fino não chegar ao fim, a integração
+	* é interrompida com erro (entrada)
+	* @param[in] dynFun Função que calcula as derivadas, chamada por várias
+	* threads ao mesmo tempo (entrada)
+	* @param[in] options Parâmetros do algoritmo (entrada)
+	* @return Valores nas fronteiras das fatias e informações de convergência.
+	* Previsões grosseiras não finitas não são propagadas: a fronteira
+	* seguinte recebe o valor fino da fatia, quando houver.
+	*/
+	PararealResult PararealRange(
+		std::vector<double>& uInitial,
+		std::pair<double, double>& tSpan,
+		double tolerance,
+		double initialStep,
+		std::size_t maximumNumberOfSteps,
+		std::function<
+		void(
+			double,
+			std::vector<double>&,
+			std::vector<double>&)
+		>& dynFun,
+		const PararealOptions& options = PararealOptions());
+}
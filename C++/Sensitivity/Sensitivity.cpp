@@ -0,0 +1,124 @@
+/**
+* @file Sensitivity.cpp
+* @brief Análise de sensibilidade direta em relação a parâmetros
+*/
+
+#include "Sensitivity.hpp"
+#include <algorithm>
+#include <cmath>
+
+CashKarp::IntegrationStatistics Sensitivity::SensitivityRange(
+	std::vector<double>& uInitial,
+	std::vector<double>& sensitivityInitial,
+	std::vector<double>& parameters,
+	std::pair<double, double>& tSpan,
+	double tolerance,
+	double initialStep,
+	double minimumStep,
+	std::size_t maximumNumberOfSteps,
+	ParametricFunction& dynFun,
+	std::function<
+	void(double,
+		std::vector<double>&,
+		std::vector<double>&)
+	>& stepObserver,
+	SensitivityFunction& sensitivityFun)
+{
+	std::size_t uSize = uInitial.size();
+	std::size_t parameterSize = parameters.size();
+	std::size_t sensitivitySize = uSize * parameterSize;
+
+	if (!sensitivityInitial.empty() && sensitivityInitial.size() != sensitivitySize)
+		throw "Sensitivity: sensitivityInitial deve ter N * P valores.";
+
+	/*
+		Sistema aumentado: [u, s_1, ..., s_P].
+	*/
+	std::vector<double> augmentedInitial(uSize + sensitivitySize, 0.0);
+	std::copy(uInitial.begin(), uInitial.end(), augmentedInitial.begin());
+	std::copy(sensitivityInitial.begin(), sensitivityInitial.end(), augmentedInitial.begin() + uSize);
+
+	/*
+		Vetores de trabalho, alocados uma única vez.
+	*/
+	std::vector<double> u(uSize), dudt(uSize);
+	std::vector<double> sensitivities(sensitivitySize), dSdt(sensitivitySize);
+
+	std::function<void(double, std::vector<double>&, std::vector<double>&)> augmentedFun =
+		[&](double t, std::vector<double>& z, std::vector<double>& dzdt) {
+			std::copy(z.begin(), z.begin() + uSize, u.begin());
+			dynFun(t, u, parameters, dudt);
+			std::copy(dudt.begin(), dudt.end(), dzdt.begin());
+
+			std::copy(z.begin() + uSize, z.end(), sensitivities.begin());
+			sensitivityFun(t, u, parameters, dudt, sensitivities, dSdt);
+			std::copy(dSdt.begin(), dSdt.end(), dzdt.begin() + uSize);
+		};
+
+	/*
+		Laço de CashKarpRange, com uma escala de erro própria para as
+		sensibilidades. Sensibilidades nulas (por exemplo, no instante
+		inicial) teriam escala quase nula e o passo seria reduzido
+		indefinidamente; a escala de s_ij recebe então um piso igual à escala
+		de u_i dividida por |p_j|, ou seja, o erro de s_j é medido em relação à
+		variação de u causada por uma variação de p_j da ordem do próprio p_j.
+	*/
+	std::size_t i, augmentedSize = uSize + sensitivitySize;
+	std::vector<double> z = augmentedInitial;
+	std::vector<double> dzdt(augmentedSize), zScaled(augmentedSize);
+	std::vector<double> uObserved(uSize), sensitivitiesObserved(sensitivitySize);
+	CashKarp::IntegrationStatistics statistics;
+#if CASHKARP_STATISTICS
+	CashKarp::IntegrationStatistics* statisticsPointer = &statistics;
+#else
+	CashKarp::IntegrationStatistics* statisticsPointer = nullptr;
+#endif
+
+	auto observe = [&](double t) {
+		std::copy(z.begin(), z.begin() + uSize, uObserved.begin());
+		std::copy(z.begin() + uSize, z.end(), sensitivitiesObserved.begin());
+		stepObserver(t, uObserved, sensitivitiesObserved);
+	};
+
+	double t = tSpan.first;
+	double stepSize =
+		(tSpan.second - tSpan.first >= 0.0)
+		? std::abs(initialStep)
+		: -std::abs(initialStep);
+	double previousStepSize = 0.0, nextStepSize;
+
+	observe(t);
+
+	for (std::size_t step = 0; step <= maximumNumberOfSteps; step++)
+	{
+		augmentedFun(t, z, dzdt);
+#if CASHKARP_STATISTICS
+		statistics.rhsEvaluations++;
+#endif
+
+		for (i = 0; i < augmentedSize; i++)
+			zScaled[i] = std::abs(z[i]) + std::abs(dzdt[i] * stepSize) + 1.0e-30;
+		for (std::size_t j = 0; j < parameterSize; j++) {
+			double parameterScale = (parameters[j] != 0.0) ? std::abs(parameters[j]) : 1.0;
+			for (i = 0; i < uSize; i++)
+				zScaled[uSize + j * uSize + i] += zScaled[i] / parameterScale;
+		}
+
+		double tNext = t + stepSize;
+		if ((tNext - tSpan.second) * (tNext - tSpan.first) > 0.0)
+			stepSize = tSpan.second - t;
+
+		CashKarp::CashKarpQualityStep(
+			z, dzdt, zScaled, t, stepSize, tolerance,
+			previousStepSize, nextStepSize, augmentedFun, statisticsPointer);
+
+		observe(t);
+
+		if ((t - tSpan.second) * (tSpan.second - tSpan.first) >= 0.0)
+			break;
+
+		stepSize = nextStepSize;
+	}
+
+	return statistics;
+}
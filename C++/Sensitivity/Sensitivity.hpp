@@ -0,0 +1,191 @@
+/**
+* @file Sensitivity.hpp
+* @brief Análise de sensibilidade direta em relação a parâmetros
+*/
+
+/*
+	* Dado o sistema du/dt = f(t, u, p), com P parâmetros p, as sensibilidades
+	s_j = du/dp_j satisfazem
+		ds_j/dt = (df/du) * s_j + df/dp_j
+	SensitivityRange integra u e s_1, ..., s_P juntos, como um único sistema
+	de N * (1 + P) equações, com o mesmo controle de passo de CashKarpRange:
+	todas as sensibilidades compartilham a sequência de passos da solução e
+	também participam do controle de erro. O erro de s_ij é medido em relação
+	a |s_ij| somado à escala de u_i dividida por |p_j|, de modo que
+	sensibilidades nulas não reduzem o passo indefinidamente.
+
+	* As sensibilidades ficam em um vetor com N * P valores, ordenado por
+	parâmetro: sensitivities[j * N + i] = du_i/dp_j.
+
+	* O lado direito das sensibilidades é calculado sem erro de truncamento:
+	-> SensitivityRange: fornecido pelo usuário (SensitivityFunction, a partir
+	das derivadas analíticas de f);
+	-> AutomaticSensitivityRange: f escrita em template no tipo do escalar é
+	avaliada com AutoDiff::Dual<Lanes>. A derivada k de u recebe s_j e a de
+	p recebe e_j, de modo que a derivada k de f é exatamente
+	(df/du) * s_j + df/dp_j: ceil(P / Lanes) avaliações com números duais
+	por estágio, além da avaliação de f com double.
+
+	* Em IntegrationStatistics, rhsEvaluations conta as chamadas a dynFun e,
+	em AutomaticSensitivityRange, também as avaliações com números duais.
+
+	* Arquivo de cabeçalho, não contém implementações (exceto templates).
+*/
+
+#pragma once
+
+#include "CashKarp.hpp"
+#include "Dual.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace Sensitivity {
+	/**
+	* @brief Sistema com parâmetros: void(t, u, parameters, dudt).
+	*/
+	using ParametricFunction = std::function<
+		void(
+			double,
+			std::vector<double>&,
+			std::vector<double>&,
+			std::vector<double>&)>;
+
+	/**
+	* @brief Lado direito das sensibilidades:
+	* void(t, u, parameters, dudt, sensitivities, dSdt), onde dudt já contém
+	* f(t, u, p) e dSdt deve receber (df/du) * s_j + df/dp_j para cada j,
+	* na mesma ordem de sensitivities.
+	*/
+	using SensitivityFunction = std::function<
+		void(
+			double,
+			std::vector<double>&,
+			std::vector<double>&,
+			std::vector<double>&,
+			std::vector<double>&,
+			std::vector<double>&)>;
+
+	/**
+	* @brief Rotina que integra o sistema e suas sensibilidades em relação aos
+	* parâmetros com o método de Cash-Karp.
+	* @param[in] uInitial Valores iniciais do sistema de EDO`s (entrada)
+	* @param[in] sensitivityInitial Sensibilidades iniciais, du(t0)/dp, com
+	* N * P valores; se vazio, são nulas (entrada)
+	* @param[in] parameters Valores dos parâmetros (entrada)
+	* @param[in] tSpan Intervalo de integração, com início e fim (entrada)
+	* @param[in] tolerance Tolerância aceita pelo algoritmo (entrada)
+	* @param[in] initialStep Passo inicial (entrada)
+	* @param[in] minimumStep Passo mínimo, atualmente não implementado (entrada)
+	* @param[in] maximumNumberOfSteps Quantidade máxima de iterações (entrada)
+	* @param[in] dynFun Função que computa os valores do sistema de EDO`s (entrada)
+	* @param[in] stepObserver Função chamada com t, u e as sensibilidades no
+	* ponto inicial e após cada passo aceito (entrada)
+	* @param[in] sensitivityFun Lado direito das sensibilidades (entrada)
+	* @return Estatísticas da integração do sistema aumentado
+	*/
+	CashKarp::IntegrationStatistics SensitivityRange(
+		std::vector<double>& uInitial,
+		std::vector<double>& sensitivityInitial,
+		std::vector<double>& parameters,
+		std::pair<double, double>& tSpan,
+		double tolerance,
+		double initialStep,
+		double minimumStep,
+		std::size_t maximumNumberOfSteps,
+		ParametricFunction& dynFun,
+		std::function<
+		void(double,
+			std::vector<double>&,
+			std::vector<double>&)
+		>& stepObserver,
+		SensitivityFunction& sensitivityFun);
+
+	/**
+	* @brief SensitivityRange com o lado direito das sensibilidades obtido por
+	* diferenciação automática.
+	* system deve ser um objeto com operator() em template no tipo do escalar:
+	*	template <typename Scalar>
+	*	void operator()(double t, std::vector<Scalar>& u,
+	*		std::vector<Scalar>& parameters, std::vector<Scalar>& dudt) const;
+	* Os demais parâmetros são os de SensitivityRange.
+	* @return Estatísticas da integração do sistema aumentado
+	*/
+	template <std::size_t Lanes = 4, typename System>
+	CashKarp::IntegrationStatistics AutomaticSensitivityRange(
+		std::vector<double>& uInitial,
+		std::vector<double>& sensitivityInitial,
+		std::vector<double>& parameters,
+		std::pair<double, double>& tSpan,
+		double tolerance,
+		double initialStep,
+		double minimumStep,
+		std::size_t maximumNumberOfSteps,
+		System& system,
+		std::function<
+		void(double,
+			std::vector<double>&,
+			std::vector<double>&)
+		>& stepObserver)
+	{
+		using Dual = AutoDiff::Dual<Lanes>;
+		std::size_t uSize = uInitial.size(), parameterSize = parameters.size();
+		std::size_t dualEvaluations = 0;
+
+		ParametricFunction dynFun = [&system](
+			double t,
+			std::vector<double>& u,
+			std::vector<double>& p,
+			std::vector<double>& dudt)
+		{
+			system(t, u, p, dudt);
+		};
+
+		/*
+			Lanes sensibilidades por avaliação: a derivada lane de u é s_j e a
+			de p é e_j, com j = first + lane.
+		*/
+		std::vector<Dual> uDual(uSize), parametersDual(parameterSize), dudtDual(uSize);
+		SensitivityFunction sensitivityFun = [&](
+			double t,
+			std::vector<double>& u,
+			std::vector<double>& p,
+			std::vector<double>& dudt,
+			std::vector<double>& s,
+			std::vector<double>& dsdt)
+		{
+			for (std::size_t first = 0; first < parameterSize; first += Lanes) {
+				std::size_t lanes = std::min(Lanes, parameterSize - first);
+				for (std::size_t i = 0; i < uSize; i++) {
+					uDual[i] = Dual(u[i]);
+					for (std::size_t lane = 0; lane < lanes; lane++)
+						uDual[i].derivative[lane] = s[(first + lane) * uSize + i];
+				}
+				for (std::size_t j = 0; j < parameterSize; j++)
+					parametersDual[j] = Dual(p[j]);
+				for (std::size_t lane = 0; lane < lanes; lane++)
+					parametersDual[first + lane].derivative[lane] = 1.0;
+
+				system(t, uDual, parametersDual, dudtDual);
+				dualEvaluations++;
+
+				for (std::size_t lane = 0; lane < lanes; lane++) {
+					double* dsj = dsdt.data() + (first + lane) * uSize;
+					for (std::size_t i = 0; i < uSize; i++)
+						dsj[i] = dudtDual[i].derivative[lane];
+				}
+			}
+		};
+
+		CashKarp::IntegrationStatistics statistics = SensitivityRange(
+			uInitial, sensitivityInitial, parameters, tSpan, tolerance,
+			initialStep, minimumStep, maximumNumberOfSteps,
+			dynFun, stepObserver, sensitivityFun);
+#if CASHKARP_STATISTICS
+		statistics.rhsEvaluations += dualEvaluations;
+#endif
+		return statistics;
+	}
+}
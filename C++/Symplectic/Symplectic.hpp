@@ -0,0 +1,328 @@
+/**
+* @file Symplectic.hpp
+* @brief Integradores simpléticos de passo constante para Hamiltonianos separáveis
+*/
+
+/*
+	* Para Hamiltonianos separáveis, H(q, p) = T(p) + V(q), as equações de
+	movimento são
+		dq/dt = dT/dp  (velocityFun)
+		dp/dt = -dV/dq (forceFun)
+	e cada passo é uma sequência de "drifts" (q += a * h * dT/dp) e "kicks"
+	(p += b * h * (-dV/dq)). Como cada uma dessas operações é exatamente
+	simplética, o erro na energia permanece limitado por tempo indefinido,
+	enquanto o erro de um método como Cash-Karp cresce ao longo da
+	integração. Em integrações longas (órbitas, dinâmica molecular) isso
+	permite passos muito maiores que os de CashKarpRange para o mesmo erro
+	na energia.
+
+	* Posições e velocidades ficam em vetores separados, no formato SoA
+	(structure of arrays): a coordenada d da partícula i está na posição
+	d * particles + i. Assim os laços de drift e kick, e também as funções de
+	força, percorrem memória contígua para cada coordenada.
+
+	* Assim como em FixedStep, o método é um parâmetro de template e toda a
+	implementação está neste arquivo.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Symplectic {
+	/*
+		Cada método é descrito por pares (drift, kick), aplicados em ordem:
+			q += drift[s] * h * dT/dp(p)
+			p += kick[s] * h * F(q)
+		Um coeficiente de drift nulo no primeiro par indica que a força no
+		início do passo é a mesma do último kick do passo anterior (FSAL),
+		e portanto não precisa ser recalculada em Range.
+	*/
+
+	namespace Coefficients {
+		// 2^(1/3)
+		constexpr double cubeRootTwo = 1.2599210498948731648;
+		// Pesos do "triple jump" de quarta ordem
+		constexpr double tripleJump1 = 1.0 / (2.0 - cubeRootTwo);
+		constexpr double tripleJump0 = -cubeRootTwo / (2.0 - cubeRootTwo);
+		// Pesos da solução A de sexta ordem de Yoshida (1990)
+		constexpr double yoshida1 = -1.17767998417887;
+		constexpr double yoshida2 = 0.235573213359357;
+		constexpr double yoshida3 = 0.784513610477560;
+		constexpr double yoshida0 = 1.0 - 2.0 * (yoshida1 + yoshida2 + yoshida3);
+		// Omelyan, Mryglod e Folk (2002), PEFRL
+		constexpr double omelyanXi = 0.1786178958448091;
+		constexpr double omelyanLambda = -0.2123418310626054;
+		constexpr double omelyanChi = -0.06626458266981849;
+	}
+
+	/**
+	* @brief Velocity Verlet (segunda ordem): kick h/2, drift h, kick h/2.
+	*/
+	struct VelocityVerlet {
+		static constexpr std::size_t stages = 2;
+		static constexpr std::size_t order = 2;
+		static constexpr double drift[stages] = { 0.0, 1.0 };
+		static constexpr double kick[stages] = { 0.5, 0.5 };
+	};
+
+	/**
+	* @brief Yoshida de quarta ordem: composição de três passos de Velocity
+	* Verlet com pesos w1, w0, w1.
+	*/
+	struct Yoshida4 {
+		static constexpr std::size_t stages = 4;
+		static constexpr std::size_t order = 4;
+		static constexpr double drift[stages] = {
+			0.0,
+			Coefficients::tripleJump1,
+			Coefficients::tripleJump0,
+			Coefficients::tripleJump1 };
+		static constexpr double kick[stages] = {
+			0.5 * Coefficients::tripleJump1,
+			0.5 * (Coefficients::tripleJump1 + Coefficients::tripleJump0),
+			0.5 * (Coefficients::tripleJump0 + Coefficients::tripleJump1),
+			0.5 * Coefficients::tripleJump1 };
+	};
+
+	/**
+	* @brief Yoshida de sexta ordem (solução A): composição de sete passos de
+	* Velocity Verlet com pesos w3, w2, w1, w0, w1, w2, w3.
+	*/
+	struct Yoshida6 {
+		static constexpr std::size_t stages = 8;
+		static constexpr std::size_t order = 6;
+		static constexpr double drift[stages] = {
+			0.0,
+			Coefficients::yoshida3,
+			Coefficients::yoshida2,
+			Coefficients::yoshida1,
+			Coefficients::yoshida0,
+			Coefficients::yoshida1,
+			Coefficients::yoshida2,
+			Coefficients::yoshida3 };
+		static constexpr double kick[stages] = {
+			0.5 * Coefficients::yoshida3,
+			0.5 * (Coefficients::yoshida3 + Coefficients::yoshida2),
+			0.5 * (Coefficients::yoshida2 + Coefficients::yoshida1),
+			0.5 * (Coefficients::yoshida1 + Coefficients::yoshida0),
+			0.5 * (Coefficients::yoshida0 + Coefficients::yoshida1),
+			0.5 * (Coefficients::yoshida1 + Coefficients::yoshida2),
+			0.5 * (Coefficients::yoshida2 + Coefficients::yoshida3),
+			0.5 * Coefficients::yoshida3 };
+	};
+
+	/**
+	* @brief Forest-Ruth (quarta ordem), na forma original, iniciando e
+	* terminando com drifts (3 cálculos de força por passo).
+	*/
+	struct ForestRuth {
+		static constexpr std::size_t stages = 4;
+		static constexpr std::size_t order = 4;
+		static constexpr double drift[stages] = {
+			0.5 * Coefficients::tripleJump1,
+			0.5 * (1.0 - Coefficients::tripleJump1),
+			0.5 * (1.0 - Coefficients::tripleJump1),
+			0.5 * Coefficients::tripleJump1 };
+		static constexpr double kick[stages] = {
+			Coefficients::tripleJump1,
+			Coefficients::tripleJump0,
+			Coefficients::tripleJump1,
+			0.0 };
+	};
+
+	/**
+	* @brief Variante de Forest-Ruth otimizada por Omelyan, Mryglod e Folk
+	* (PEFRL, quarta ordem, 4 cálculos de força por passo). O erro na
+	* energia é cerca de duas ordens de grandeza menor que o de ForestRuth.
+	*/
+	struct OmelyanForestRuth {
+		static constexpr std::size_t stages = 5;
+		static constexpr std::size_t order = 4;
+		static constexpr double drift[stages] = {
+			Coefficients::omelyanXi,
+			Coefficients::omelyanChi,
+			1.0 - 2.0 * (Coefficients::omelyanChi + Coefficients::omelyanXi),
+			Coefficients::omelyanChi,
+			Coefficients::omelyanXi };
+		static constexpr double kick[stages] = {
+			0.5 * (1.0 - 2.0 * Coefficients::omelyanLambda),
+			Coefficients::omelyanLambda,
+			Coefficients::omelyanLambda,
+			0.5 * (1.0 - 2.0 * Coefficients::omelyanLambda),
+			0.0 };
+	};
+
+	/**
+	* @brief Espaço de fase em formato SoA.
+	* position[d * particles + i] é a coordenada d da partícula i, e o mesmo
+	* vale para velocity (momento, quando a massa não é unitária).
+	*/
+	struct PhaseSpace {
+		PhaseSpace() : particles(0), dimensions(0) {}
+
+		/**
+		* @brief Construtor, com posições e velocidades nulas.
+		* @param[in] particles Quantidade de partículas (entrada)
+		* @param[in] dimensions Quantidade de coordenadas por partícula (entrada)
+		*/
+		PhaseSpace(std::size_t particles, std::size_t dimensions) :
+			particles(particles),
+			dimensions(dimensions),
+			position(particles * dimensions),
+			velocity(particles * dimensions)
+		{
+		}
+
+		/**
+		* @brief Início da coordenada d das posições.
+		* @param[in] d Índice da coordenada (entrada)
+		*/
+		double* Position(std::size_t d) { return position.data() + d * particles; }
+
+		/**
+		* @brief Início da coordenada d das velocidades.
+		* @param[in] d Índice da coordenada (entrada)
+		*/
+		double* Velocity(std::size_t d) { return velocity.data() + d * particles; }
+
+		std::size_t particles;
+		std::size_t dimensions;
+		std::vector<double> position;
+		std::vector<double> velocity;
+	};
+
+	/**
+	* @brief Energia cinética T(p) = |p|^2 / 2, com massa unitária.
+	* Passado como velocityFun, o drift é feito diretamente com as
+	* velocidades, sem chamada de função nem vetor intermediário.
+	*/
+	struct UnitMass {
+		void operator()(std::vector<double>& p, std::vector<double>& dqdt) const {
+			dqdt = p;
+		}
+	};
+
+	/**
+	* @brief Integrador simplético de passo constante para o método Method.
+	* Os vetores intermediários são alocados no construtor.
+	*/
+	template <typename Method>
+	class Integrator {
+	public:
+		/**
+		* @brief Construtor
+		* @param[in] systemSize Tamanho dos vetores de posição e de velocidade
+		* (particles * dimensions) (entrada)
+		*/
+		explicit Integrator(std::size_t systemSize) :
+			force(systemSize),
+			dqdt(systemSize),
+			forceValid(false)
+		{
+		}
+
+		/**
+		* @brief Realiza um passo do método, atualizando state.
+		* @param[in] velocityFun Função que calcula dT/dp, com protótipo
+		* void(std::vector<double>& p, std::vector<double>& dqdt), ou UnitMass
+		* (entrada)
+		* @param[in] forceFun Função que calcula -dV/dq, com protótipo
+		* void(std::vector<double>& q, std::vector<double>& force) (entrada)
+		* @param[in] stepSize Tamanho do passo (entrada)
+		* @param[in, out] state Posições e velocidades (entrada e saída)
+		*/
+		template <typename VelocityFunction, typename ForceFunction>
+		void Step(
+			VelocityFunction& velocityFun,
+			ForceFunction& forceFun,
+			double stepSize,
+			PhaseSpace& state)
+		{
+			forceValid = false;
+			Advance(velocityFun, forceFun, stepSize, state);
+		}
+
+		/**
+		* @brief Integra em tSpan com numberOfSteps passos iguais.
+		* A força do último kick de cada passo é reaproveitada no início do
+		* seguinte quando o método permite (Velocity Verlet e Yoshida).
+		* @param[in] velocityFun Função que calcula dT/dp, ou UnitMass (entrada)
+		* @param[in] forceFun Função que calcula -dV/dq (entrada)
+		* @param[in, out] state Estado inicial e, ao final, em tSpan.second
+		* (entrada e saída)
+		* @param[in] tSpan Intervalo de integração, com início e fim (entrada)
+		* @param[in] numberOfSteps Quantidade de passos (entrada)
+		* @param[in] stepObserver Função chamada após cada passo, com protótipo
+		* void(double t, PhaseSpace& state), que não deve alterar state (entrada)
+		*/
+		template <typename VelocityFunction, typename ForceFunction, typename Observer>
+		void Range(
+			VelocityFunction& velocityFun,
+			ForceFunction& forceFun,
+			PhaseSpace& state,
+			std::pair<double, double>& tSpan,
+			std::size_t numberOfSteps,
+			Observer& stepObserver)
+		{
+			double stepSize = (tSpan.second - tSpan.first) / numberOfSteps;
+			forceValid = false;
+			for (std::size_t n = 0; n < numberOfSteps; n++) {
+				Advance(velocityFun, forceFun, stepSize, state);
+				stepObserver(tSpan.first + (n + 1) * stepSize, state);
+			}
+		}
+
+		/**
+		* @brief Quantidade de cálculos de força realizados desde a construção.
+		*/
+		std::size_t ForceEvaluations() const { return forceEvaluations; }
+
+	private:
+		template <typename VelocityFunction, typename ForceFunction>
+		void Advance(
+			VelocityFunction& velocityFun,
+			ForceFunction& forceFun,
+			double stepSize,
+			PhaseSpace& state)
+		{
+			std::vector<double>& q = state.position;
+			std::vector<double>& p = state.velocity;
+			std::size_t size = q.size();
+
+			for (std::size_t s = 0; s < Method::stages; s++) {
+				if (Method::drift[s] != 0.0) {
+					double h = Method::drift[s] * stepSize;
+					if constexpr (std::is_same<typename std::decay<VelocityFunction>::type, UnitMass>::value) {
+						for (std::size_t i = 0; i < size; i++)
+							q[i] += h * p[i];
+					}
+					else {
+						velocityFun(p, dqdt);
+						for (std::size_t i = 0; i < size; i++)
+							q[i] += h * dqdt[i];
+					}
+					forceValid = false;
+				}
+				if (Method::kick[s] != 0.0) {
+					if (!forceValid) {
+						forceFun(q, force);
+						forceEvaluations++;
+						forceValid = true;
+					}
+					double h = Method::kick[s] * stepSize;
+					for (std::size_t i = 0; i < size; i++)
+						p[i] += h * force[i];
+				}
+			}
+		}
+
+		std::vector<double> force;
+		std::vector<double> dqdt;
+		bool forceValid;
+		std::size_t forceEvaluations = 0;
+	};
+}
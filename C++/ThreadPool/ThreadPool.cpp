@@ -0,0 +1,149 @@
+/**
+* @file ThreadPool.cpp
+* @brief Conjunto persistente de threads com partição estática de índices
+*/
+
+#include "ThreadPool.hpp"
+#include <algorithm>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+	/*
+		Fixa a thread atual no núcleo indicado. Sem efeito fora do Linux.
+	*/
+	void PinCurrentThread(std::size_t core) {
+#ifdef __linux__
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(static_cast<int>(core % CPU_SETSIZE), &set);
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+		(void)core;
+#endif
+	}
+}
+
+ThreadPool::ThreadPool::ThreadPool(std::size_t threads, bool pinThreads)
+{
+	if (threads == 0)
+		threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+
+	if (pinThreads)
+		PinCurrentThread(0);
+	for (std::size_t part = 1; part < threads; part++) {
+		workers.emplace_back([this, part, pinThreads]() {
+			if (pinThreads)
+				PinCurrentThread(part);
+			Worker(part);
+		});
+	}
+}
+
+ThreadPool::ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	start.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+std::pair<std::size_t, std::size_t> ThreadPool::ThreadPool::Partition(
+	std::size_t size, std::size_t part) const
+{
+	/*
+		Partes de tamanho múltiplo de 8, a última recebe o restante.
+	*/
+	std::size_t parts = Size();
+	std::size_t chunk = (size + parts - 1) / parts;
+	chunk = (chunk + 7) / 8 * 8;
+	std::size_t begin = std::min(size, part * chunk);
+	std::size_t end = std::min(size, begin + chunk);
+	return { begin, end };
+}
+
+void ThreadPool::ThreadPool::Execute(std::size_t part)
+{
+	std::pair<std::size_t, std::size_t> range(0, 0);
+	if (!taskEachThread) {
+		range = Partition(taskSize, part);
+		if (range.first >= range.second)
+			return;
+	}
+	if (failed)
+		return;
+	try {
+		trampoline(task, part, range.first, range.second);
+	}
+	catch (...) {
+		/*
+			Qualquer exceção é guardada e relançada por Dispatch, depois que
+			todas as partes terminarem: a tarefa vive na pilha de quem
+			chamou Run e não pode ser abandonada enquanto outras threads a
+			executam.
+		*/
+		if (!failed.exchange(true))
+			failure = std::current_exception();
+	}
+}
+
+void ThreadPool::ThreadPool::Worker(std::size_t part)
+{
+	std::size_t seen = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			start.wait(lock, [&]() { return stopping || generation != seen; });
+			if (stopping)
+				return;
+			seen = generation;
+		}
+
+		Execute(part);
+
+		bool last;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			last = (--pending == 0);
+		}
+		if (last)
+			done.notify_one();
+	}
+}
+
+void ThreadPool::ThreadPool::Dispatch(
+	std::size_t size, bool eachThread, void* function, Trampoline call)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		taskSize = size;
+		taskEachThread = eachThread;
+		task = function;
+		trampoline = call;
+		failed = false;
+		failure = nullptr;
+		pending = workers.size();
+		generation++;
+	}
+	if (!workers.empty())
+		start.notify_all();
+
+	/*
+		A thread que chamou Run executa a parte 0 enquanto as demais
+		executam as suas.
+	*/
+	Execute(0);
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [&]() { return pending == 0; });
+	}
+
+	if (failed)
+		std::rethrow_exception(failure);
+}
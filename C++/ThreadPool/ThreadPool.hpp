@@ -0,0 +1,168 @@
+/**
+* @file ThreadPool.hpp
+* @brief Conjunto persistente de threads com partição estática de índices
+*/
+
+/*
+	* Criar threads a cada estágio de um passo custa dezenas de
+	microssegundos, o que é comparável ao próprio estágio em sistemas grandes.
+	As threads deste conjunto são criadas uma única vez e aguardam tarefas.
+
+	* Run(size, task) divide os índices [0, size) em Size() partes contíguas
+	e executa task(part, begin, end) em cada uma. A parte p é sempre executada
+	pela mesma thread (a parte 0 pela thread que chamou Run), de modo que, se
+	os vetores forem inicializados com Run (primeiro toque), as páginas de
+	cada parte ficam na memória do nó NUMA da thread que as utiliza.
+
+	* As fronteiras das partes são múltiplas de 8 doubles (64 bytes, uma linha
+	de cache), evitando que duas threads escrevam na mesma linha.
+
+	* RunOnEachThread(task) executa task(part) uma vez em cada thread, sem
+	índices: para tarefas que distribuem o trabalho por conta própria (uma
+	fila, por exemplo).
+
+	* Arquivo de cabeçalho, não contém implementações (exceto templates).
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ThreadPool {
+	/**
+	* @brief Alocador que não inicializa os valores em resize(), deixando o
+	* primeiro toque (e a escolha do nó NUMA) para quem escrever neles.
+	*/
+	template <typename T>
+	struct FirstTouchAllocator : std::allocator<T> {
+		template <typename U>
+		struct rebind {
+			using other = FirstTouchAllocator<U>;
+		};
+
+		FirstTouchAllocator() = default;
+
+		template <typename U>
+		FirstTouchAllocator(const FirstTouchAllocator<U>&) noexcept
+		{
+		}
+
+		template <typename U>
+		void construct(U* pointer)
+		{
+			::new (static_cast<void*>(pointer)) U;
+		}
+
+		template <typename U, typename... Arguments>
+		void construct(U* pointer, Arguments&&... arguments)
+		{
+			::new (static_cast<void*>(pointer)) U(std::forward<Arguments>(arguments)...);
+		}
+	};
+
+	/**
+	* @brief Vetor de doubles cuja memória não é tocada na alocação.
+	*/
+	using Vector = std::vector<double, FirstTouchAllocator<double>>;
+
+	/**
+	* @brief Conjunto persistente de threads.
+	*/
+	class ThreadPool {
+	public:
+		/**
+		* @brief Construtor
+		* @param[in] threads Quantidade de threads, incluindo a que chama Run
+		* (0: uma por núcleo disponível) (entrada)
+		* @param[in] pinThreads Fixa cada thread em um núcleo (apenas Linux),
+		* impedindo que o sistema a mova para longe de sua memória (entrada)
+		*/
+		explicit ThreadPool(std::size_t threads = 0, bool pinThreads = false);
+
+		/**
+		* @brief Destrutor, encerra as threads.
+		*/
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		/**
+		* @brief Quantidade de threads (e de partes em Run).
+		*/
+		std::size_t Size() const { return workers.size() + 1; }
+
+		/**
+		* @brief Intervalo de índices da parte part.
+		* @param[in] size Quantidade de índices (entrada)
+		* @param[in] part Parte, entre 0 e Size() - 1 (entrada)
+		* @return Início e fim (exclusivo) do intervalo, possivelmente vazio
+		*/
+		std::pair<std::size_t, std::size_t> Partition(std::size_t size, std::size_t part) const;
+
+		/**
+		* @brief Executa task(part, begin, end) em todas as partes de
+		* [0, size) e aguarda o término de todas.
+		* Uma exceção de qualquer tipo lançada por task é relançada aqui,
+		* após o término de todas as partes (apenas a primeira, se houver
+		* várias).
+		* @param[in] size Quantidade de índices (entrada)
+		* @param[in] task Tarefa, chamada uma vez por parte (entrada)
+		*/
+		template <typename Task>
+		void Run(std::size_t size, Task& task)
+		{
+			Dispatch(size, false, &task,
+				[](void* function, std::size_t part, std::size_t begin, std::size_t end) {
+					(*static_cast<Task*>(function))(part, begin, end);
+				});
+		}
+
+		/**
+		* @brief Executa task(part) uma vez em cada thread, com part entre 0 e
+		* Size() - 1, e aguarda o término de todas. Exceções são tratadas
+		* como em Run.
+		* @param[in] task Tarefa, chamada uma vez por thread (entrada)
+		*/
+		template <typename Task>
+		void RunOnEachThread(Task& task)
+		{
+			Dispatch(0, true, &task,
+				[](void* function, std::size_t part, std::size_t, std::size_t) {
+					(*static_cast<Task*>(function))(part);
+				});
+		}
+
+	private:
+		using Trampoline = void (*)(void*, std::size_t, std::size_t, std::size_t);
+
+		void Dispatch(std::size_t size, bool eachThread, void* task, Trampoline trampoline);
+		void Execute(std::size_t part);
+		void Worker(std::size_t part);
+
+		std::vector<std::thread> workers;
+		std::mutex mutex;
+		std::condition_variable start, done;
+		// Incrementado a cada Run, acorda as threads
+		std::size_t generation = 0;
+		std::size_t pending = 0;
+		bool stopping = false;
+
+		// Tarefa atual
+		std::size_t taskSize = 0;
+		// RunOnEachThread: todas as partes, sem partição de índices
+		bool taskEachThread = false;
+		void* task = nullptr;
+		Trampoline trampoline = nullptr;
+		std::atomic<bool> failed{ false };
+		std::exception_ptr failure;
+	};
+}
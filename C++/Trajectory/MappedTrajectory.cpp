@@ -0,0 +1,321 @@
+/**
+* @file MappedTrajectory.cpp
+* @brief Trajetórias gravadas em arquivos binários mapeados em memória
+*/
+
+#include "MappedTrajectory.hpp"
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+	const char trajectoryMagic[8] = { 'C', 'K', 'T', 'R', 'A', 'J', 0, 0 };
+	const std::uint32_t trajectoryVersion = 1;
+}
+
+/*
+	MappedFile
+*/
+
+Trajectory::MappedFile::MappedFile() :
+	data(nullptr),
+	size(0),
+#ifdef _WIN32
+	file(INVALID_HANDLE_VALUE),
+	mapping(nullptr)
+#else
+	file(-1)
+#endif
+{
+}
+
+Trajectory::MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+
+void Trajectory::MappedFile::Create(const std::string& path, std::size_t newSize)
+{
+	Close();
+	file = CreateFileA(
+		path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+		nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		throw "Não foi possível criar o arquivo de trajetória.";
+	Resize(newSize);
+}
+
+void Trajectory::MappedFile::OpenReadOnly(const std::string& path)
+{
+	Close();
+	file = CreateFileA(
+		path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+		nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		throw "Não foi possível abrir o arquivo de trajetória.";
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize))
+		throw "Não foi possível obter o tamanho do arquivo de trajetória.";
+	size = static_cast<std::size_t>(fileSize.QuadPart);
+	Map(false);
+}
+
+void Trajectory::MappedFile::Resize(std::size_t newSize)
+{
+	Unmap();
+	LARGE_INTEGER position;
+	position.QuadPart = static_cast<LONGLONG>(newSize);
+	if (!SetFilePointerEx(file, position, nullptr, FILE_BEGIN) || !SetEndOfFile(file))
+		throw "Não foi possível alterar o tamanho do arquivo de trajetória.";
+	size = newSize;
+	Map(true);
+}
+
+void Trajectory::MappedFile::Map(bool writable)
+{
+	if (size == 0)
+		return;
+	mapping = CreateFileMappingA(
+		file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+		throw "Não foi possível mapear o arquivo de trajetória.";
+	data = static_cast<unsigned char*>(MapViewOfFile(
+		mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0));
+	if (data == nullptr)
+		throw "Não foi possível mapear o arquivo de trajetória.";
+}
+
+void Trajectory::MappedFile::Unmap()
+{
+	if (data != nullptr)
+		UnmapViewOfFile(data);
+	if (mapping != nullptr)
+		CloseHandle(mapping);
+	data = nullptr;
+	mapping = nullptr;
+}
+
+void Trajectory::MappedFile::Flush()
+{
+	if (data != nullptr)
+		FlushViewOfFile(data, 0);
+}
+
+void Trajectory::MappedFile::Close()
+{
+	Unmap();
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+	file = INVALID_HANDLE_VALUE;
+	size = 0;
+}
+
+#else
+
+void Trajectory::MappedFile::Create(const std::string& path, std::size_t newSize)
+{
+	Close();
+	file = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (file < 0)
+		throw "Não foi possível criar o arquivo de trajetória.";
+	Resize(newSize);
+}
+
+void Trajectory::MappedFile::OpenReadOnly(const std::string& path)
+{
+	Close();
+	file = open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		throw "Não foi possível abrir o arquivo de trajetória.";
+	struct stat status;
+	if (fstat(file, &status) != 0)
+		throw "Não foi possível obter o tamanho do arquivo de trajetória.";
+	size = static_cast<std::size_t>(status.st_size);
+	Map(false);
+}
+
+void Trajectory::MappedFile::Resize(std::size_t newSize)
+{
+	Unmap();
+	if (ftruncate(file, static_cast<off_t>(newSize)) != 0)
+		throw "Não foi possível alterar o tamanho do arquivo de trajetória.";
+	size = newSize;
+	Map(true);
+}
+
+void Trajectory::MappedFile::Map(bool writable)
+{
+	if (size == 0)
+		return;
+	void* address = mmap(
+		nullptr, size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ,
+		MAP_SHARED, file, 0);
+	if (address == MAP_FAILED)
+		throw "Não foi possível mapear o arquivo de trajetória.";
+	data = static_cast<unsigned char*>(address);
+}
+
+void Trajectory::MappedFile::Unmap()
+{
+	if (data != nullptr)
+		munmap(data, size);
+	data = nullptr;
+}
+
+void Trajectory::MappedFile::Flush()
+{
+	if (data != nullptr)
+		msync(data, size, MS_SYNC);
+}
+
+void Trajectory::MappedFile::Close()
+{
+	Unmap();
+	if (file >= 0)
+		close(file);
+	file = -1;
+	size = 0;
+}
+
+#endif
+
+/*
+	MappedTrajectoryWriter
+*/
+
+Trajectory::MappedTrajectoryWriter::MappedTrajectoryWriter(
+	const std::string& path,
+	std::size_t systemSize,
+	std::size_t initialCapacity) :
+	systemSize(systemSize),
+	stepCount(0),
+	capacity(initialCapacity > 0 ? initialCapacity : 1),
+	open(true)
+{
+	std::size_t recordBytes = (systemSize + 1) * sizeof(double);
+	file.Create(path, sizeof(TrajectoryHeader) + capacity * recordBytes);
+
+	TrajectoryHeader* header = Header();
+	std::memset(header, 0, sizeof(TrajectoryHeader));
+	std::memcpy(header->magic, trajectoryMagic, sizeof(header->magic));
+	header->version = trajectoryVersion;
+	header->dataType = static_cast<std::uint32_t>(DataType::Float64);
+	header->systemSize = systemSize;
+	header->stepCount = 0;
+}
+
+Trajectory::MappedTrajectoryWriter::~MappedTrajectoryWriter()
+{
+	/*
+		Destrutores não devem lançar exceções: caso o truncamento final
+		falhe, o arquivo continua válido (apenas maior que o necessário).
+	*/
+	try {
+		Close();
+	}
+	catch (...) {
+	}
+}
+
+Trajectory::TrajectoryHeader* Trajectory::MappedTrajectoryWriter::Header() const
+{
+	return reinterpret_cast<TrajectoryHeader*>(file.Data());
+}
+
+void Trajectory::MappedTrajectoryWriter::Append(double t, const std::vector<double>& u)
+{
+	if (!open)
+		throw "Arquivo de trajetória já foi fechado.";
+	if (u.size() != systemSize)
+		throw "Tamanho de u difere do tamanho do sistema da trajetória.";
+
+	std::size_t recordBytes = (systemSize + 1) * sizeof(double);
+
+	/*
+		Crescimento geométrico, para que o custo de remapear o arquivo seja
+		amortizado ao longo dos passos.
+	*/
+	if (stepCount == capacity) {
+		capacity *= 2;
+		file.Resize(sizeof(TrajectoryHeader) + capacity * recordBytes);
+	}
+
+	double* record = reinterpret_cast<double*>(
+		file.Data() + sizeof(TrajectoryHeader) + stepCount * recordBytes);
+	record[0] = t;
+	std::memcpy(record + 1, u.data(), systemSize * sizeof(double));
+
+	/*
+		O cabeçalho só é atualizado após o registro estar completo.
+	*/
+	stepCount++;
+	Header()->stepCount = stepCount;
+}
+
+std::function<void(double, std::vector<double>&)>
+	Trajectory::MappedTrajectoryWriter::Observer()
+{
+	return [this](double t, std::vector<double>& u) {
+		Append(t, u);
+	};
+}
+
+void Trajectory::MappedTrajectoryWriter::Flush()
+{
+	if (open)
+		file.Flush();
+}
+
+void Trajectory::MappedTrajectoryWriter::Close()
+{
+	if (!open)
+		return;
+	open = false;
+	std::size_t recordBytes = (systemSize + 1) * sizeof(double);
+	file.Resize(sizeof(TrajectoryHeader) + stepCount * recordBytes);
+	file.Flush();
+	file.Close();
+}
+
+/*
+	MappedTrajectoryReader
+*/
+
+Trajectory::MappedTrajectoryReader::MappedTrajectoryReader(const std::string& path) :
+	records(nullptr),
+	systemSize(0),
+	stepCount(0)
+{
+	file.OpenReadOnly(path);
+	if (file.Size() < sizeof(TrajectoryHeader))
+		throw "Arquivo de trajetória inválido: cabeçalho incompleto.";
+
+	const TrajectoryHeader* header =
+		reinterpret_cast<const TrajectoryHeader*>(file.Data());
+	if (std::memcmp(header->magic, trajectoryMagic, sizeof(header->magic)) != 0)
+		throw "Arquivo de trajetória inválido: identificador incorreto.";
+	if (header->version != trajectoryVersion)
+		throw "Arquivo de trajetória inválido: versão não suportada.";
+	if (header->dataType != static_cast<std::uint32_t>(DataType::Float64))
+		throw "Arquivo de trajetória inválido: tipo de dado não suportado.";
+
+	systemSize = static_cast<std::size_t>(header->systemSize);
+	stepCount = static_cast<std::size_t>(header->stepCount);
+	std::size_t recordBytes = (systemSize + 1) * sizeof(double);
+	if (file.Size() < sizeof(TrajectoryHeader) + stepCount * recordBytes)
+		throw "Arquivo de trajetória inválido: tamanho inconsistente.";
+
+	records = reinterpret_cast<const double*>(file.Data() + sizeof(TrajectoryHeader));
+}
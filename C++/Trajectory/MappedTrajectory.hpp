@@ -0,0 +1,218 @@
+/**
+* @file MappedTrajectory.hpp
+* @brief Trajetórias gravadas em arquivos binários mapeados em memória
+*/
+
+/*
+	* Integrações longas (ou de sistemas grandes) produzem trajetórias que não
+	cabem confortavelmente na memória como std::vector<std::vector<double>>.
+	As classes deste arquivo gravam cada passo aceito diretamente em um
+	arquivo mapeado em memória, de forma que o tamanho da trajetória é
+	limitado pelo disco, e não pelo heap.
+
+	* Formato do arquivo (ordem de bytes nativa da máquina):
+	-> Cabeçalho de 64 bytes (TrajectoryHeader)
+	-> stepCount registros de (systemSize + 1) valores: t, u[0], ..., u[n-1]
+
+	* O cabeçalho é atualizado a cada passo gravado, portanto um arquivo
+	interrompido (processo encerrado, por exemplo) continua legível até o
+	último passo gravado.
+
+	* Arquivo de cabeçalho, não contém implementações.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Trajectory {
+	/**
+	* @brief Tipo dos valores armazenados no arquivo.
+	*/
+	enum class DataType : std::uint32_t {
+		Float64 = 1
+	};
+
+	/**
+	* @brief Cabeçalho do arquivo de trajetória, com exatamente 64 bytes.
+	*/
+	struct TrajectoryHeader {
+		// Identificador do formato, "CKTRAJ" seguido de dois zeros
+		char magic[8];
+		// Versão do formato
+		std::uint32_t version;
+		// Tipo dos valores (DataType)
+		std::uint32_t dataType;
+		// Quantidade de equações do sistema
+		std::uint64_t systemSize;
+		// Quantidade de passos gravados (incluindo o ponto inicial)
+		std::uint64_t stepCount;
+		// Reservado para versões futuras
+		std::uint64_t reserved[4];
+	};
+
+	static_assert(sizeof(TrajectoryHeader) == 64, "Cabeçalho deve ter 64 bytes");
+
+	/**
+	* @brief Região de um arquivo mapeada em memória.
+	* Encapsula as diferenças entre Windows e sistemas POSIX.
+	*/
+	class MappedFile {
+	public:
+		MappedFile();
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		/**
+		* @brief Cria (ou trunca) um arquivo com o tamanho dado e o mapeia
+		* para leitura e escrita.
+		* @param[in] path Caminho do arquivo (entrada)
+		* @param[in] size Tamanho inicial, em bytes (entrada)
+		*/
+		void Create(const std::string& path, std::size_t size);
+
+		/**
+		* @brief Mapeia um arquivo existente somente para leitura.
+		* @param[in] path Caminho do arquivo (entrada)
+		*/
+		void OpenReadOnly(const std::string& path);
+
+		/**
+		* @brief Altera o tamanho de um arquivo criado por Create, remapeando-o.
+		* Ponteiros obtidos anteriormente por Data() deixam de ser válidos.
+		* @param[in] size Novo tamanho, em bytes (entrada)
+		*/
+		void Resize(std::size_t size);
+
+		/**
+		* @brief Garante que as alterações foram enviadas ao disco.
+		*/
+		void Flush();
+
+		/**
+		* @brief Desfaz o mapeamento e fecha o arquivo.
+		*/
+		void Close();
+
+		unsigned char* Data() const { return data; }
+		std::size_t Size() const { return size; }
+
+	private:
+		void Map(bool writable);
+		void Unmap();
+
+		unsigned char* data;
+		std::size_t size;
+#ifdef _WIN32
+		void* file;
+		void* mapping;
+#else
+		int file;
+#endif
+	};
+
+	/**
+	* @brief Grava uma trajetória, passo a passo, em um arquivo mapeado.
+	* O arquivo cresce dobrando de tamanho quando necessário, e é truncado
+	* para o tamanho exato ao ser fechado.
+	*/
+	class MappedTrajectoryWriter {
+	public:
+		/**
+		* @brief Construtor. Cria (ou sobrescreve) o arquivo.
+		* @param[in] path Caminho do arquivo (entrada)
+		* @param[in] systemSize Quantidade de equações do sistema (entrada)
+		* @param[in] initialCapacity Quantidade de passos reservada
+		* inicialmente (entrada)
+		*/
+		MappedTrajectoryWriter(
+			const std::string& path,
+			std::size_t systemSize,
+			std::size_t initialCapacity = 4096);
+
+		/**
+		* @brief Destrutor. Chama Close() caso ainda não tenha sido chamado.
+		*/
+		~MappedTrajectoryWriter();
+
+		MappedTrajectoryWriter(const MappedTrajectoryWriter&) = delete;
+		MappedTrajectoryWriter& operator=(const MappedTrajectoryWriter&) = delete;
+
+		/**
+		* @brief Grava um passo ao final do arquivo.
+		* @param[in] t Valor de t (entrada)
+		* @param[in] u Valores de u, com systemSize elementos (entrada)
+		*/
+		void Append(double t, const std::vector<double>& u);
+
+		/**
+		* @brief Função que grava cada passo recebido, para ser utilizada como
+		* stepObserver de CashKarp::CashKarpRange.
+		*/
+		std::function<void(double, std::vector<double>&)> Observer();
+
+		/**
+		* @brief Envia ao disco os passos gravados até o momento.
+		*/
+		void Flush();
+
+		/**
+		* @brief Trunca o arquivo para o tamanho exato e o fecha.
+		*/
+		void Close();
+
+		std::size_t SystemSize() const { return systemSize; }
+		std::size_t StepCount() const { return stepCount; }
+
+	private:
+		TrajectoryHeader* Header() const;
+
+		MappedFile file;
+		std::size_t systemSize, stepCount, capacity;
+		bool open;
+	};
+
+	/**
+	* @brief Lê uma trajetória gravada por MappedTrajectoryWriter, mapeando o
+	* arquivo em memória. Os valores são acessados diretamente no
+	* mapeamento, sem cópias.
+	*/
+	class MappedTrajectoryReader {
+	public:
+		/**
+		* @brief Construtor. Mapeia o arquivo e valida o cabeçalho.
+		* @param[in] path Caminho do arquivo (entrada)
+		*/
+		explicit MappedTrajectoryReader(const std::string& path);
+
+		std::size_t SystemSize() const { return systemSize; }
+		std::size_t StepCount() const { return stepCount; }
+
+		/**
+		* @brief Valor de t no passo dado.
+		* @param[in] step Índice do passo (entrada)
+		*/
+		double Time(std::size_t step) const { return Record(step)[0]; }
+
+		/**
+		* @brief Ponteiro para os SystemSize() valores de u no passo dado.
+		* Válido enquanto o leitor existir.
+		* @param[in] step Índice do passo (entrada)
+		*/
+		const double* State(std::size_t step) const { return Record(step) + 1; }
+
+	private:
+		const double* Record(std::size_t step) const {
+			return records + step * (systemSize + 1);
+		}
+
+		MappedFile file;
+		const double* records;
+		std::size_t systemSize, stepCount;
+	};
+}